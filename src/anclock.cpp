@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2022-2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "anclock.h"
+#include "fixedp.h"
+#include "common.h"
+
+#define QUARTER (ANCLOCK_POSITIONS / 4)
+#define TICK_EVERY 5
+
+AnClock::point_t
+    AnClock::minute_hand_arr[ANCLOCK_POSITIONS],
+    AnClock::hour_hand_arr[ANCLOCK_POSITIONS],
+    AnClock::tick_outer_arr[ANCLOCK_POSITIONS / TICK_EVERY],
+    AnClock::tick_inner_arr[ANCLOCK_POSITIONS / TICK_EVERY];
+
+byte_t
+    AnClock::rim_outer_halfw[ANCLOCK_RADIUS + 1],
+    AnClock::rim_inner_halfw[ANCLOCK_RIM_INNER + 1];
+
+static signed char
+    scaled(Fixedp const unit, int length)   // rounded, unit >= 0
+{
+    Fixedp::fixedp_t raw = (Fixedp((long)length) * unit).rawvalue;
+
+    return (signed char)((raw + (1l << (SCALE - 1))) >> SCALE);
+}
+
+void AnClock::mirror(
+    point_t * const arr,
+    unsigned int quarter,       // positions in a quarter of the face
+    unsigned int pos,           // within the first quarter
+    signed char s,
+    signed char c)
+{
+    // 12 to 3 o'clock computed, the other three quarters rotated from it
+    arr[pos].x = s;
+    arr[pos].y = -c;
+    arr[pos + quarter].x = c;
+    arr[pos + quarter].y = s;
+    arr[pos + 2 * quarter].x = -s;
+    arr[pos + 2 * quarter].y = c;
+    arr[pos + 3 * quarter].x = -c;
+    arr[pos + 3 * quarter].y = -s;
+}
+
+static byte_t
+    halfwidth(int radius, int dy)
+{
+    // widest row of the disc, a half pixel of radius let out for roundness
+    int halfw = radius;
+
+    while (halfw * halfw + dy * dy > radius * radius + radius)
+        halfw--;
+
+    return halfw;
+}
+
+AnClock::AnClock(
+    Graph::window_arrangement_t const window_arrangement)
+{
+    geometry_prep();
+    set_window_arrangement(window_arrangement);
+}
+
+void AnClock::geometry_prep(void)
+{
+    /*
+     * Hand and tick endpoints for all the positions, once; the trig
+     * is only needed for the first quarter, 15 sines and cosines
+     */
+    Fixedp const pi_fixedp (FIXEDP_PI_RAW, TRUE);
+    Fixedp const step_fixedp =
+        Fixedp(2l) * pi_fixedp / (long)ANCLOCK_POSITIONS;
+    Fixedp const halfpi_fixedp =
+        pi_fixedp / 2l;
+
+    for (unsigned int pos = 0; pos < QUARTER; pos++)
+    {
+        Fixedp angle_fixedp = step_fixedp * (long)pos;
+        Fixedp sin_fixedp = Fixedp::quasisin_fixedp(angle_fixedp);
+        Fixedp cos_fixedp = Fixedp::quasisin_fixedp(angle_fixedp + halfpi_fixedp);
+
+        mirror(minute_hand_arr, QUARTER, pos,
+            scaled(sin_fixedp, ANCLOCK_MINUTE_HAND),
+            scaled(cos_fixedp, ANCLOCK_MINUTE_HAND));
+        mirror(hour_hand_arr, QUARTER, pos,
+            scaled(sin_fixedp, ANCLOCK_HOUR_HAND),
+            scaled(cos_fixedp, ANCLOCK_HOUR_HAND));
+
+        if (pos % TICK_EVERY)
+            continue;
+
+        mirror(tick_outer_arr, QUARTER / TICK_EVERY, pos / TICK_EVERY,
+            scaled(sin_fixedp, ANCLOCK_TICK_OUTER),
+            scaled(cos_fixedp, ANCLOCK_TICK_OUTER));
+        mirror(tick_inner_arr, QUARTER / TICK_EVERY, pos / TICK_EVERY,
+            scaled(sin_fixedp, ANCLOCK_TICK_INNER),
+            scaled(cos_fixedp, ANCLOCK_TICK_INNER));
+    }
+
+    for (int dy = 0; dy <= ANCLOCK_RADIUS; dy++)
+        rim_outer_halfw[dy] = halfwidth(ANCLOCK_RADIUS, dy);
+    for (int dy = 0; dy <= ANCLOCK_RIM_INNER; dy++)
+        rim_inner_halfw[dy] = halfwidth(ANCLOCK_RIM_INNER, dy);
+}
+
+void AnClock::set_window_arrangement(
+    Graph::window_arrangement_t const window_arrangement)
+{
+    if (window_arrangement == Graph::DGCLOCK_LEFT_ANIM_RIGHT)
+    {
+        x_center = ANCLOCK_X_CENTER;
+    }
+    else if (window_arrangement == Graph::DGCLOCK_RIGHT_ANIM_LEFT)
+    {
+        x_center = DGCLOCK_X_OFFS_MAX + ANCLOCK_X_CENTER;
+    }
+
+    drawn_minute_pos = 0xff;    // moved, all to redraw
+    drawn_hour_pos = 0xff;
+}
+
+byte_t AnClock::minute_pos(Timer::time_digits_t const & time_digits)
+{
+    return
+        time_digits.digit.minute_tens * 10 + time_digits.digit.minute_ones;
+}
+
+byte_t AnClock::hour_pos(Timer::time_digits_t const & time_digits)
+{
+    // the hour hand creeps on every 12 minutes
+    return
+        (time_digits.digit.hour_tens * 10 + time_digits.digit.hour_ones) % 12 *
+            (ANCLOCK_POSITIONS / 12) +
+        minute_pos(time_digits) / (ANCLOCK_POSITIONS / 5);
+}
+
+void AnClock::draw_face(void)
+{
+    // disc cleared with a rim around it, spans a row
+    for (int dy = -ANCLOCK_RADIUS; dy <= ANCLOCK_RADIUS; dy++)
+    {
+        int dy_abs = dy < 0 ? -dy : dy;
+        int y = ANCLOCK_Y_CENTER + dy;
+        int outer = rim_outer_halfw[dy_abs];
+
+        if (dy_abs > ANCLOCK_RIM_INNER)
+        {
+            Graph::span(x_center - outer, x_center + outer, y, TRUE);
+            continue;
+        }
+
+        int inner = rim_inner_halfw[dy_abs];
+
+        Graph::span(x_center - outer, x_center - inner - 1, y, TRUE);
+        Graph::span(x_center - inner, x_center + inner, y, FALSE);
+        Graph::span(x_center + inner + 1, x_center + outer, y, TRUE);
+    }
+
+    for (int tick = 0; tick < ANCLOCK_POSITIONS / TICK_EVERY; tick++)
+        Graph::line(
+            x_center + tick_inner_arr[tick].x,
+            ANCLOCK_Y_CENTER + tick_inner_arr[tick].y,
+            x_center + tick_outer_arr[tick].x,
+            ANCLOCK_Y_CENTER + tick_outer_arr[tick].y,
+            Graph::PIX_SET);
+}
+
+void AnClock::extend_rect(
+    rect_t & const rect,
+    int x0, int y0,
+    int x1, int y1)
+{
+    rect.x_first = MIN(rect.x_first, MIN(x0, x1));
+    rect.x_last = MAX(rect.x_last, MAX(x0, x1));
+    rect.y_first = MIN(rect.y_first, MIN(y0, y1));
+    rect.y_last = MAX(rect.y_last, MAX(y0, y1));
+}
+
+void AnClock::draw_hand(
+    point_t const & end,
+    unsigned int thick,
+    unsigned int pixop,
+    rect_t & const rect)
+{
+    int x0 = x_center;
+    int y0 = ANCLOCK_Y_CENTER;
+    int x1 = x_center + end.x;
+    int y1 = ANCLOCK_Y_CENTER + end.y;
+
+    Graph::line(x0, y0, x1, y1, pixop);
+    extend_rect(rect, x0, y0, x1, y1);
+
+    if (thick)  // second line alongside, shifted across the hand
+    {
+        if ((end.x < 0 ? -end.x : end.x) > (end.y < 0 ? -end.y : end.y))
+        {
+            y0++;
+            y1++;
+        }
+        else
+        {
+            x0++;
+            x1++;
+        }
+        Graph::line(x0, y0, x1, y1, pixop);
+        extend_rect(rect, x0, y0, x1, y1);   // both lines' tips
+    }
+}
+
+void AnClock::draw(Timer::time_digits_t const & time_digits)
+{
+    rect_t rect = {
+        x_center, x_center, ANCLOCK_Y_CENTER, ANCLOCK_Y_CENTER };
+
+    draw_face();
+
+    drawn_minute_pos = minute_pos(time_digits);
+    drawn_hour_pos = hour_pos(time_digits);
+
+    draw_hand(hour_hand_arr[drawn_hour_pos], TRUE, Graph::PIX_SET, rect);
+    draw_hand(minute_hand_arr[drawn_minute_pos], FALSE, Graph::PIX_SET, rect);
+}
+
+unsigned int AnClock::draw_changed(
+    Timer::time_digits_t const & time_digits,
+    unsigned int & const first_row,
+    unsigned int & const nrows,
+    unsigned int & const first_col_b,
+    unsigned int & const ncols_b)
+{
+    /*
+     * Hands moved since drawn: the old ones erased, the new ones drawn,
+     * the face left as is; the rectangle spanning them is to be copied,
+     * a few dozen bytes. FALSE if the hands stay.
+     */
+    byte_t new_minute_pos = minute_pos(time_digits);
+    byte_t new_hour_pos = hour_pos(time_digits);
+    rect_t rect = {
+        x_center, x_center, ANCLOCK_Y_CENTER, ANCLOCK_Y_CENTER };
+
+    if (drawn_minute_pos == 0xff)
+    {
+        draw(time_digits);
+
+        rect.x_first = x_center - ANCLOCK_RADIUS;
+        rect.x_last = x_center + ANCLOCK_RADIUS;
+        rect.y_first = ANCLOCK_Y_CENTER - ANCLOCK_RADIUS;
+        rect.y_last = ANCLOCK_Y_CENTER + ANCLOCK_RADIUS;
+    }
+    else
+    {
+        if (new_minute_pos == drawn_minute_pos &&
+            new_hour_pos == drawn_hour_pos)
+            return FALSE;
+
+        draw_hand(minute_hand_arr[drawn_minute_pos], FALSE,
+            Graph::PIX_CLEAR, rect);
+        if (new_hour_pos != drawn_hour_pos)
+            draw_hand(hour_hand_arr[drawn_hour_pos], TRUE,
+                Graph::PIX_CLEAR, rect);
+
+        // hour hand drawn anyway, the erased minute hand crossed it
+        draw_hand(hour_hand_arr[new_hour_pos], TRUE, Graph::PIX_SET, rect);
+        draw_hand(minute_hand_arr[new_minute_pos], FALSE,
+            Graph::PIX_SET, rect);
+
+        drawn_minute_pos = new_minute_pos;
+        drawn_hour_pos = new_hour_pos;
+    }
+
+    first_row = rect.y_first;
+    nrows = rect.y_last - rect.y_first + 1;
+    first_col_b = rect.x_first / BITS_PER_BYTE;
+    ncols_b = rect.x_last / BITS_PER_BYTE - first_col_b + 1;
+
+    return TRUE;
+}
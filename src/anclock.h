@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2022-2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Analog clock face, drawn in place of the digital clock
+ */
+
+#ifndef _ANCLOCK_H
+#define _ANCLOCK_H 1
+
+#include "graph.h"
+#include "timer.h"
+
+#define ANCLOCK_POSITIONS 60    // minute marks around the face
+#define ANCLOCK_RADIUS 29
+#define ANCLOCK_RIM_INNER 27
+#define ANCLOCK_TICK_OUTER 25
+#define ANCLOCK_TICK_INNER 22
+#define ANCLOCK_MINUTE_HAND 21
+#define ANCLOCK_HOUR_HAND 14
+
+// centered in the window the digital clock takes
+#define ANCLOCK_X_CENTER ((4 * FNTDATA_DIGIT_WIDTH + FNTDATA_COLON_WIDTH) / 2)
+#define ANCLOCK_Y_CENTER (GRAPH_Y_OFFS + FNTDATA_HEIGHT / 2)
+
+class AnClock
+{
+    struct point_t {            // relative to the center, y down
+        signed char x;
+        signed char y;
+    };
+
+    struct rect_t {
+        int x_first, x_last;
+        int y_first, y_last;
+    };
+
+    int
+        x_center;
+    byte_t
+        drawn_minute_pos,       // 0xff not drawn yet
+        drawn_hour_pos;
+
+    static point_t
+        minute_hand_arr[ANCLOCK_POSITIONS],
+        hour_hand_arr[ANCLOCK_POSITIONS],
+        tick_outer_arr[ANCLOCK_POSITIONS / 5],
+        tick_inner_arr[ANCLOCK_POSITIONS / 5];
+    static byte_t
+        rim_outer_halfw[ANCLOCK_RADIUS + 1],
+        rim_inner_halfw[ANCLOCK_RIM_INNER + 1];
+
+    static void
+        mirror(point_t * const, unsigned int, unsigned int, signed char, signed char);
+    void
+        geometry_prep(void);
+    void
+        draw_face(void);
+    static void
+        extend_rect(rect_t & const, int, int, int, int);   // x0, y0, x1, y1
+    void
+        draw_hand(point_t const &, unsigned int, unsigned int, rect_t & const);
+    static byte_t
+        minute_pos(Timer::time_digits_t const &);
+    static byte_t
+        hour_pos(Timer::time_digits_t const &);
+public:
+    AnClock(
+        Graph::window_arrangement_t const);
+
+    void
+        set_window_arrangement(
+            Graph::window_arrangement_t const);
+    void
+        draw(
+            Timer::time_digits_t const &);
+    unsigned int
+        draw_changed(
+            Timer::time_digits_t const &,
+            unsigned int & const,
+            unsigned int & const,
+            unsigned int & const,
+            unsigned int & const);
+};
+
+#endif
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "arena.h"
+
+Arena
+    arena;
+
+void * Arena::alloc(size_t size)
+{
+    // keep the next object aligned
+    size = (size + sizeof(arena_unit_t) - 1) & ~(sizeof(arena_unit_t) - 1);
+
+    if (size > sizeof pool - used)
+        return NULL;
+
+    void * p = (char *) pool + used;
+
+    used += size;
+    if (used > peak)
+        peak = used;
+
+    return p;
+}
+
+unsigned int Arena::mark(void) const
+{
+    return used;
+}
+
+void Arena::release(unsigned int mark)
+{
+    if (mark < used)
+        used = mark;
+}
+
+unsigned int Arena::get_used(void) const
+{
+    return used;
+}
+
+unsigned int Arena::get_peak(void) const
+{
+    return peak;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Static arena for the long-lived objects
+ *
+ * Bump allocator over a fixed block in the data segment. Objects are
+ * placed with new (arena) T(...) and never freed one by one, release()
+ * rewinds to an earlier mark. No plain new / delete anywhere, so
+ * malloc stays out of the link and the memory use is known up front.
+ */
+
+#ifndef _ARENA_H
+#define _ARENA_H 1
+
+#include <stddef.h>
+
+/*
+ * Bytes per use, the budget is checked against the objects at build time
+ * in pfwallcl.cpp
+ */
+#ifndef HOSTSIM
+#define ARENA_SCALE 1
+typedef unsigned int arena_unit_t;  // word aligned
+#else // #ifdef HOSTSIM
+#define ARENA_SCALE 4           // ints and pointers are wider on the host
+typedef void * arena_unit_t;        // pointer aligned
+#endif
+
+#define ARENA_SIZE_MAIN (1024 * ARENA_SCALE)    // configuration, timer, screen & scheduler state
+
+#ifdef TELEMETRY
+#define ARENA_SIZE_TLM (1024 * ARENA_SCALE)     // telemetry ring
+#else
+#define ARENA_SIZE_TLM 0
+#endif
+
+#ifdef TESTS
+#define ARENA_SIZE_TESTS (768 * ARENA_SCALE)    // one test configuration at a time
+#else
+#define ARENA_SIZE_TESTS 0
+#endif
+
+#define ARENA_SIZE (ARENA_SIZE_MAIN + ARENA_SIZE_TLM + ARENA_SIZE_TESTS)
+
+class Arena
+{
+    arena_unit_t
+        pool[ARENA_SIZE / sizeof(arena_unit_t)];
+    unsigned int
+        used,
+        peak;
+
+public:
+    // no constructor, a static instance is zeroed before main()
+
+    void *
+        alloc(size_t);
+    unsigned int
+        mark(void) const;
+    void
+        release(unsigned int);
+    unsigned int
+        get_used(void) const;
+    unsigned int
+        get_peak(void) const;
+};
+
+extern Arena
+    arena;
+
+/*
+ * NULL once the arena is full, the new-expression is then NULL with no
+ * constructor run, and the callers test for it. Standard C++ promises
+ * that only for an operator new declared not to throw; Borland C++ 3.1
+ * has no exceptions and always tests.
+ */
+#ifndef HOSTSIM
+#define ARENA_NOTHROW
+#else // #ifdef HOSTSIM
+#define ARENA_NOTHROW throw()
+#endif
+
+inline void *
+    operator new(size_t size, Arena & const arena) ARENA_NOTHROW
+{
+    return arena.alloc(size);
+}
+
+#endif
@@ -0,0 +1,343 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "bench.h"
+#include "graph.h"
+#include "dgclock.h"
+#include "dither.h"
+#include "fixedp.h"
+#include "monoclk.h"
+#include "toneseq.h"
+#include "critsec.h"
+#include "txtline.h"
+
+#include <dos.h>
+#include <io.h>
+#include <conio.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+char const * const
+    Bench::results_filename = "PFWALLCL.BEN";
+
+char const * const
+    Bench::item_names[ITEMS_NUM] = {
+        "ANIM_SWEEP",
+        "ANIM_FRAME",
+        "CANVAS_FRAME",
+        "LIFE_GEN",
+        "WIRE_FRAME",
+        "DGCLOCK_DRAW",
+        "VRAM_COPY",
+        "WIN_PRESENT",
+        "FIXEDP_MUL",
+        "FIXEDP_DIV",
+        "FIXEDP_SIN",
+        "TONE_IDLE",
+        "TONE_PLAY"
+    };
+
+Bench::result_t
+    Bench::results[ITEMS_NUM];
+
+static Fixedp
+    operands_a[BENCH_FIXEDP_OPERANDS],
+    operands_b[BENCH_FIXEDP_OPERANDS];
+
+static Fixedp::fixedp_t volatile
+    sink;                       // results go somewhere
+
+static unsigned long
+    spins_per_tick;             // of spin_to_tick(), a whole period
+static unsigned long
+    tick_period_us;
+static unsigned long
+    phase_start_us;
+
+static unsigned long
+    spin_to_tick(void)
+{
+    unsigned long spins = 0;
+    unsigned long us = MonoClock::now_us();
+
+    while (MonoClock::now_us() == us)
+    {
+        kbhit();                // keeps the Portfolio from powering off
+        spins++;
+    }
+
+    return spins;
+}
+
+static void
+    calibrate(void)
+{
+    spin_to_tick();
+    unsigned long start_us = MonoClock::now_us();
+    spins_per_tick = spin_to_tick();
+    spins_per_tick = MAX(spins_per_tick, 1);
+    tick_period_us = MonoClock::now_us() - start_us;
+}
+
+static void
+    begin_phase(void)
+{
+    spin_to_tick();
+    phase_start_us = MonoClock::now_us();
+}
+
+static unsigned long
+    end_phase(void)
+{
+    /*
+     * The clock moves a tick at a time: the phase starts on a tick,
+     * and the part of the last tick it didn't use is what spinning on
+     * to the next one takes, in shares of a whole tick's spins.
+     */
+    unsigned long spins = spin_to_tick();
+    unsigned long permille = MIN(spins, spins_per_tick) * 1000 /
+        spins_per_tick;
+
+    return MonoClock::now_us() - phase_start_us -
+        permille * (tick_period_us / 1000);
+}
+
+static void
+    add_time(Bench::result_t & const result,
+        unsigned long const us, unsigned long const items)
+{
+    result.total_us += us;
+    result.items += items;
+}
+
+// anim_prep() and the frames till done, of the engine's sweeps
+static void
+    run_sweeps(Graph & const graph, Graph::anim_engine_t const engine,
+        Bench::result_t & const frame_result,
+        Bench::result_t * const sweep_result)
+{
+    unsigned long frames = 0;
+
+    srand(BENCH_SEED);          // same sweeps for every engine, canvas or not
+    begin_phase();
+
+    for (unsigned int sweep = 0; sweep < BENCH_ANIM_SWEEPS; sweep++)
+    {
+        graph.anim_prep(engine);
+        frames++;
+
+        while (!graph.animate_finished())
+            frames++;
+    }
+
+    unsigned long sweeps_us = end_phase();
+
+    // the same anim_prep() calls on their own, the frames are the rest
+    srand(BENCH_SEED);
+    begin_phase();
+
+    for (unsigned int sweep = 0; sweep < BENCH_ANIM_SWEEPS; sweep++)
+        graph.anim_prep(engine);
+
+    unsigned long prep_us = end_phase();
+
+    add_time(frame_result,
+        sweeps_us > prep_us ? sweeps_us - prep_us : 0, frames);
+    if (sweep_result)
+        add_time(* sweep_result, sweeps_us, BENCH_ANIM_SWEEPS);
+}
+
+void Bench::run_anim(Graph & const graph)
+{
+    run_sweeps(graph, Graph::ANIM_SINE,
+        results[ITEM_ANIM_FRAME], & results[ITEM_ANIM_SWEEP]);
+
+    graph.set_anim_canvas(TRUE);
+    run_sweeps(graph, Graph::ANIM_SINE, results[ITEM_CANVAS_FRAME], NULL);
+    graph.set_anim_canvas(FALSE);
+
+    run_sweeps(graph, Graph::ANIM_LIFE, results[ITEM_LIFE_GEN], NULL);
+    run_sweeps(graph, Graph::ANIM_WIRE, results[ITEM_WIRE_FRAME], NULL);
+}
+
+void Bench::run_dgclock(DgClock & const dgclock)
+{
+    Timer::time_digits_t time_digits;
+
+    begin_phase();
+
+    for (unsigned int day_min = 0; day_min < MINUTES_PER_DAY; day_min++)
+    {
+        time_digits.digit.hour_tens = day_min / 60 / 10;
+        time_digits.digit.hour_ones = day_min / 60 % 10;
+        time_digits.digit.minute_tens = day_min % 60 / 10;
+        time_digits.digit.minute_ones = day_min % 60 % 10;
+
+        dgclock.draw(time_digits);
+    }
+
+    add_time(results[ITEM_DGCLOCK_DRAW], end_phase(), MINUTES_PER_DAY);
+}
+
+void Bench::run_vram(Graph & const graph)
+{
+    unsigned int frame;
+
+    begin_phase();
+
+    for (frame = 0; frame < BENCH_VRAM_FRAMES; frame++)
+        graph.vram_copy();
+
+    add_time(results[ITEM_VRAM_COPY], end_phase(), BENCH_VRAM_FRAMES);
+
+    Dither::start();
+    begin_phase();
+
+    for (frame = 0; frame < BENCH_VRAM_FRAMES; frame++)
+        Dither::present(graph.get_animw_x_offs(), TRUE);
+
+    add_time(results[ITEM_WIN_PRESENT], end_phase(), BENCH_VRAM_FRAMES);
+}
+
+void Bench::run_fixedp(void)
+{
+    unsigned int pass, i;
+    unsigned long const ops =
+        (unsigned long)BENCH_FIXEDP_PASSES * BENCH_FIXEDP_OPERANDS;
+
+    // -1 .. 1 for the factors, 1/128 .. 2 for the divisors,
+    // 3 times those, up to 6 rad, for the sine
+    for (i = 0; i < BENCH_FIXEDP_OPERANDS; i++)
+    {
+        operands_a[i].rawvalue =
+            ((Fixedp::fixedp_t)(rand() & 0x7fff) - 0x4000) << (SCALE - 14);
+        operands_b[i].rawvalue =
+            ((Fixedp::fixedp_t)(rand() & 0x7fff) | 0x80) << (SCALE - 14);
+    }
+
+    begin_phase();
+    for (pass = 0; pass < BENCH_FIXEDP_PASSES; pass++)
+        for (i = 0; i < BENCH_FIXEDP_OPERANDS; i++)
+            sink = (operands_a[i] * operands_b[i]).rawvalue;
+    add_time(results[ITEM_FIXEDP_MUL], end_phase(), ops);
+
+    begin_phase();
+    for (pass = 0; pass < BENCH_FIXEDP_PASSES; pass++)
+        for (i = 0; i < BENCH_FIXEDP_OPERANDS; i++)
+            sink = (operands_a[i] / operands_b[i]).rawvalue;
+    add_time(results[ITEM_FIXEDP_DIV], end_phase(), ops);
+
+    begin_phase();
+    for (pass = 0; pass < BENCH_FIXEDP_PASSES; pass++)
+        for (i = 0; i < BENCH_FIXEDP_OPERANDS; i++)
+            sink = Fixedp::quasisin_fixedp(
+                Fixedp(operands_b[i].rawvalue * 3, TRUE)).rawvalue;
+    add_time(results[ITEM_FIXEDP_SIN], end_phase(), ops);
+}
+
+// what the tick handler costs a tick for the notes; step() is called
+// with interrupts masked, as in the handler, so that a tick coming in
+// doesn't step the same queue
+void Bench::run_toneseq(void)
+{
+    unsigned int i;
+    unsigned long steps = 0;
+
+    begin_phase();
+    for (i = 0; i < BENCH_TONE_STEPS; i++)
+    {
+        CritSection critsec;
+
+        ToneSeq::step();
+    }
+    add_time(results[ITEM_TONE_IDLE], end_phase(), BENCH_TONE_STEPS);
+
+    // rests, silent; the queueing is in the time, over the note's steps
+    begin_phase();
+    for (unsigned int pass = 0; pass < BENCH_TONE_PASSES; pass++)
+    {
+        for (i = 0; i < TONESEQ_QUEUE_SIZE - 1; i++)    // a full queue
+            ToneSeq::queue_note(TONESEQ_REST, BENCH_TONE_TICKS);
+
+        while (ToneSeq::is_playing())
+        {
+            CritSection critsec;
+
+            ToneSeq::step();
+            steps++;
+        }
+    }
+    add_time(results[ITEM_TONE_PLAY], end_phase(), steps);
+}
+
+void Bench::run(
+    Graph & const graph,
+    DgClock & const dgclock)
+{
+    memset(results, 0, sizeof results);
+    calibrate();
+
+    graph.cls_withzigzag();
+    run_anim(graph);
+    run_dgclock(dgclock);
+    run_vram(graph);
+    srand(BENCH_SEED);          // same operands every run
+    run_fixedp();
+    run_toneseq();
+}
+
+int Bench::write(int fd)
+{
+    int res = RET_SUCCESS;
+    char line[64];
+
+    strcpy(line, "BENCH " __DATE__ " " __TIME__ " build");
+    res |= TxtLine::write(fd, line, line + strlen(line));
+    strcpy(line, "ITEM              ITEMS   TOTAL US    US/ITEM");
+    res |= TxtLine::write(fd, line, line + strlen(line));
+
+    for (unsigned int i = 0; i < ITEMS_NUM; i++)
+    {
+        result_t const & const result = results[i];
+        char * s = line;
+
+        s = TxtLine::put_str(s, item_names[i], 12);
+        s = TxtLine::put_dec(s, result.items, 10);
+        s = TxtLine::put_dec(s, result.total_us, 10);
+        s = TxtLine::put_fract(s, result.total_us,
+            result.items ? result.items : 1, 10);
+        res |= TxtLine::write(fd, line, s);
+    }
+
+    return res;
+}
+
+int Bench::show(void)
+{
+    return write(TXTLINE_STDOUT);
+}
+
+int Bench::append(void)
+{
+    int fd;
+    int res;
+
+    if (_dos_open(results_filename, O_WRONLY, &fd) != 0 &&
+        _dos_creat(results_filename, _A_NORMAL, &fd) != 0)
+        return RET_FAILURE;
+
+    if (lseek(fd, 0l, SEEK_END) == -1l)
+        res = RET_FAILURE;
+    else
+        res = write(fd);
+
+    _dos_close(fd);
+
+    return res ? RET_FAILURE : RET_SUCCESS;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * On-device benchmark, `pfwallcl bench`
+ *
+ * A fixed, seeded workload of the drawing paths and the fixed point
+ * primitives, timed with the monotonic clock at the fast clockspeed.
+ * The clock moves a whole 1 s tick at a time, so each part of the
+ * workload starts on a tick, and the rest of the tick it ends in is
+ * measured by spinning on to the next one, against the spins of a
+ * whole tick. show() prints the time per item, append() adds the same
+ * lines to the results file, so that builds can be compared on the
+ * Portfolio itself.
+ */
+
+#ifndef _BENCH_H
+#define _BENCH_H 1
+
+#include "common.h"
+
+#define BENCH_SEED 1
+#define BENCH_ANIM_SWEEPS 4     // anim_prep() and animate_finished() till done,
+                                // per engine
+#define BENCH_VRAM_FRAMES 64
+#define BENCH_FIXEDP_OPERANDS 64
+#define BENCH_FIXEDP_PASSES 16  // over the operands
+#define BENCH_TONE_STEPS 1024   // ToneSeq::step() idle
+#define BENCH_TONE_PASSES 16    // of a full queue played out
+#define BENCH_TONE_TICKS 4      // per queued note
+
+class Graph;
+class DgClock;
+
+class Bench
+{
+public:
+    enum item_t {
+        ITEM_ANIM_SWEEP,
+        ITEM_ANIM_FRAME,        // animate_finished() calls of the sweeps
+        ITEM_CANVAS_FRAME,      // the same sweeps through ColCanvas
+        ITEM_LIFE_GEN,          // Game of Life generations, as many sweeps
+        ITEM_WIRE_FRAME,        // wireframe frames, as many sweeps
+        ITEM_DGCLOCK_DRAW,      // every minute of the day
+        ITEM_VRAM_COPY,
+        ITEM_WIN_PRESENT,     // Dither::present(), the window rows only
+        ITEM_FIXEDP_MUL,
+        ITEM_FIXEDP_DIV,
+        ITEM_FIXEDP_SIN,
+        ITEM_TONE_IDLE,         // ToneSeq::step(), nothing queued
+        ITEM_TONE_PLAY,         // the same, notes queued, rests
+        ITEMS_NUM
+    };
+
+    struct result_t {
+        unsigned long items;
+        unsigned long total_us;
+    };
+
+private:
+    static char const * const
+        results_filename;
+    static char const * const
+        item_names[ITEMS_NUM];
+
+    static result_t
+        results[ITEMS_NUM];
+
+    static void
+        run_anim(Graph & const);
+    static void
+        run_dgclock(DgClock & const);
+    static void
+        run_vram(Graph & const);
+    static void
+        run_fixedp(void);
+    static void
+        run_toneseq(void);
+    static int
+        write(int);
+
+public:
+    static void
+        run(Graph & const, DgClock & const);
+    static int
+        show(void);
+    static int
+        append(void);
+};
+
+#endif
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifdef BIOSTRACE
+
+#include "biostrc.h"
+#include "pit.h"
+#include "txtline.h"
+
+#include <dos.h>
+#include <io.h>
+#include <string.h>
+
+char const * const
+    BiosTrace::dump_filename = "PFWALLCL.BTR";
+
+BiosTrace::record_t
+    BiosTrace::ring[BTR_RING_RECORDS];
+unsigned int
+    BiosTrace::ring_head = 0;
+unsigned int
+    BiosTrace::ring_len = 0;
+
+BiosTrace::func_sum_t
+    BiosTrace::sums[BTR_MAX_FUNCS];
+unsigned int
+    BiosTrace::nsums = 0;
+
+unsigned int
+    BiosTrace::start_count = 0;
+
+void BiosTrace::begin(void)
+{
+    start_count = PitStopwatch::read_counter();
+}
+
+void BiosTrace::end(
+    byte_t intno,
+    unsigned int ax,
+    unsigned int bx,
+    unsigned int cx,
+    unsigned int dx)
+{
+    record_t record;
+
+    record.pit = (word_t)(start_count - PitStopwatch::read_counter()); // counts down
+    record.intno = intno;
+    record.fn = ax >> BITS_PER_BYTE;
+    record.ax = ax;
+    record.bx = bx;
+    record.cx = cx;
+    record.dx = dx;
+
+    ring[(ring_head + ring_len) % BTR_RING_RECORDS] = record;
+
+    if (ring_len < BTR_RING_RECORDS)
+        ring_len++;
+    else // overwrite the oldest
+        ring_head = (ring_head + 1) % BTR_RING_RECORDS;
+
+    add_sum(record);
+}
+
+void BiosTrace::add_sum(BiosTrace::record_t const & const record)
+{
+    unsigned int i;
+
+    for (i = 0; i < nsums; i++)
+        if (sums[i].intno == record.intno && sums[i].fn == record.fn)
+            break;
+
+    if (i == nsums)
+    {
+        if (nsums == BTR_MAX_FUNCS)
+            return;             // table full, not counted
+
+        sums[i].intno = record.intno;
+        sums[i].fn = record.fn;
+        sums[i].calls = 0;
+        sums[i].pit = 0;
+        nsums++;
+    }
+
+    sums[i].calls++;
+    sums[i].pit += record.pit;
+}
+
+int BiosTrace::dump(void)
+{
+    int fd;
+    int res = RET_SUCCESS;
+    char line[48];
+
+    if (_dos_creat(dump_filename, _A_NORMAL, &fd) != 0)
+        return RET_FAILURE;
+
+    strcpy(line, "INT FN      CALLS  PIT TOTAL PIT AVG");
+    res |= TxtLine::write(fd, line, line + strlen(line));
+
+    for (unsigned int i = 0; i < nsums; i++)
+    {
+        char * s = line;
+
+        s = TxtLine::put_hex(s, sums[i].intno, 2, 3);
+        s = TxtLine::put_hex(s, sums[i].fn, 2, 2);
+        s = TxtLine::put_dec(s, sums[i].calls, 10);
+        s = TxtLine::put_dec(s, sums[i].pit, 10);
+        s = TxtLine::put_dec(s, sums[i].pit / sums[i].calls, 7);
+        res |= TxtLine::write(fd, line, s);
+    }
+
+    strcpy(line, "");
+    res |= TxtLine::write(fd, line, line);
+    strcpy(line, "INT FN AX   BX   CX   DX      PIT");
+    res |= TxtLine::write(fd, line, line + strlen(line));
+
+    for (unsigned int n = 0; n < ring_len; n++)  // oldest first
+    {
+        record_t const & const record =
+            ring[(ring_head + n) % BTR_RING_RECORDS];
+        char * s = line;
+
+        s = TxtLine::put_hex(s, record.intno, 2, 3);
+        s = TxtLine::put_hex(s, record.fn, 2, 2);
+        s = TxtLine::put_hex(s, record.ax, 4, 4);
+        s = TxtLine::put_hex(s, record.bx, 4, 4);
+        s = TxtLine::put_hex(s, record.cx, 4, 4);
+        s = TxtLine::put_hex(s, record.dx, 4, 4);
+        s = TxtLine::put_dec(s, record.pit, 6);
+        res |= TxtLine::write(fd, line, s);
+    }
+
+    _dos_close(fd);
+
+    return res ? RET_FAILURE : RET_SUCCESS;
+}
+
+#endif
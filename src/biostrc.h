@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * BIOS call tracer, BIOSTRACE builds only
+ *
+ * PFBios brackets its interrupt calls with begin() / end(): each call
+ * goes into a ring of the last ones (registers in, PIT counts taken)
+ * and into a per function count and total. dump() writes both out
+ * as text.
+ */
+
+#ifndef _BIOSTRC_H
+#define _BIOSTRC_H 1
+
+#include "common.h"
+
+#define BTR_RING_RECORDS 32
+#define BTR_MAX_FUNCS 16        // distinct interrupt / AH pairs
+
+class BiosTrace
+{
+public:
+    struct record_t {
+        byte_t intno;
+        byte_t fn;              // AH on entry
+        unsigned int ax, bx, cx, dx;    // on entry
+        unsigned int pit;       // duration, modulo a counter wrap (~55 ms)
+    };
+
+    struct func_sum_t {
+        byte_t intno;
+        byte_t fn;
+        unsigned long calls;
+        unsigned long pit;
+    };
+
+private:
+    static char const * const
+        dump_filename;
+
+    static record_t
+        ring[BTR_RING_RECORDS];
+    static unsigned int
+        ring_head,
+        ring_len;
+
+    static func_sum_t
+        sums[BTR_MAX_FUNCS];
+    static unsigned int
+        nsums;
+
+    static unsigned int
+        start_count;
+
+    static void
+        add_sum(record_t const & const);
+
+public:
+    static void
+        begin(void);
+    static void
+        end(byte_t,
+            unsigned int, unsigned int, unsigned int, unsigned int);
+    static int
+        dump(void);
+};
+
+#endif
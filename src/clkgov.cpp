@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2022-2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "clkgov.h"
+#include "txtline.h"
+
+#include <string.h>
+
+#ifdef NTVDM
+#include <iostream.h>
+#endif
+
+// Timer's clock is monotonic, still an earlier now reads as no time
+// rather than wrapping to days of it
+static unsigned long
+    elapsed_sec(unsigned long const now_sec, unsigned long const since_sec)
+{
+    return now_sec > since_sec ? now_sec - since_sec : 0;
+}
+
+ClkGovernor::ClkGovernor(
+    PFBios::clockspeed_t const clockspeed,
+    unsigned long now_sec) :
+    mode(MODE_AUTO),
+    clockspeed(clockspeed),
+    was_busy(FALSE),
+    idle_since_sec(now_sec),
+    clockspeed_since_sec(now_sec)
+{
+    for (int i = 0; i < CLKGOV_NUM_CLOCKSPEEDS; i++)
+        time_in_clockspeed_sec[i] = 0;
+}
+
+unsigned int ClkGovernor::switch_clockspeed(
+    PFBios::clockspeed_t const new_clockspeed,
+    unsigned long now_sec)
+{
+    if (new_clockspeed == clockspeed)
+        return FALSE;
+
+    time_in_clockspeed_sec[clockspeed] +=
+        elapsed_sec(now_sec, clockspeed_since_sec);
+    clockspeed_since_sec = now_sec;
+    clockspeed = new_clockspeed;
+
+#ifdef NTVDM
+    cout
+        << "ClkGovernor: Clockspeed "
+        << (unsigned int)clockspeed
+        << ", time in normal "
+        << time_in_clockspeed_sec[PFBios::clockspeed_normal]
+        << " s, fast "
+        << time_in_clockspeed_sec[PFBios::clockspeed_fast]
+        << " s.\n";
+#endif
+
+    return TRUE;
+}
+
+ClkGovernor::mode_t ClkGovernor::cycle_mode(unsigned long now_sec)
+{
+    /*
+     * Manual override: auto -> fast -> normal -> auto
+     */
+    if (mode == MODE_AUTO)
+    {
+        mode = MODE_FORCE_FAST;
+        switch_clockspeed(PFBios::clockspeed_fast, now_sec);
+    }
+    else if (mode == MODE_FORCE_FAST)
+    {
+        mode = MODE_FORCE_NORMAL;
+        switch_clockspeed(PFBios::clockspeed_normal, now_sec);
+    }
+    else
+    {
+        mode = MODE_AUTO;
+        was_busy = FALSE;
+        idle_since_sec = now_sec;
+    }
+
+    return mode;
+}
+
+unsigned int ClkGovernor::evaluate(
+    unsigned int busy,
+    unsigned int playing,
+    unsigned long now_sec)
+{
+    // a note lasts whole ticks, fast ones whatever the override
+    if (playing && mode != MODE_AUTO)
+        return switch_clockspeed(PFBios::clockspeed_fast, now_sec);
+
+    if (mode == MODE_FORCE_NORMAL)  // back once the notes are done
+        return switch_clockspeed(PFBios::clockspeed_normal, now_sec);
+
+    if (mode != MODE_AUTO)
+        return FALSE;
+
+    if (busy || playing)
+    {
+        was_busy = TRUE;
+        return switch_clockspeed(PFBios::clockspeed_fast, now_sec);
+    }
+
+    if (was_busy)   // just went idle
+    {
+        was_busy = FALSE;
+        idle_since_sec = now_sec;
+    }
+
+    // hysteresis, no flapping between short idle periods
+    if (elapsed_sec(now_sec, idle_since_sec) < CLKGOV_IDLE_HOLD_SEC)
+        return FALSE;
+
+    return switch_clockspeed(PFBios::clockspeed_normal, now_sec);
+}
+
+void ClkGovernor::leave_out(
+    unsigned long from_sec,
+    unsigned long to_sec)
+{
+    time_in_clockspeed_sec[clockspeed] +=
+        elapsed_sec(from_sec, clockspeed_since_sec);
+    clockspeed_since_sec = to_sec;
+}
+
+PFBios::clockspeed_t ClkGovernor::get_clockspeed(void) const
+{
+    return clockspeed;
+}
+
+unsigned long ClkGovernor::get_time_in_clockspeed_sec(
+    PFBios::clockspeed_t const of_clockspeed,
+    unsigned long now_sec) const
+{
+    unsigned long time_sec = time_in_clockspeed_sec[of_clockspeed];
+
+    if (of_clockspeed == clockspeed)
+        time_sec += elapsed_sec(now_sec, clockspeed_since_sec);
+
+    return time_sec;
+}
+
+int ClkGovernor::write(int fd, unsigned long now_sec) const
+{
+    int res = RET_SUCCESS;
+    char line[32];
+    char * s;
+
+    strcpy(line, "CLOCKSPEED    TIME S");
+    res |= TxtLine::write(fd, line, line + strlen(line));
+
+    s = TxtLine::put_str(line, "NORMAL", 9);
+    s = TxtLine::put_dec(s,
+        get_time_in_clockspeed_sec(PFBios::clockspeed_normal, now_sec), 10);
+    res |= TxtLine::write(fd, line, s);
+
+    s = TxtLine::put_str(line, "FAST", 9);
+    s = TxtLine::put_dec(s,
+        get_time_in_clockspeed_sec(PFBios::clockspeed_fast, now_sec), 10);
+    res |= TxtLine::write(fd, line, s);
+
+    return res ? RET_FAILURE : RET_SUCCESS;
+}
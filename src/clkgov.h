@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2022-2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Clockspeed governor
+ *
+ * Fast tick only while something on the screen needs it,
+ * normal (power saving) tick otherwise. Notes being played keep
+ * the fast tick even over a forced normal one. The time in each
+ * clockspeed is written out on exit and with the profile.
+ */
+
+#ifndef _CLKGOV_H
+#define _CLKGOV_H 1
+
+#include "pfbios.h"
+#include "common.h"
+
+#define CLKGOV_IDLE_HOLD_SEC 16 // stay fast this long after going idle
+
+#define CLKGOV_NUM_CLOCKSPEEDS 2
+
+class ClkGovernor
+{
+public:
+    enum mode_t {
+        MODE_AUTO,
+        MODE_FORCE_FAST,
+        MODE_FORCE_NORMAL,
+        };
+
+private:
+    mode_t
+        mode;
+    PFBios::clockspeed_t
+        clockspeed;
+    unsigned int
+        was_busy;
+    unsigned long
+        idle_since_sec,
+        clockspeed_since_sec;
+    unsigned long
+        time_in_clockspeed_sec[CLKGOV_NUM_CLOCKSPEEDS];
+
+    unsigned int
+        switch_clockspeed(PFBios::clockspeed_t const, unsigned long);
+
+public:
+    ClkGovernor(
+        PFBios::clockspeed_t const,
+        unsigned long);
+
+    mode_t
+        cycle_mode(unsigned long);
+    unsigned int
+        evaluate(unsigned int, unsigned int, unsigned long);  // busy, playing
+    void
+        leave_out(unsigned long, unsigned long);    // from, to: powered off
+    PFBios::clockspeed_t
+        get_clockspeed(void) const;
+    unsigned long
+        get_time_in_clockspeed_sec(
+            PFBios::clockspeed_t const,
+            unsigned long) const;
+    int
+        write(int, unsigned long) const;    // DOS handle, now
+};
+
+#endif
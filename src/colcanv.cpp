@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "colcanv.h"
+
+#include <mem.h>
+
+byte_t
+    ColCanvas::cols[ANIMW_WIDTH][COLCANVAS_HEIGHT_B];
+
+/*
+ * Rows of 8 bits in, columns out, the leftmost bit being bit 7 both
+ * ways: the 4 x 4 quadrants off the diagonal are swapped, then the
+ * 2 x 2 blocks within each quadrant, then the single bits.
+ */
+void ColCanvas::transpose(byte_t * const m)
+{
+    static byte_t const
+        masks[3] = { 0x0f, 0x33, 0x55 };
+
+    for (unsigned int stage = 0; stage < 3; stage++)
+    {
+        unsigned int const dist = 4 >> stage;
+        byte_t const mask = masks[stage];
+
+        for (unsigned int i = 0; i < BITS_PER_BYTE; i++)
+        {
+            if (i & dist)
+                continue;       // lower of the pair done
+
+            byte_t const t = (m[i] ^ m[i + dist] >> dist) & mask;
+
+            m[i] ^= t;
+            m[i + dist] ^= t << dist;
+        }
+    }
+}
+
+void ColCanvas::clear(void)
+{
+    memset(cols, 0, sizeof cols);
+}
+
+void ColCanvas::putpix(int x, int y)
+{
+    if (y < 0 || y >= ANIMW_HEIGHT)
+        return;
+
+    cols[x][y / BITS_PER_BYTE] |= 0x80 >> y % BITS_PER_BYTE;
+}
+
+void ColCanvas::present(int x_offs, int x_first, int x_last)
+{
+    byte_t block[BITS_PER_BYTE];
+
+    for (int col_b = x_first / BITS_PER_BYTE;
+        col_b <= x_last / BITS_PER_BYTE;
+        col_b++)
+    {
+        int const vram_col_b = x_offs / BITS_PER_BYTE + col_b;
+
+        for (unsigned int row_b = 0; row_b < COLCANVAS_HEIGHT_B; row_b++)
+        {
+            unsigned int const y_first = row_b * BITS_PER_BYTE;
+            unsigned int const nrows =
+                MIN(BITS_PER_BYTE, ANIMW_HEIGHT - y_first);
+
+            for (unsigned int c = 0; c < BITS_PER_BYTE; c++)
+                block[c] = cols[col_b * BITS_PER_BYTE + c][row_b];
+
+            transpose(block);
+
+            for (unsigned int r = 0; r < nrows; r++)
+                Graph::vram_row(GRAPH_Y_OFFS + y_first + r)[vram_col_b] =
+                    block[r];
+        }
+    }
+}
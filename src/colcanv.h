@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Column-major canvas of the animation window
+ *
+ * A byte holds 8 vertically adjacent pixels, the topmost in bit 7, and
+ * a column of the window is contiguous, so pixels going down a column
+ * land in the same or the next byte rather than a row of video RAM
+ * apart. present() turns 8 x 8 pixel blocks into the row-major video
+ * RAM by bit-matrix transposes, the columns given only.
+ */
+
+#ifndef _COLCANV_H
+#define _COLCANV_H 1
+
+#include "graph.h"
+
+#define COLCANVAS_HEIGHT_B ((ANIMW_HEIGHT + BITS_PER_BYTE - 1) / BITS_PER_BYTE)
+
+class ColCanvas
+{
+    static byte_t
+        cols[ANIMW_WIDTH][COLCANVAS_HEIGHT_B];
+
+    static void
+        transpose(byte_t * const);
+
+public:
+    static void
+        clear(void);
+    static void
+        putpix(int, int);       // within the window
+    static void
+        present(int, int, int); // window x, first and last column
+};
+
+#endif
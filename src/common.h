@@ -17,10 +17,18 @@
 #define BITS_PER_LONG 32
 #define MIN(a,b) ((a)<(b) ? (a) : (b))
 #define MAX(a,b) ((a)>(b) ? (a) : (b))
+#define MINUTES_PER_DAY 1440
+#define SECONDS_PER_MINUTE 60
+#define SECONDS_PER_DAY 86400l
 
 #define MIN_POFF_DELAY_ONKBHIT_MINUTES 4
 #define DEFAULT_POFF_DELAY_ONKBHIT_MINUTES 10
 
 typedef unsigned char byte_t;
+#ifndef HOSTSIM
+typedef unsigned int word_t;
+#else // #ifdef HOSTSIM
+typedef unsigned short word_t;  // int is 32 bits wide on the host
+#endif
 
 #endif
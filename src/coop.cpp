@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "coop.h"
+
+#include <assert.h>
+
+unsigned int
+    CoopSched::slice_steps = 0;
+unsigned int
+    CoopSched::slice_budget_steps = 0;
+
+CoopSched::CoopSched(
+    task_def_t const * const task_defs,
+    unsigned int tasks_num,
+    void * const tasks_ctx) :
+    task_defs(task_defs),
+    tasks_num(tasks_num),
+    tasks_ctx(tasks_ctx),
+    ready(0)
+{
+    assert(tasks_num <= COOP_TASKS_MAX);
+
+    for (unsigned int i = 0; i < tasks_num; i++)
+        pts[i].lc = 0;
+}
+
+void CoopSched::wake(unsigned int id)
+{
+    ready |= 1u << id;
+}
+
+unsigned int CoopSched::is_ready(unsigned int id) const
+{
+    return (ready >> id) & 1;
+}
+
+unsigned int CoopSched::run_next(void)
+{
+    for (unsigned int id = 0; id < tasks_num; id++)
+    {
+        if (!is_ready(id))
+            continue;
+
+        slice_steps = 0;
+        slice_budget_steps = task_defs[id].budget_steps;
+
+        if (task_defs[id].fn(tasks_ctx, pts[id]) == PT_ENDED)
+            ready &= ~(1u << id);
+
+        return TRUE;
+    }
+
+    return FALSE;   // nothing to run, the caller may halt
+}
+
+unsigned int CoopSched::is_slice_over(void)
+{
+    return slice_steps++ >= slice_budget_steps;
+}
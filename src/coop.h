@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Cooperative task scheduler, protothread style
+ *
+ * A task is a function resumed where it last yielded. PT_BEGIN() and
+ * PT_END() wrap its body, PT_YIELD() returns to the scheduler and the
+ * next slice continues right after it. The resume point is a case label
+ * of the line number, so no switch statement may enclose a yield and no
+ * local variable keeps its value across one.
+ *
+ * The task table order is the priority, run_next() gives one slice to
+ * the first task ready. A task is ready once woken and stays so while
+ * it yields, ending (or a plain return PT_ENDED) waits for a wake.
+ * A slice has a budget of steps, long work checks it between them with
+ * PT_YIELD_IF_OVER(). Steps rather than time: the clock only moves
+ * a whole tick, a second or more, at a time.
+ */
+
+#ifndef _COOP_H
+#define _COOP_H 1
+
+#include "common.h"
+
+#define COOP_TASKS_MAX 8
+
+#define PT_BEGIN(pt) \
+    switch ((pt).lc) { case 0:
+
+#define PT_YIELD(pt) \
+    do { \
+        (pt).lc = __LINE__; \
+        return CoopSched::PT_YIELDED; \
+        case __LINE__:; \
+    } while (0)
+
+#define PT_YIELD_IF_OVER(pt) \
+    do { \
+        if (CoopSched::is_slice_over()) \
+            PT_YIELD(pt); \
+    } while (0)
+
+#define PT_END(pt) \
+    } (pt).lc = 0; return CoopSched::PT_ENDED
+
+class CoopSched
+{
+public:
+    enum pt_state_t {
+        PT_YIELDED,
+        PT_ENDED
+    };
+
+    struct pt_t {
+        unsigned int lc;        // resume line, 0 at the start
+    };
+
+    typedef pt_state_t
+        (* task_fp_t)(void *, pt_t & const);
+
+    struct task_def_t {
+        task_fp_t fn;
+        unsigned int budget_steps;  // more per slice, 0 for a single one
+    };
+
+private:
+    task_def_t const * const
+        task_defs;              // indexed by task id, first runs first
+    unsigned int const
+        tasks_num;
+    void * const
+        tasks_ctx;
+
+    pt_t
+        pts[COOP_TASKS_MAX];
+    unsigned int
+        ready;                  // bit per task id
+
+    static unsigned int
+        slice_steps;            // checked so far
+    static unsigned int
+        slice_budget_steps;
+
+public:
+    CoopSched(
+        task_def_t const * const,
+        unsigned int,
+        void * const);
+
+    void
+        wake(unsigned int);
+    unsigned int
+        is_ready(unsigned int) const;
+    unsigned int
+        run_next(void);
+
+    static unsigned int
+        is_slice_over(void);
+};
+
+#endif
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2022-2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "critsec.h"
+
+CritSection::CritSection()
+{
+    unsigned int flags;
+
+#ifndef HOSTSIM
+    asm {
+        pushf
+        pop  flags
+        cli
+    }
+#else // #ifdef HOSTSIM
+    flags = 0;  // interrupts come only from the halt and kbhit() calls
+#endif
+
+    saved_flags = flags;
+}
+
+CritSection::~CritSection()
+{
+#ifndef HOSTSIM
+    unsigned int flags = saved_flags;
+
+    asm {
+        push flags
+        popf            // IF restored as it was, no unconditional sti
+    }
+#endif
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2022-2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Critical section guard
+ *
+ * Masks interrupts for the lifetime of the object and restores
+ * the interrupt flag as it was on entry (pushf/popf), so it nests
+ * and is safe to use where interrupts are already disabled.
+ */
+
+#ifndef _CRITSEC_H
+#define _CRITSEC_H 1
+
+class CritSection
+{
+    unsigned int
+        saved_flags;
+
+    CritSection(CritSection const &);       // not copyable
+    void
+        operator = (CritSection const &);
+
+public:
+    CritSection();
+    ~CritSection();
+};
+
+#endif
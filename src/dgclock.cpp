@@ -8,6 +8,8 @@
 #include "dgclock.h"
 #include "common.h"
 
+#include <mem.h>
+
 #define WE_USE_TEN_DIGITS 10
 
 struct digits_pixeldata_t {
@@ -17,7 +19,7 @@ struct digits_pixeldata_t {
                 [WE_USE_TEN_DIGITS]
                 [FNTDATA_HEIGHT]
                 [FNTDATA_DIGIT_WIDTH_B];
-        unsigned int
+        word_t
             arr_w
                 [WE_USE_TEN_DIGITS]
                 [FNTDATA_HEIGHT]
@@ -48,6 +50,9 @@ int const
         3 * FNTDATA_DIGIT_WIDTH_B + FNTDATA_COLON_WIDTH_B,
 };
 
+byte_t
+    DgClock::drawn_digit_arr[4] = { 0xff, 0xff, 0xff, 0xff };
+
 DgClock::DgClock(
     Graph::window_arrangement_t const window_arrangement) :
     initial_y_offs(GRAPH_Y_OFFS)
@@ -74,6 +79,7 @@ void DgClock::fnt_prep_raligned()
             regs.h.ah = digits_pixeldata_laligned.arr_b[digit][fntdata_row][2];
             regs.h.al = digits_pixeldata_laligned.arr_b[digit][fntdata_row][3];
 
+#ifndef HOSTSIM
             asm {
                 push ax
                 push bx
@@ -101,6 +107,14 @@ void DgClock::fnt_prep_raligned()
                 pop bx
                 pop ax
             }
+#else // #ifdef HOSTSIM
+            unsigned long dxax =
+                (unsigned long)regs.x.dx << BITS_PER_WORD | regs.x.ax;
+
+            dxax >>= regs.h.cl;
+            regs.x.dx = (word_t)(dxax >> BITS_PER_WORD);
+            regs.x.ax = (word_t)dxax;
+#endif
 
             digits_pixeldata_raligned.arr_b[digit][fntdata_row][0] = regs.h.dh;
             digits_pixeldata_raligned.arr_b[digit][fntdata_row][1] = regs.h.dl;
@@ -121,87 +135,91 @@ void DgClock::set_window_arrangement(
     {
         initial_x_offs = DGCLOCK_X_OFFS_MAX;
     }
+
+    memset(drawn_digit_arr, 0xff, sizeof drawn_digit_arr);  // moved, all to redraw
 }
 
-void DgClock::draw(Timer::time_digits_t const & time_digits)
+void DgClock::draw_digit(int clockdigit, byte_t digit)
 {
-    for (int clockdigit = 0; clockdigit < 4; clockdigit++)
-    {
-        int offs_x =
-            initial_x_offs / 8 +
-            offs_x_clockdigit_static[clockdigit];
+    int offs_x =
+        initial_x_offs / 8 +
+        offs_x_clockdigit_static[clockdigit];
 
-        for (int fntdata_row = 0; fntdata_row < FNTDATA_HEIGHT; fntdata_row++)
-        {
-            int offs_y =
-                initial_y_offs +
-                fntdata_row;
+    for (int fntdata_row = 0; fntdata_row < FNTDATA_HEIGHT; fntdata_row++)
+    {
+        int offs_y =
+            initial_y_offs +
+            fntdata_row;
 
-            if (clockdigit == 0 && time_digits.digit_arr[clockdigit] == 0) {
-                // empty (fill with 0's) if hour_tens == 0
+        if (clockdigit == 0 && digit == 0) {
+            // empty (fill with 0's) if hour_tens == 0
 #ifndef NTVDM
-                *(unsigned long far *)
-                    &(*Graph::vram_cga_evenscanlines.ptr_union.arr_b)[offs_y][offs_x] =
-                        0;
+            *(unsigned long far *)
+                &(*Graph::vram_cga_evenscanlines.ptr_union.arr_b)[offs_y][offs_x] =
+                    0;
 #else // #ifdef NTVDM
-                offs_y /= 2;
+            offs_y /= 2;
 
-                *(unsigned long far *)
-                    &(*Graph::vram_cga_evenscanlines.ptr_union.arr_b)[offs_y][offs_x] =
-                        0;
+            *(unsigned long far *)
+                &(*Graph::vram_cga_evenscanlines.ptr_union.arr_b)[offs_y][offs_x] =
+                    0;
 
-                *(unsigned long far *)
-                    &(*Graph::vram_cga_oddscanlines.ptr_union.arr_b)[offs_y][offs_x] =
-                        0;
+            *(unsigned long far *)
+                &(*Graph::vram_cga_oddscanlines.ptr_union.arr_b)[offs_y][offs_x] =
+                    0;
 #endif
-                continue;
-            }
+            continue;
+        }
 
-            if (clockdigit % 2)
-            {
+        if (clockdigit % 2)
+        {
 #ifndef NTVDM
-                *(unsigned long far *)
-                    &(*Graph::vram_cga_evenscanlines.ptr_union.arr_b)[offs_y][offs_x] =
-                        digits_pixeldata_laligned.arr_dw[time_digits.digit_arr[clockdigit]]
-                            [fntdata_row];
+            *(unsigned long far *)
+                &(*Graph::vram_cga_evenscanlines.ptr_union.arr_b)[offs_y][offs_x] =
+                    digits_pixeldata_laligned.arr_dw[digit]
+                        [fntdata_row];
 #else // #ifdef NTVDM
-                offs_y /= 2;
+            offs_y /= 2;
 
-                *(unsigned long far *)
-                    &(*Graph::vram_cga_evenscanlines.ptr_union.arr_b)[offs_y][offs_x] =
-                        digits_pixeldata_laligned.arr_dw[time_digits.digit_arr[clockdigit]]
-                            [fntdata_row];
+            *(unsigned long far *)
+                &(*Graph::vram_cga_evenscanlines.ptr_union.arr_b)[offs_y][offs_x] =
+                    digits_pixeldata_laligned.arr_dw[digit]
+                        [fntdata_row];
 
-                *(unsigned long far *)
-                    &(*Graph::vram_cga_oddscanlines.ptr_union.arr_b)[offs_y][offs_x] =
-                        digits_pixeldata_laligned.arr_dw[time_digits.digit_arr[clockdigit]]
-                            [++fntdata_row];
+            *(unsigned long far *)
+                &(*Graph::vram_cga_oddscanlines.ptr_union.arr_b)[offs_y][offs_x] =
+                    digits_pixeldata_laligned.arr_dw[digit]
+                        [++fntdata_row];
 #endif
-            }
-            else
-            {
+        }
+        else
+        {
 #ifndef NTVDM
-                *(unsigned long far *)
-                    &(*Graph::vram_cga_evenscanlines.ptr_union.arr_b)[offs_y][offs_x] =
-                        digits_pixeldata_raligned.arr_dw[time_digits.digit_arr[clockdigit]]
-                            [fntdata_row];
+            *(unsigned long far *)
+                &(*Graph::vram_cga_evenscanlines.ptr_union.arr_b)[offs_y][offs_x] =
+                    digits_pixeldata_raligned.arr_dw[digit]
+                        [fntdata_row];
 #else // #ifdef NTVDM
-                offs_y /= 2;
+            offs_y /= 2;
 
-                *(unsigned long far *)
-                    &(*Graph::vram_cga_evenscanlines.ptr_union.arr_b)[offs_y][offs_x] =
-                        digits_pixeldata_raligned.arr_dw[time_digits.digit_arr[clockdigit]]
-                            [fntdata_row];
+            *(unsigned long far *)
+                &(*Graph::vram_cga_evenscanlines.ptr_union.arr_b)[offs_y][offs_x] =
+                    digits_pixeldata_raligned.arr_dw[digit]
+                        [fntdata_row];
 
-                *(unsigned long far *)
-                    &(*Graph::vram_cga_oddscanlines.ptr_union.arr_b)[offs_y][offs_x] =
-                        digits_pixeldata_raligned.arr_dw[time_digits.digit_arr[clockdigit]]
-                            [++fntdata_row];
+            *(unsigned long far *)
+                &(*Graph::vram_cga_oddscanlines.ptr_union.arr_b)[offs_y][offs_x] =
+                    digits_pixeldata_raligned.arr_dw[digit]
+                        [++fntdata_row];
 #endif
-            }
         }
     }
 
+    drawn_digit_arr[clockdigit] = digit;
+}
+
+void DgClock::draw_colon(void)
+{
     int offs_x =
         initial_x_offs / 8 +
         2 * FNTDATA_DIGIT_WIDTH_B;
@@ -227,3 +245,54 @@ void DgClock::draw(Timer::time_digits_t const & time_digits)
 #endif
     }
 }
+
+void DgClock::draw(Timer::time_digits_t const & time_digits)
+{
+    for (int clockdigit = 0; clockdigit < 4; clockdigit++)
+        draw_digit(clockdigit, time_digits.digit_arr[clockdigit]);
+
+    draw_colon();
+}
+
+unsigned int DgClock::draw_changed(
+    Timer::time_digits_t const & time_digits,
+    unsigned int & const first_col_b,
+    unsigned int & const ncols_b)
+{
+    /*
+     * Only the digits differing from the ones in video RAM, e.g. after
+     * a power-off kept the frame; the byte columns from the first one
+     * redrawn to the end of the last one are to be copied. FALSE if none.
+     */
+    int first = -1;
+    int last = -1;
+
+    for (int clockdigit = 0; clockdigit < 4; clockdigit++)
+    {
+        if (drawn_digit_arr[clockdigit] == time_digits.digit_arr[clockdigit])
+            continue;
+
+        draw_digit(clockdigit, time_digits.digit_arr[clockdigit]);
+
+        if (first == -1)
+            first = clockdigit;
+        last = clockdigit;
+    }
+
+    if (first == -1)
+        return FALSE;
+
+    first_col_b =
+        initial_x_offs / 8 +
+        offs_x_clockdigit_static[first];
+    ncols_b =
+        offs_x_clockdigit_static[last] + FNTDATA_DIGIT_WIDTH_B -
+        offs_x_clockdigit_static[first];
+
+    return TRUE;
+}
+
+int DgClock::get_y_offs(void) const
+{
+    return initial_y_offs;
+}
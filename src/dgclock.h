@@ -18,8 +18,14 @@ class DgClock
         initial_y_offs;
     static int const
         offs_x_clockdigit_static[];
+    static byte_t
+        drawn_digit_arr[4];     // as in video RAM, 0xff not drawn yet
     void
         fnt_prep_raligned();
+    void
+        draw_digit(int, byte_t);
+    void
+        draw_colon(void);
 public:
     DgClock(
         Graph::window_arrangement_t const);
@@ -30,6 +36,13 @@ public:
     void
         draw(
             Timer::time_digits_t const &);
+    unsigned int
+        draw_changed(
+            Timer::time_digits_t const &,
+            unsigned int & const,
+            unsigned int & const);
+    int
+        get_y_offs(void) const;
 };
 
 #endif
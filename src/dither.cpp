@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "dither.h"
+
+#include <dos.h>
+#include <mem.h>
+
+byte_t
+    Dither::plane[ANIMW_HEIGHT][ANIMW_WIDTH_B];
+
+byte_t const
+    Dither::no_plane[ANIMW_WIDTH_B] = { 0 };
+
+byte_t
+    Dither::bitrev[256];
+
+unsigned int
+    Dither::presents = 0;
+
+void Dither::start(void)
+{
+    if (!bitrev[1])             // once
+    {
+        for (unsigned int b = 0; b < 256; b++)
+        {
+            byte_t r = 0;
+
+            for (unsigned int bit = 0; bit < BITS_PER_BYTE; bit++)
+                r |= (b >> bit & 1) << (BITS_PER_BYTE - 1 - bit);
+
+            bitrev[b] = r;
+        }
+    }
+
+    memset(plane, 0, sizeof plane);
+    presents = 0;
+}
+
+unsigned int Dither::is_frame_due(void)
+{
+    return presents % DITHER_PRESENTS_PER_FRAME == 0;
+}
+
+void Dither::keep_plane(int x_offs)
+{
+    for (unsigned int y = 0; y < ANIMW_HEIGHT; y++)
+        _fmemcpy(plane[y], Graph::animw_row(x_offs, y), ANIMW_WIDTH_B);
+}
+
+// same transfer as Graph::vram_copy(), for the window rows only
+void Dither::present(int x_offs, unsigned int plane_allowed)
+{
+    unsigned int first_offs =
+        GRAPH_Y_OFFS * LCD_ROW_B + x_offs / BITS_PER_BYTE;
+
+    // the plane at odd presents, else a row of nothing over and over
+    unsigned int with_plane = plane_allowed && presents & 1;
+
+    presents++;
+
+#ifndef HOSTSIM
+    byte_t const * plane_p = with_plane ? plane[0] : no_plane;
+    int plane_skip = with_plane ? 0 : -ANIMW_WIDTH_B;
+    unsigned int nrows = ANIMW_HEIGHT;
+    byte_t const * bitrev_p = bitrev;
+
+    asm {
+    push ax
+    push cx
+    push dx
+    push bx
+    push si
+    push di
+    push es
+    mov  si,first_offs
+    mov  di,plane_p
+    mov  bx,bitrev_p
+    mov  ax,0b000h
+    mov  es,ax
+    }
+   present_row:
+  asm {
+    mov  cx,ANIMW_WIDTH_B
+    mov  al,0ah
+    mov  dx,8011h
+    cli
+    out  dx,al
+    mov  ax,si
+    dec  dx
+    out  dx,al
+    sti
+    mov  al,0bh
+    inc  dx
+    cli
+    out  dx,al
+    mov  ax,si
+    mov  al,ah
+    and  al,7
+    dec  dx
+    out  dx,al
+    sti
+    }
+   present_byte:
+  asm {
+    mov  al,es:[si]
+    inc  si
+    or   al,[di]
+    inc  di
+    xlat
+    mov  ah,al
+    inc  dx
+    mov  al,0ch
+    cli
+    out  dx,al
+    mov  al,ah
+    dec  dx
+    out  dx,al
+    sti
+    loop present_byte
+    add  si,LCD_ROW_B - ANIMW_WIDTH_B
+    add  di,plane_skip
+    dec  nrows
+    jnz  present_row
+    pop  es
+    pop  di
+    pop  si
+    pop  bx
+    pop  dx
+    pop  cx
+    pop  ax
+  }
+#else // #ifdef HOSTSIM
+    byte_t far * const vram = (byte_t far *) MK_FP (0xb000, 0);
+
+    for (unsigned int y = 0; y < ANIMW_HEIGHT; y++)
+    {
+        unsigned int offs = first_offs + y * LCD_ROW_B;
+        byte_t const * const plane_row = with_plane ? plane[y] : no_plane;
+
+        outportb(0x8011, 0x0a);     // cursor address, low
+        outportb(0x8010, offs);
+        outportb(0x8011, 0x0b);     // cursor address, high
+        outportb(0x8010, offs >> BITS_PER_BYTE & 7);
+
+        for (unsigned int i = 0; i < ANIMW_WIDTH_B; i++)
+        {
+            outportb(0x8011, 0x0c); // write display data
+            outportb(0x8010, bitrev[vram[offs + i] | plane_row[i]]);
+        }
+    }
+#endif
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Gray in the animation window, temporal dithering
+ *
+ * The LCD has only black and white; flipping a pixel at every other
+ * refresh shows it gray. A second bitplane holds the previous frame of
+ * the window, present() sends the window rows alone to the LCD, the
+ * plane ORed in at every other call: pixels of the current frame stay
+ * black, those of the previous one only blink, gray trails are left
+ * behind whatever moves.
+ *
+ * The window is a fraction of the screen and the bits are reversed with
+ * a table lookup, not the rotations of vram_copy(), so the presents can
+ * come fast enough for the blinking to blend. They come back to back,
+ * a slice each: no clock finer than the 1 s tick could pace them, the
+ * rate is what present() and the frames in between take.
+ */
+
+#ifndef _DITHER_H
+#define _DITHER_H 1
+
+#include "graph.h"
+
+#define ANIMW_WIDTH_B (ANIMW_WIDTH / BITS_PER_BYTE)
+
+#define DITHER_PRESENTS_PER_FRAME 4     // two of each plane
+
+class Dither
+{
+    static byte_t
+        plane[ANIMW_HEIGHT][ANIMW_WIDTH_B];     // previous frame, video RAM bit order
+    static byte_t const
+        no_plane[ANIMW_WIDTH_B];
+    static byte_t
+        bitrev[256];            // LCD has the leftmost pixel in bit 0
+    static unsigned int
+        presents;
+
+public:
+    static void
+        start(void);
+    static unsigned int
+        is_frame_due(void);
+    static void
+        keep_plane(int);
+    static void
+        present(int, unsigned int);     // window x, plane allowed
+};
+
+#endif
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2022-2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "evsched.h"
+
+#ifdef NTVDM
+#include <iostream.h>
+#endif
+
+EvScheduler::EvScheduler(
+    handler_fp_t const * const handlers,
+    void * const handlers_ctx) :
+    heap_len(0),
+    now_min(0),
+    last_day_min(-1),
+    handlers(handlers),
+    handlers_ctx(handlers_ctx)
+{
+}
+
+void EvScheduler::set_now(unsigned int day_min)
+{
+    /*
+     * RTC gives daytime only, keep a monotonic minute counter
+     * by accumulating the forward distance to the last known daytime.
+     * The epoch is set to midnight of the first day seen.
+     */
+    if (last_day_min == -1)
+        now_min = day_min;
+    else
+        now_min +=
+            (day_min + MINUTES_PER_DAY - last_day_min) % MINUTES_PER_DAY;
+
+    last_day_min = day_min;
+}
+
+unsigned long EvScheduler::get_now(void) const
+{
+    return now_min;
+}
+
+unsigned int EvScheduler::is_before(
+    unsigned int i, unsigned int j) const
+{
+    if (heap[i].due_min != heap[j].due_min)
+        return heap[i].due_min < heap[j].due_min;
+
+    return heap[i].kind < heap[j].kind; // same minute, keep enum order
+}
+
+void EvScheduler::swap(unsigned int i, unsigned int j)
+{
+    event_t ev = heap[i];
+    heap[i] = heap[j];
+    heap[j] = ev;
+}
+
+void EvScheduler::sift_up(unsigned int i)
+{
+    while (i > 0)
+    {
+        unsigned int parent = (i - 1) / 2;
+
+        if (!is_before(i, parent))
+            break;
+
+        swap(i, parent);
+        i = parent;
+    }
+}
+
+void EvScheduler::sift_down(unsigned int i)
+{
+    for (;;)
+    {
+        unsigned int child = 2 * i + 1;
+        unsigned int first = i;
+
+        if (child < heap_len && is_before(child, first))
+            first = child;
+        if (child + 1 < heap_len && is_before(child + 1, first))
+            first = child + 1;
+        if (first == i)
+            break;
+
+        swap(i, first);
+        i = first;
+    }
+}
+
+void EvScheduler::remove_at(unsigned int i)
+{
+    heap[i] = heap[--heap_len];
+
+    if (i < heap_len)
+    {
+        sift_up(i);
+        sift_down(i);
+    }
+}
+
+int EvScheduler::schedule_at(
+    event_kind_t kind, unsigned long due_min)
+{
+    cancel(kind); // at most one pending event per kind
+
+    if (heap_len >= EVSCHED_CAPACITY)
+        return RET_FAILURE;
+
+#ifdef NTVDM
+    cout
+        << "EvScheduler: Event "
+        << (unsigned int)kind
+        << " due in "
+        << due_min - now_min
+        << " minute(s).\n";
+#endif
+
+    heap[heap_len].due_min = due_min;
+    heap[heap_len].kind = kind;
+    sift_up(heap_len++);
+
+    return RET_SUCCESS;
+}
+
+int EvScheduler::schedule_in(
+    event_kind_t kind, unsigned int minutes)
+{
+    return schedule_at(kind, now_min + minutes);
+}
+
+int EvScheduler::schedule_on_boundary(
+    event_kind_t kind, unsigned int period_min)
+{
+    /*
+     * Next whole multiple of the period, e.g. period 30
+     * at 10:12 gives 10:30, at 10:30 gives 11:00.
+     */
+    return schedule_at(kind, (now_min / period_min + 1) * period_min);
+}
+
+void EvScheduler::cancel(event_kind_t kind)
+{
+    for (unsigned int i = 0; i < heap_len; i++)
+    {
+        if (heap[i].kind == kind)
+        {
+            remove_at(i);
+            return;
+        }
+    }
+}
+
+unsigned int EvScheduler::is_pending(event_kind_t kind) const
+{
+    for (unsigned int i = 0; i < heap_len; i++)
+    {
+        if (heap[i].kind == kind)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+unsigned int EvScheduler::get_next_due_daymin(
+    unsigned int & const day_min) const
+{
+    if (heap_len == 0)
+        return FALSE;
+
+    day_min = (unsigned int)(heap[0].due_min % MINUTES_PER_DAY);
+    return TRUE;
+}
+
+unsigned int EvScheduler::dispatch_due(void)
+{
+    unsigned int dispatched = 0;
+
+    while (heap_len > 0 && heap[0].due_min <= now_min)
+    {
+        event_kind_t kind = (event_kind_t)heap[0].kind;
+
+        remove_at(0); // before the call, handler may re-schedule its kind
+
+        if (handlers[kind])
+            handlers[kind](handlers_ctx, kind);
+
+        dispatched++;
+    }
+
+    return dispatched;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2022-2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Event scheduler, min-heap of timed events
+ */
+
+#ifndef _EVSCHED_H
+#define _EVSCHED_H 1
+
+#include "common.h"
+
+#define EVSCHED_CAPACITY 8
+
+class EvScheduler
+{
+public:
+    enum event_kind_t {
+        EV_CLOCK_MINUTE,
+        EV_ARRANGEMENT_SWAP,
+        EV_CHIME_HALFHOUR,
+        EV_CHIME_FULLHOUR,
+        EV_ANIM_RESTART,
+        EV_POWEROFF,
+        EV_POWEROFF_DEADLINE,
+        EV_KINDS_NUM
+    };
+
+    typedef void
+        (* handler_fp_t)(void *, event_kind_t);
+
+private:
+    struct event_t {
+        unsigned long due_min;  // minutes since the scheduler epoch
+        byte_t kind;
+    };
+
+    event_t
+        heap[EVSCHED_CAPACITY];
+    unsigned int
+        heap_len;
+    unsigned long
+        now_min;                // monotonic, now_min % MINUTES_PER_DAY is the daytime
+    int
+        last_day_min;
+
+    handler_fp_t const * const
+        handlers;               // dispatch table, indexed by event_kind_t
+    void * const
+        handlers_ctx;
+
+    unsigned int
+        is_before(unsigned int, unsigned int) const;
+    void
+        swap(unsigned int, unsigned int);
+    void
+        sift_up(unsigned int);
+    void
+        sift_down(unsigned int);
+    void
+        remove_at(unsigned int);
+
+public:
+    EvScheduler(
+        handler_fp_t const * const,
+        void * const);
+
+    void
+        set_now(unsigned int);
+    unsigned long
+        get_now(void) const;
+    int
+        schedule_at(event_kind_t, unsigned long);
+    int
+        schedule_in(event_kind_t, unsigned int);
+    int
+        schedule_on_boundary(event_kind_t, unsigned int);
+    void
+        cancel(event_kind_t);
+    unsigned int
+        is_pending(event_kind_t) const;
+    unsigned int
+        get_next_due_daymin(unsigned int & const) const;
+    unsigned int
+        dispatch_due(void);
+};
+
+#endif
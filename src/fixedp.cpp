@@ -216,7 +216,7 @@ Fixedp
         case 9: res =  (1l << SCALE) / (1l * 9 * 8 * 7 * 6 * 5 * 4 * 3 * 2 * 1); break;
         case 10: res = (1l << SCALE) / (1l * 10 * 9 * 8 * 7 * 6 * 5 * 4 * 3 * 2 * 1); break;
         case 11: res = (1l << SCALE) / (1l * 11 * 10 * 9 * 8 * 7 * 6 * 5 * 4 * 3 * 2 * 1); break;
-        default: 1l << SCALE; break;
+        default: res = 1l << SCALE; break;      // 0! and 1!
     }
 
     return Fixedp(res, TRUE);
@@ -244,7 +244,11 @@ Fixedp
         term_powx *= xrad_norm * xrad_norm;
         term = term_powx * invfact_table(n);
         sinx += term_sign > 0 ? term : -term;
+#ifndef HOSTSIM
         asm { neg WORD PTR term_sign };
+#else // #ifdef HOSTSIM
+        term_sign = -term_sign;
+#endif
     }
 
     if (in_second_halfperiod) sinx = -sinx;
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "fixedp3.h"
+
+FixedpVec3
+    FixedpVec3::operator + (FixedpVec3 const & const addend) const
+{
+    FixedpVec3 sum;
+
+    sum.x = x + addend.x;
+    sum.y = y + addend.y;
+    sum.z = z + addend.z;
+
+    return sum;
+}
+
+FixedpVec3
+    FixedpVec3::operator - (void) const
+{
+    FixedpVec3 negated;
+
+    negated.x = -x;
+    negated.y = -y;
+    negated.z = -z;
+
+    return negated;
+}
+
+FixedpVec3
+    FixedpVec3::operator - (FixedpVec3 const & const subtrahend) const
+{
+    FixedpVec3 difference;
+
+    difference.x = x - subtrahend.x;
+    difference.y = y - subtrahend.y;
+    difference.z = z - subtrahend.z;
+
+    return difference;
+}
+
+static Fixedp
+    mul_unit(Fixedp const a, Fixedp const b)
+{
+    int const a_214 =
+        (int)((a.rawvalue + (1l << (SCALE - 15))) >> (SCALE - 14));
+    int const b_214 =
+        (int)((b.rawvalue + (1l << (SCALE - 15))) >> (SCALE - 14));
+    long product;
+
+#ifndef HOSTSIM
+    // a long by long multiply would go through LXMUL@
+    asm {
+        push ax
+        push dx
+        mov  ax,a_214
+        mov  dx,b_214
+        imul dx
+        mov  word ptr [ product ],ax
+        mov  word ptr [ product + 2 ],dx
+        pop  dx
+        pop  ax
+    }
+#else // #ifdef HOSTSIM
+    product = (long)a_214 * b_214;
+#endif
+
+    return Fixedp(
+        (product + (1l << (27 - SCALE))) >> (28 - SCALE),
+        TRUE);
+}
+
+static Fixedp
+    cos_small(Fixedp const sin)
+{
+    // sqrt(1 - s^2) = 1 - s^2 / 2 - s^4 / 8 - ..., off by s^6 / 16 at most
+    Fixedp const sin2 = mul_unit(sin, sin);
+
+    return Fixedp(1l) - sin2 / 2l - mul_unit(sin2, sin2) / 8l;
+}
+
+void
+    FixedpMat3::set_identity(void)
+{
+    for (unsigned int row = 0; row < 3; row++)
+        for (unsigned int col = 0; col < 3; col++)
+            m[row][col] = Fixedp(row == col ? 1l : 0l);
+}
+
+void
+    FixedpMat3::set_rotation_xy(
+        Fixedp const sin_x,
+        Fixedp const sin_y)
+{
+    Fixedp const cos_x = cos_small(sin_x);
+    Fixedp const cos_y = cos_small(sin_y);
+
+    // Rx * Ry multiplied out, the zeros and ones left out
+    m[0][0] = cos_y;
+    m[0][1] = Fixedp(0l);
+    m[0][2] = sin_y;
+    m[1][0] = mul_unit(sin_x, sin_y);
+    m[1][1] = cos_x;
+    m[1][2] = -mul_unit(sin_x, cos_y);
+    m[2][0] = -mul_unit(cos_x, sin_y);
+    m[2][1] = sin_x;
+    m[2][2] = mul_unit(cos_x, cos_y);
+}
+
+FixedpVec3
+    FixedpMat3::column(unsigned int col) const
+{
+    FixedpVec3 v;
+
+    v.x = m[0][col];
+    v.y = m[1][col];
+    v.z = m[2][col];
+
+    return v;
+}
+
+FixedpMat3
+    FixedpMat3::operator * (FixedpMat3 const & const multiplicant) const
+{
+    FixedpMat3 product;
+
+    for (unsigned int row = 0; row < 3; row++)
+    {
+        for (unsigned int col = 0; col < 3; col++)
+        {
+            product.m[row][col] =
+                mul_unit(m[row][0], multiplicant.m[0][col]) +
+                mul_unit(m[row][1], multiplicant.m[1][col]) +
+                mul_unit(m[row][2], multiplicant.m[2][col]);
+        }
+    }
+
+    return product;
+}
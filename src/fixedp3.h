@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Fixed point 3D vector and 3x3 matrix
+ */
+
+#ifndef _FIXEDP3_H
+#define _FIXEDP3_H 1
+
+#include "fixedp.h"
+
+struct FixedpVec3
+{
+    Fixedp
+        x, y, z;
+
+    FixedpVec3
+        operator + (FixedpVec3 const & const) const;
+    FixedpVec3
+        operator - (void) const;
+    FixedpVec3
+        operator - (FixedpVec3 const & const) const;
+};
+
+/*
+ * For rotations: the entries are within -1 to 1, they are multiplied
+ * in 2.14, a 16 by 16 bit multiply each, rounded; more precise than
+ * the general Fixedp one, which would let a rotation grow when turned
+ * a frame at a time
+ */
+struct FixedpMat3
+{
+    Fixedp
+        m[3][3];                // [row][column]
+
+    void
+        set_identity(void);
+    void
+        set_rotation_xy(        // about x, then about y
+            Fixedp const,       // sin of a small angle about x
+            Fixedp const);      // and about y
+    FixedpVec3
+        column(unsigned int) const;
+    FixedpMat3
+        operator * (FixedpMat3 const & const) const;
+};
+
+#endif
@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "fntsmall.h"
+
+unsigned int const
+    FntSmall::glyphs[FNT_SMALL_LAST - FNT_SMALL_FIRST + 1] = {
+        000000, 022202, 055000, 057575, 036236, 051245, 025253, 022000, //  !"#$%&'
+        012221, 042224, 005250, 002720, 000024, 000700, 000002, 011244, // ()*+,-./
+        075557, 026227, 071747, 071317, 055711, 074717, 074757, 071122, // 01234567
+        075757, 075717, 002020, 002024, 012421, 007070, 042124, 071302, // 89:;<=>?
+        075747, 025755, 065656, 034443, 065556, 074647, 074644, 034553, // @ABCDEFG
+        055755, 072227, 011152, 055655, 044447, 057755, 065555, 025552, // HIJKLMNO
+        065644, 025563, 065655, 034216, 072222, 055557, 055552, 055775, // PQRSTUVW
+        055255, 055222, 071247, 032223, 044211, 062226, 025000, 000007, // XYZ[\]^_
+    };
+
+unsigned int FntSmall::glyph(char c)
+{
+    if (c >= 'a' && c <= 'z')
+        c -= 'a' - 'A';
+    if (c < FNT_SMALL_FIRST || c > FNT_SMALL_LAST)
+        c = '?';
+
+    return glyphs[c - FNT_SMALL_FIRST];
+}
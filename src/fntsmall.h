@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Small built-in font, 3x5 pixels, upper case only
+ *
+ * A glyph is one octal digit per row from the top:
+ * 4 - left, 2 - middle, 1 - right pixel.
+ */
+
+#ifndef _FNTSMALL_H
+#define _FNTSMALL_H 1
+
+#include "common.h"
+
+#define FNT_SMALL_FIRST ' '
+#define FNT_SMALL_LAST '_'
+#define FNT_SMALL_WIDTH 3
+#define FNT_SMALL_HEIGHT 5
+#define FNT_SMALL_ADVANCE 4     // pixels a char, a gap included
+
+class FntSmall
+{
+    static unsigned int const
+        glyphs[FNT_SMALL_LAST - FNT_SMALL_FIRST + 1];
+
+public:
+    static unsigned int
+        glyph(char);
+};
+
+#endif
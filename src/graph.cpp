@@ -6,8 +6,16 @@
  */
 
 #include "graph.h"
+#include "life.h"
+#include "marquee.h"
+#include "wirefrm.h"
+#include "colcanv.h"
+#if defined(TELEMETRY) || defined(PROFILE)
+#include "pit.h"
+#endif
 
 #include <stdlib.h>
+#include <mem.h>
 
 #ifdef NTVDM
 #include <graphics.h>
@@ -20,9 +28,20 @@ struct Graph::vram_cga_oddscanlines_t  const
     Graph::vram_cga_oddscanlines;
 #endif
 
+#if defined(TELEMETRY) || defined(PROFILE)
+#define VRAM_COPY_BAND_ROWS 16  // ~20 ms of the ~86 ms full copy
+#endif
+
+#ifndef NTVDM
+static byte_t
+    snapshot[LCD_YRES * LCD_ROW_B];    // the frame before the power-off
+#endif
+
 Graph::Graph(
     window_arrangement_t const window_arrangement) :
-    pi_fixedp (FIXEDP_PI_RAW, TRUE)
+    pi_fixedp (FIXEDP_PI_RAW, TRUE),
+    anim_engine (ANIM_SINE),
+    anim_canvas (FALSE)
 {
     set_window_arrangement(window_arrangement);
 }
@@ -64,6 +83,9 @@ void Graph::anim_clearwindow(void)
 #endif
         }
     }
+
+    if (anim_canvas)
+        ColCanvas::clear();
 }
 
 #ifdef SSHOT
@@ -95,9 +117,29 @@ int
 
 #define ANIM_SIN_NUM_WAVES 3
 #define ANIM_SIN_WAVEAMPL (FNTDATA_HEIGHT / 2l)
-void Graph::anim_prep(void)
+void Graph::anim_prep(anim_engine_t const engine)
 {
     anim_clearwindow();
+    anim_engine = engine;
+
+    if (anim_engine == ANIM_MARQUEE && Marquee::start() != RET_SUCCESS)
+        anim_engine = ANIM_SINE;    // no messages to show
+
+    if (anim_engine == ANIM_MARQUEE)
+        return;
+
+    if (anim_engine == ANIM_LIFE)
+    {
+        Life::seed(animw_initial_x_offs);
+        return;
+    }
+
+    if (anim_engine == ANIM_WIRE)
+    {
+        Wireframe::start();
+        return;
+    }
+
     animw_x_offset = animw_initial_x_offs;
     sin_wavelength_fixedp = Fixedp(2l) * pi_fixedp / (ANIMW_WIDTH / 2l);
     sin_bigamplmultp_tenfold = 10;
@@ -164,6 +206,22 @@ void Graph::anim_prep(void)
     sin_3_waveamplmultp = Fixedp(sin_3_waveamplmultp_tenfold) / 10l;
 }
 
+void Graph::anim_sine_putpix(int x, int y)
+{
+    if (anim_canvas)
+        ColCanvas::putpix(x - animw_initial_x_offs, y - GRAPH_Y_OFFS);
+    else
+        putpix(x, y);
+}
+
+void Graph::anim_sine_present(int x_first)
+{
+    if (anim_canvas)            // the columns drawn, into video RAM
+        ColCanvas::present(animw_initial_x_offs,
+            x_first - animw_initial_x_offs,
+            animw_x_offset - 1 - animw_initial_x_offs);
+}
+
 #define ANIM_SIN_AMPL_HYST 6
 int Graph::anim_iter_amplmultp_finished(void)
 {
@@ -190,10 +248,11 @@ int Graph::anim_iter_amplmultp_finished(void)
 
 #ifdef EMUFPU
 #include <math.h>
-int Graph::animate_finished(void)
+int Graph::anim_sine_finished(void)
 {
     double animwin_ypos;
     int anim_iter = 9;
+    int x_first = animw_x_offset;
     while (
         (animw_x_offset < (animw_initial_x_offs + ANIMW_WIDTH)) &&
         (anim_iter-- > 0))
@@ -216,18 +275,21 @@ int Graph::animate_finished(void)
         animwin_ypos +=
             GRAPH_Y_OFFS + ANIM_SIN_WAVEAMPL;
 
-        putpix(animw_x_offset++, (int)animwin_ypos);
+        anim_sine_putpix(animw_x_offset++, (int)animwin_ypos);
     }
 
+    anim_sine_present(x_first);
+
     if (animw_x_offset >= (animw_initial_x_offs + ANIMW_WIDTH))
         return anim_iter_amplmultp_finished(); // finished = TRUE or FALSE
     return FALSE; // finished = FALSE
 }
 #else // fixed point arithmetic
-int Graph::animate_finished(void)
+int Graph::anim_sine_finished(void)
 {
     Fixedp animwin_ypos;
     int anim_iter = 9;
+    int x_first = animw_x_offset;
     while (
         (animw_x_offset < (animw_initial_x_offs + ANIMW_WIDTH)) &&
         (anim_iter-- > 0))
@@ -251,21 +313,46 @@ int Graph::animate_finished(void)
         animwin_ypos +=
             GRAPH_Y_OFFS + ANIM_SIN_WAVEAMPL;
 
-        putpix(animw_x_offset++, animwin_ypos.to_integer());
+        anim_sine_putpix(animw_x_offset++, animwin_ypos.to_integer());
     }
 
+    anim_sine_present(x_first);
+
     if (animw_x_offset >= (animw_initial_x_offs + ANIMW_WIDTH))
         return anim_iter_amplmultp_finished(); // finished = TRUE or FALSE
     return FALSE; // finished = FALSE
 }
 #endif
 
+int Graph::animate_finished(void)
+{
+    if (anim_engine == ANIM_LIFE)
+        return Life::step_finished(animw_initial_x_offs);
+    if (anim_engine == ANIM_MARQUEE)
+        return Marquee::step_finished(animw_initial_x_offs);
+    if (anim_engine == ANIM_WIRE)
+        return Wireframe::step_finished(animw_initial_x_offs);
+
+    return anim_sine_finished();
+}
+
+int Graph::get_animw_x_offs(void) const
+{
+    return animw_initial_x_offs;
+}
+
+void Graph::set_anim_canvas(unsigned int on)
+{
+    anim_canvas = on;           // takes effect with the next anim_prep()
+}
+
 // Routines for Hitachi HD61830 display controller
 
 // source code taken from:
 //     http://portfolio.wz.cz/programm/pgm_gfx.htm
 void Graph::cls_withpattern(unsigned int pattern)
 {
+#ifndef HOSTSIM
   asm {
     push es
     push cx
@@ -286,10 +373,15 @@ void Graph::cls_withpattern(unsigned int pattern)
     pop  cx
     pop  es
   }
+#else // #ifdef HOSTSIM
+    for (unsigned int i = 0; i < VRAM_SIZE_W; i++)
+        Graph::vram_cga_evenscanlines.ptr_union.ptr_w[i] = pattern;
+#endif
 }
 
 void Graph::cls_withzigzag(void)
 {
+#ifndef HOSTSIM
   asm {
     push es
     push cx
@@ -339,6 +431,150 @@ nextline_label:
     pop  cx
     pop  es
   }
+#else // #ifdef HOSTSIM
+    byte_t pattern = 0x11;
+    unsigned int line = 0;      // of the zigzag period
+
+    for (unsigned int y = 0; y < DISPL_YRES; y++)
+    {
+        for (unsigned int x = 0; x < VRAM_ROW_B; x++)
+            (*Graph::vram_cga_evenscanlines.ptr_union.arr_b)[y][x] = pattern;
+
+        if (line > ZIGZAG_HEIGHT)   // ror
+        {
+            pattern = pattern >> 1 | pattern << 7;
+            if (++line >= ZIGZAG_HEIGHT * 2)
+                line = 0;
+        }
+        else                        // rol
+        {
+            pattern = pattern << 1 | pattern >> 7;
+            line++;
+        }
+    }
+#endif
+}
+
+word_t far * Graph::animw_row(int x_offs, unsigned int y)
+{
+    y += GRAPH_Y_OFFS;
+
+#ifndef NTVDM
+    return
+        &(*vram_cga_evenscanlines.ptr_union.arr_w)
+            [y][x_offs / BITS_PER_WORD];
+#else // #ifdef NTVDM
+    if (y % 2)
+        return
+            &(*vram_cga_oddscanlines.ptr_union.arr_w)
+                [y / 2][x_offs / BITS_PER_WORD];
+    return
+        &(*vram_cga_evenscanlines.ptr_union.arr_w)
+            [y / 2][x_offs / BITS_PER_WORD];
+#endif
+}
+
+byte_t far * Graph::vram_row(unsigned int y)
+{
+#ifndef NTVDM
+    return (*vram_cga_evenscanlines.ptr_union.arr_b)[y];
+#else // #ifdef NTVDM
+    if (y % 2)
+        return (*vram_cga_oddscanlines.ptr_union.arr_b)[y / 2];
+    return (*vram_cga_evenscanlines.ptr_union.arr_b)[y / 2];
+#endif
+}
+
+void Graph::span(int x_first, int x_last, int y, unsigned int set)
+{
+    byte_t far * row_p = vram_row(y);
+    int col_first = x_first / BITS_PER_BYTE;
+    int col_last = x_last / BITS_PER_BYTE;
+    byte_t mask_first = 0xff >> x_first % BITS_PER_BYTE;
+    byte_t mask_last = 0xff << (BITS_PER_BYTE - 1 - x_last % BITS_PER_BYTE);
+
+    if (col_first == col_last)
+        mask_first &= mask_last;
+
+    // partial bytes at the ends masked in, whole ones in between stored
+    if (set)
+        row_p[col_first] |= mask_first;
+    else
+        row_p[col_first] &= ~mask_first;
+
+    if (col_first == col_last)
+        return;
+
+    for (int col = col_first + 1; col < col_last; col++)
+        row_p[col] = set ? 0xff : 0;
+
+    if (set)
+        row_p[col_last] |= mask_last;
+    else
+        row_p[col_last] &= ~mask_last;
+}
+
+void Graph::line(int x0, int y0, int x1, int y1, unsigned int pixop)
+{
+    /*
+     * Bresenham, walking a byte pointer and a bit mask
+     * rather than computing the address of every pixel
+     */
+    int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+    int dy = y1 > y0 ? y1 - y0 : y0 - y1;
+    int step_x = x1 > x0 ? 1 : -1;
+    int step_y = y1 > y0 ? 1 : -1;
+    int err = dx - dy;
+    byte_t far * pix_p = vram_row(y0) + x0 / BITS_PER_BYTE;
+    byte_t mask = 0x80 >> x0 % BITS_PER_BYTE;
+
+    for (;;)
+    {
+        if (pixop == PIX_XOR)
+            *pix_p ^= mask;
+        else if (pixop == PIX_SET)
+            *pix_p |= mask;
+        else
+            *pix_p &= ~mask;
+
+        if (x0 == x1 && y0 == y1)
+            break;
+
+        int err2 = 2 * err;
+
+        if (err2 > -dy)
+        {
+            err -= dy;
+            x0 += step_x;
+
+            if (step_x > 0)
+            {
+                if (!(mask >>= 1))
+                {
+                    mask = 0x80;
+                    pix_p++;
+                }
+            }
+            else
+            {
+                if (!(mask <<= 1))
+                {
+                    mask = 0x01;
+                    pix_p--;
+                }
+            }
+        }
+        if (err2 < dx)
+        {
+            err += dx;
+            y0 += step_y;
+#ifndef NTVDM
+            pix_p += step_y > 0 ? VRAM_ROW_B : -VRAM_ROW_B;
+#else // #ifdef NTVDM
+            pix_p = vram_row(y0) + x0 / BITS_PER_BYTE;  // banks interleave
+#endif
+        }
+    }
 }
 
 // source code taken from:
@@ -358,8 +594,16 @@ void Graph::putpix(int x, int y)
 
 // source code taken from:
 //     http://portfolio.wz.cz/programm/pgm_gfx.htm
-void Graph::vram_copy()
+static void
+    vram_copy_rows(
+        unsigned int first_row, unsigned int nrows,
+        unsigned int first_col_b, unsigned int ncols_b)
 {
+  unsigned int first_offs = first_row * LCD_ROW_B + first_col_b;
+
+#ifndef HOSTSIM
+  unsigned int row_skip = LCD_ROW_B - ncols_b;
+
   asm {
     cld
     push ax
@@ -369,14 +613,14 @@ void Graph::vram_copy()
     push si
     push di
     push ds
-    mov  si,0
+    mov  si,first_offs
+    mov  di,nrows
     mov  ax,0b000h
     mov  ds,ax
-    mov  di,64
     }
    refresh_2:
   asm {
-    mov  cx,30
+    mov  cx,ncols_b
     mov  bx,si
     mov  al,0ah
     mov  dx,8011h
@@ -426,6 +670,7 @@ void Graph::vram_copy()
     out  dx,al
     sti
     loop refresh_1
+    add  si,row_skip
     dec  di
     jnz  refresh_2
     pop  ds
@@ -436,4 +681,70 @@ void Graph::vram_copy()
     pop  cx
     pop  ax
   }
+#else // #ifdef HOSTSIM
+    byte_t far * const vram = (byte_t far *) MK_FP (0xb000, 0);
+
+    for (unsigned int offs = first_offs;
+        offs < first_offs + nrows * LCD_ROW_B;
+        offs += LCD_ROW_B)
+    {
+        outportb(0x8011, 0x0a);     // cursor address, low
+        outportb(0x8010, offs);
+        outportb(0x8011, 0x0b);     // cursor address, high
+        outportb(0x8010, offs >> BITS_PER_BYTE & 7);
+
+        for (unsigned int i = 0; i < ncols_b; i++)
+        {
+            byte_t b = vram[offs + i];
+            byte_t lcd_b = 0;
+
+            for (unsigned int bit = 0; bit < BITS_PER_BYTE; bit++)
+                lcd_b |= (b >> bit & 1) << (BITS_PER_BYTE - 1 - bit); // as the rors do
+
+            outportb(0x8011, 0x0c); // write display data
+            outportb(0x8010, lcd_b);
+        }
+    }
+#endif
+}
+
+void Graph::vram_copy(
+    unsigned int first_row, unsigned int nrows,
+    unsigned int first_col_b, unsigned int ncols_b)
+{
+#if defined(TELEMETRY) || defined(PROFILE)
+    // the whole screen takes longer than a PIT wrap (~55 ms), the running
+    // stopwatches are sampled in between bands of rows not to lose any
+    while (nrows > VRAM_COPY_BAND_ROWS)
+    {
+        vram_copy_rows(first_row, VRAM_COPY_BAND_ROWS, first_col_b, ncols_b);
+        PitStopwatch::sample_running();
+        first_row += VRAM_COPY_BAND_ROWS;
+        nrows -= VRAM_COPY_BAND_ROWS;
+    }
+#endif
+    vram_copy_rows(first_row, nrows, first_col_b, ncols_b);
+}
+
+void Graph::snapshot_save(void)
+{
+#ifndef NTVDM
+    _fmemcpy(snapshot, vram_cga_evenscanlines.ptr_union.ptr_b, sizeof snapshot);
+#endif
+}
+
+unsigned int Graph::snapshot_restore(void)
+{
+    /*
+     * The frame is there still unless the BIOS used the screen while
+     * off, then the LCD needs all of it; TRUE if nothing was restored.
+     */
+#ifndef NTVDM
+    if (_fmemcmp(snapshot, vram_cga_evenscanlines.ptr_union.ptr_b,
+            sizeof snapshot) == 0)
+        return TRUE;
+
+    _fmemcpy(vram_cga_evenscanlines.ptr_union.ptr_b, snapshot, sizeof snapshot);
+#endif
+    return FALSE;
 }
@@ -26,6 +26,9 @@
 #define VRAM_SIZE_B (DISPL_YRES * VRAM_ROW_B )
 #define VRAM_SIZE_W (DISPL_YRES * VRAM_ROW_W )
 
+#define LCD_YRES 64             // rows vram_copy() sends to the LCD controller
+#define LCD_ROW_B 30
+
 #define CGA_VRAM_SEG 0xB800
 #define CGA_VRAM_EVENLINES_OFFS 0
 #define CGA_VRAM_ODDLINES_OFFS 0x2000
@@ -47,6 +50,7 @@
 #define ANIMW_MARGIN_X BITS_PER_WORD
 #define ANIMW_WIDTH (DGCLOCK_X_OFFS_MAX / BITS_PER_WORD * BITS_PER_WORD /* cutting fraction out */ - ANIMW_MARGIN_X)
 #define ANIMW_HEIGHT FNTDATA_HEIGHT
+#define ANIMW_WIDTH_W (ANIMW_WIDTH / BITS_PER_WORD)
 
 class Graph
 {
@@ -65,25 +69,49 @@ class Graph
     Fixedp const
         pi_fixedp;
 
+    byte_t
+        anim_engine,
+        anim_canvas;            // sine drawn through ColCanvas
+
     void
         anim_clearwindow(void);
     int
         anim_iter_amplmultp_finished(void);
+    int
+        anim_sine_finished(void);
+    void
+        anim_sine_putpix(int, int);
+    void
+        anim_sine_present(int);
 public:
     enum window_arrangement_t {
         DGCLOCK_LEFT_ANIM_RIGHT,
         DGCLOCK_RIGHT_ANIM_LEFT,
     };
 
+    enum anim_engine_t {
+        ANIM_SINE,              // superposed sine waves
+        ANIM_LIFE,              // Game of Life, see life.h
+        ANIM_MARQUEE,           // text from a file, see marquee.h
+        ANIM_WIRE,              // rotating wireframe, see wirefrm.h
+        ANIM_ENGINES_NUM
+    };
+
+    enum pixop_t {              // FALSE / TRUE for clear / set
+        PIX_CLEAR,
+        PIX_SET,
+        PIX_XOR                 // drawn twice, gone
+    };
+
     struct vram_cga_evenscanlines_t {
         union ptr_union_t {
             byte_t far *
                 ptr_b;
-            unsigned int far *
+            word_t far *
                 ptr_w;
             byte_t
                 (far * arr_b)[DISPL_YRES][VRAM_ROW_B];
-            unsigned int
+            word_t
                 (far * arr_w)[DISPL_YRES][VRAM_ROW_W];
 
             ptr_union_t() :
@@ -97,11 +125,11 @@ public:
         union ptr_union_t {
             byte_t far *
                 ptr_b;
-            unsigned int far *
+            word_t far *
                 ptr_w;
             byte_t
                 (far * arr_b)[DISPL_YRES][VRAM_ROW_B];
-            unsigned int
+            word_t
                 (far * arr_w)[DISPL_YRES][VRAM_ROW_W];
 
             ptr_union_t() :
@@ -131,13 +159,31 @@ public:
         take_screenshot(int);
 #endif
     void
-        anim_prep(void);
+        anim_prep(anim_engine_t const);
     int
         animate_finished(void);
+    int
+        get_animw_x_offs(void) const;
+    void
+        set_anim_canvas(unsigned int);
     void
         putpix(int, int);
+    static word_t far *
+        animw_row(int, unsigned int);   // window x, row within it
+    static byte_t far *
+        vram_row(unsigned int);         // screen row
+    static void
+        span(int, int, int, unsigned int);      // x first, x last, y, set or clear
+    static void
+        line(int, int, int, int, unsigned int); // x0, y0, x1, y1, pixop_t
+    void
+        vram_copy(                  // rows, byte columns
+            unsigned int = 0, unsigned int = LCD_YRES,
+            unsigned int = 0, unsigned int = LCD_ROW_B);
     void
-        vram_copy();
+        snapshot_save(void);
+    unsigned int
+        snapshot_restore(void);
 };
 
 #endif
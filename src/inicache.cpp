@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Binary cache of the parsed INI file, loaded with a single read
+ */
+
+#include "inifile.h"
+#include "arena.h"
+#include "common.h"
+
+#include <dos.h>
+#include <io.h>
+#include <fcntl.h>
+#include <string.h>
+
+#define CACHE_MAGIC 0x4350      // 'PC'
+#define CACHE_VERSION 3
+#define INI_CHUNK_B 128         // read at a time for the key checksum
+
+char const * const
+    INIFile::cache_filename = "PFWALLCL.CCH";
+
+static struct cache_image_t {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int pwrsched_size; // catches a changed PwrSched layout
+    INIFile::cache_key_t key;
+    int pon_min;                // or PWRSCHED_UNSET
+    int poff_min;
+    int kbhit_poff_delay_min;
+    PwrSched pwrsched;          // compiled, no pointers inside
+    ToneSeq::melody_t halfhour_melody;  // nnotes 0 if not set
+    ToneSeq::melody_t fullhour_melody;
+    unsigned int checksum;      // Fletcher-16 of all the above, keep last
+}
+    cache_image;
+
+static unsigned int
+    fletcher16(void const * const data, unsigned int len,
+        unsigned int sum = 0)   // of the data before, to continue it
+{
+    byte_t const * p = (byte_t const *) data;
+    unsigned int sum1 = sum & 0xff, sum2 = sum >> 8;
+
+    while (len--)
+    {
+        sum1 = (sum1 + *p++) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+
+    return sum2 << 8 | sum1;
+}
+
+static int
+    dayt_min(Timer::DaytimeHHMM const * const dayt_p)
+{
+    return dayt_p ? dayt_p->get_abs_min() : PWRSCHED_UNSET;
+}
+
+static ToneSeq::melody_t const *
+    new_melody(ToneSeq::melody_t const & const melody)
+{
+    return melody.nnotes == 0 ?
+        NULL :
+        new (arena) ToneSeq::melody_t(melody);
+}
+
+static Timer::DaytimeHHMM const *
+    new_dayt(int day_min)
+{
+    return day_min == PWRSCHED_UNSET ?
+        NULL :
+        new (arena) Timer::DaytimeHHMM(0, day_min);
+}
+
+int INIFile::read_cache_key(INIFile::cache_key_t & const key)
+{
+    int fd;
+    byte_t chunk[INI_CHUNK_B];
+    unsigned int nread;
+
+    if (_dos_open(ini_filename, O_RDONLY, &fd) != 0)
+        return RET_FAILURE;
+
+    memset(&key, 0, sizeof key);
+    key.ini_size = filelength(fd);
+
+    int res = _dos_getftime(fd, &key.ini_date, &key.ini_time) == 0 ?
+        RET_SUCCESS : RET_FAILURE;
+
+    // the contents too, an edit may keep the size and the 2 s timestamp
+    while (res == RET_SUCCESS)
+    {
+        if (_dos_read(fd, chunk, sizeof chunk, &nread) != 0)
+            res = RET_FAILURE;
+        else if (nread == 0)
+            break;
+        else
+            key.ini_checksum = fletcher16(chunk, nread, key.ini_checksum);
+    }
+
+    _dos_close(fd);
+
+    return res;
+}
+
+INIFile *
+    INIFile::load_cache(INIFile::cache_key_t const & const key)
+{
+    int fd;
+    unsigned int nread;
+
+    if (_dos_open(cache_filename, O_RDONLY, &fd) != 0)
+        return NULL;
+
+    int res = _dos_read(fd, &cache_image, sizeof cache_image, &nread);
+
+    _dos_close(fd);
+
+    if (res != 0
+        || nread != sizeof cache_image
+        || cache_image.magic != CACHE_MAGIC
+        || cache_image.version != CACHE_VERSION
+        || cache_image.pwrsched_size != sizeof(PwrSched)
+        || memcmp(&cache_image.key, &key, sizeof key) != 0
+        || cache_image.checksum != fletcher16(
+            &cache_image, sizeof cache_image - sizeof cache_image.checksum))
+        return NULL;
+
+    return new (arena) INIFile(
+        new_dayt(cache_image.pon_min),
+        new_dayt(cache_image.poff_min),
+        new_dayt(cache_image.kbhit_poff_delay_min),
+        new (arena) PwrSched(cache_image.pwrsched),
+        new_melody(cache_image.halfhour_melody),
+        new_melody(cache_image.fullhour_melody));
+}
+
+void INIFile::save_cache(INIFile::cache_key_t const & const key) const
+{
+    int fd;
+    unsigned int written;
+
+    memset((void *)&cache_image, 0, sizeof cache_image); // no stray padding bytes
+    cache_image.magic = CACHE_MAGIC;
+    cache_image.version = CACHE_VERSION;
+    cache_image.pwrsched_size = sizeof(PwrSched);
+    cache_image.key = key;
+    cache_image.pon_min = dayt_min(pon_dayt_p);
+    cache_image.poff_min = dayt_min(poff_dayt_p);
+    cache_image.kbhit_poff_delay_min = dayt_min(kbhit_poff_delay_dayt_p);
+    cache_image.pwrsched = * pwrsched_p;
+    if (halfhour_melody_p)
+        cache_image.halfhour_melody = * halfhour_melody_p;
+    if (fullhour_melody_p)
+        cache_image.fullhour_melody = * fullhour_melody_p;
+    cache_image.checksum = fletcher16(
+        &cache_image, sizeof cache_image - sizeof cache_image.checksum);
+
+    // best effort, e.g. a write protected card
+    if (_dos_creat(cache_filename, _A_NORMAL, &fd) != 0)
+        return;
+
+    if (_dos_write(fd, &cache_image, sizeof cache_image, &written) != 0
+        || written != sizeof cache_image)
+    {
+        _dos_close(fd);
+        unlink(cache_filename); // never leave a partial image
+        return;
+    }
+
+    _dos_close(fd);
+}
+
+INIFile *
+    INIFile::load()
+{
+    cache_key_t key;
+
+    if (read_cache_key(key) == RET_FAILURE)
+        return parse(); // no INI file, defaults
+
+    INIFile * inifile = load_cache(key);
+
+    if (inifile)
+        return inifile;
+
+    inifile = parse();
+
+    if (inifile)
+        inifile->save_cache(key);
+
+    return inifile;
+}
@@ -6,23 +6,385 @@
  */
 
 #include "inifile.h"
+#include "arena.h"
 #include "common.h"
 
-#include <stdio.h>
-#include <fstream.h>
+#include <dos.h>
+#include <fcntl.h>
 #include <string.h>
 
+#define INI_BUF_SIZE 1024
+
 char const * const
     INIFile::ini_filename = "PFWALLCL.INI";
 
+static char
+    ini_buf[INI_BUF_SIZE + 1];  // whole file, tokenised in place
+
+static char const * const
+    weekday_names[PWRSCHED_DAYS_PER_WEEK] = {
+        "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+
+static int
+    compile_pwrsched(
+        PwrSched * const pwrsched,
+        Timer::DaytimeHHMM const * const pon_dayt_p,
+        Timer::DaytimeHHMM const * const poff_dayt_p)
+{
+    if (pwrsched->set_daily(
+            pon_dayt_p ? pon_dayt_p->get_abs_min() : PWRSCHED_UNSET,
+            poff_dayt_p ? poff_dayt_p->get_abs_min() : PWRSCHED_UNSET)
+                == RET_FAILURE)
+        return RET_FAILURE;
+
+    return pwrsched->compile();
+}
+
+struct parse_ctx_t {
+    Timer::DaytimeHHMM const
+        * pon_dayt_p,
+        * poff_dayt_p,
+        * kbhit_poff_delay_dayt_p;
+    PwrSched
+        * pwrsched_p;
+    ToneSeq::melody_t const
+        * halfhour_melody_p,
+        * fullhour_melody_p;
+};
+
+static char const *
+    skip_spaces(char const * str)
+{
+    while (*str == ' ' || *str == '\t')
+        str++;
+    return str;
+}
+
+// up to max_digits decimal digits, NULL if none
+static char const *
+    parse_uint(
+        char const * str,
+        unsigned int max_digits,
+        unsigned int & const value)
+{
+    char const * const start = str;
+
+    value = 0;
+    while (*str >= '0' && *str <= '9'
+        && (unsigned int)(str - start) < max_digits)
+        value = value * 10 + (*str++ - '0');
+
+    return str == start ? NULL : str;
+}
+
+// "H:MM" or "HH:MM", minutes after midnight
+static char const *
+    parse_hhmm(char const * str, unsigned int & const day_min)
+{
+    unsigned int hour, minute;
+
+    if ((str = parse_uint(str, 2, hour)) == NULL
+        || *str++ != ':'
+        || (str = parse_uint(str, 2, minute)) == NULL
+        || hour > 23 || minute > 59)
+        return NULL;
+
+    day_min = hour * 60 + minute;
+    return str;
+}
+
+// "HH:MM-HH:MM"
+static char const *
+    parse_hhmm_range(
+        char const * str,
+        unsigned int & const on_min,
+        unsigned int & const off_min)
+{
+    if ((str = parse_hhmm(str, on_min)) == NULL
+        || *str++ != '-')
+        return NULL;
+
+    return parse_hhmm(str, off_min);
+}
+
+static int
+    parse_weekday(char const * const str)
+{
+    for (int i = 0; i < PWRSCHED_DAYS_PER_WEEK; i++)
+        if (strnicmp(str, weekday_names[i], 3) == 0)
+            return i;
+
+    return -1;
+}
+
+// "Mon-Fri", "Sat,Sun", "Fri-Mon,Wed" or "*" for every day
+static char const *
+    parse_weekdays(char const * str, byte_t & const day_mask)
+{
+    day_mask = 0;
+
+    if (*str == '*')
+    {
+        day_mask = PWRSCHED_ALL_DAYS;
+        return str + 1;
+    }
+
+    for (;;)
+    {
+        int first = parse_weekday(str), last = first;
+
+        if (first < 0)
+            return NULL;
+        str += 3;
+
+        if (*str == '-')
+        {
+            last = parse_weekday(++str);
+            if (last < 0)
+                return NULL;
+            str += 3;
+        }
+
+        for (int d = first; ; d = (d + 1) % PWRSCHED_DAYS_PER_WEEK)
+        {
+            day_mask |= 1 << d;
+            if (d == last)
+                break;
+        }
+
+        if (*str != ',')
+            return str;
+        str++;
+    }
+}
+
+static unsigned int
+    is_value_end(char const * const str)
+{
+    return str != NULL && *skip_spaces(str) == '\0';
+}
+
+static Timer::DaytimeHHMM const *
+    parse_dayt(char const * const value)
+{
+    unsigned int day_min;
+
+    if (!is_value_end(parse_hhmm(value, day_min)))
+        return NULL;
+
+    return new (arena) Timer::DaytimeHHMM(0, day_min);
+}
+
+static int
+    parse_TriggerPowerOnAt(char const * const value, parse_ctx_t & const ctx)
+{
+    return (ctx.pon_dayt_p = parse_dayt(value)) ?
+        RET_SUCCESS : RET_FAILURE;
+}
+
+static int
+    parse_TriggerPowerOffAt(char const * const value, parse_ctx_t & const ctx)
+{
+    return (ctx.poff_dayt_p = parse_dayt(value)) ?
+        RET_SUCCESS : RET_FAILURE;
+}
+
+static int
+    parse_PowerOffDelayKbhit(char const * const value, parse_ctx_t & const ctx)
+{
+    return (ctx.kbhit_poff_delay_dayt_p = parse_dayt(value)) ?
+        RET_SUCCESS : RET_FAILURE;
+}
+
+// "<weekdays> HH:MM-HH:MM", may cross midnight
+static int
+    parse_PowerOnWindow(char const * const value, parse_ctx_t & const ctx)
+{
+    byte_t day_mask;
+    unsigned int on_min, off_min;
+    char const * str = parse_weekdays(value, day_mask);
+
+    if (str == NULL
+        || !is_value_end(parse_hhmm_range(skip_spaces(str), on_min, off_min))
+        || on_min == off_min)
+        return RET_FAILURE;
+
+    return ctx.pwrsched_p->add_week_window(day_mask, on_min, off_min);
+}
+
+// "YYYY-MM-DD" (off all day) or "YYYY-MM-DD HH:MM-HH:MM"
+static int
+    parse_PowerOnException(char const * const value, parse_ctx_t & const ctx)
+{
+    unsigned int year, month, mday;
+    unsigned int on_min, off_min;
+    char const * str = value;
+
+    if ((str = parse_uint(str, 4, year)) == NULL || *str++ != '-'
+        || (str = parse_uint(str, 2, month)) == NULL || *str++ != '-'
+        || (str = parse_uint(str, 2, mday)) == NULL
+        || year < 1980 || year > 2099
+        || month < 1 || month > 12
+        || mday < 1 || mday > 31)
+        return RET_FAILURE;
+
+    unsigned int day = PwrSched::days_since_1980(year, month, mday);
+
+    if (is_value_end(str))
+        return ctx.pwrsched_p->add_exception(day);
+
+    if (!is_value_end(parse_hhmm_range(skip_spaces(str), on_min, off_min)))
+        return RET_FAILURE;
+
+    return ctx.pwrsched_p->add_exception_window(day, on_min, off_min);
+}
+
+// "C6" or "C#6" (D#5 .. D#7) or "-" for a rest, then ":<ticks>"
+static char const *
+    parse_note(char const * str, ToneSeq::note_t & const note)
+{
+    static byte_t const
+        semitone[] = { 9, 11, 0, 2, 4, 5, 7 };  // A .. G from C
+    unsigned int ticks;
+
+    if (*str == '-')
+    {
+        note.tone = TONESEQ_REST;
+        str++;
+    }
+    else
+    {
+        char letter = *str++ & ~0x20;   // upper case
+
+        if (letter < 'A' || letter > 'G')
+            return NULL;
+
+        int tone = semitone[letter - 'A'];
+
+        if (*str == '#')
+        {
+            tone++;
+            str++;
+        }
+        if (*str < '0' || *str > '9')
+            return NULL;
+
+        tone += (*str++ - '0') * 12 - PFBIOS_FIRST_TONE_SEMITONE;
+        if (tone < 0 || tone >= PFBIOS_NUM_TONES)
+            return NULL;
+
+        note.tone = tone;
+    }
+
+    if (*str++ != ':'
+        || (str = parse_uint(str, 3, ticks)) == NULL
+        || ticks < 1 || ticks > 255)
+        return NULL;
+
+    note.ticks = ticks;
+    return str;
+}
+
+// up to TONESEQ_MELODY_MAX notes separated by spaces, e.g. "E6:1 C6:1 -:1 G5:2"
+static ToneSeq::melody_t const *
+    parse_melody(char const * str)
+{
+    ToneSeq::melody_t melody;
+
+    melody.nnotes = 0;
+    str = skip_spaces(str);
+
+    while (*str)
+    {
+        if (melody.nnotes == TONESEQ_MELODY_MAX
+            || (str = parse_note(str, melody.notes[melody.nnotes])) == NULL)
+            return NULL;
+
+        melody.nnotes++;
+        str = skip_spaces(str);
+    }
+
+    if (melody.nnotes == 0)
+        return NULL;
+
+    return new (arena) ToneSeq::melody_t(melody);
+}
+
+static int
+    parse_HalfHour(char const * const value, parse_ctx_t & const ctx)
+{
+    return (ctx.halfhour_melody_p = parse_melody(value)) ?
+        RET_SUCCESS : RET_FAILURE;
+}
+
+static int
+    parse_FullHour(char const * const value, parse_ctx_t & const ctx)
+{
+    return (ctx.fullhour_melody_p = parse_melody(value)) ?
+        RET_SUCCESS : RET_FAILURE;
+}
+
+static struct key_handler_t {
+    char const * key;
+    int (* parse)(char const * const, parse_ctx_t & const);
+} const
+    timer_keys[] = {
+        { "TriggerPowerOnAt", parse_TriggerPowerOnAt },
+        { "TriggerPowerOffAt", parse_TriggerPowerOffAt },
+        { "PowerOffDelayKbhit", parse_PowerOffDelayKbhit },
+        { "PowerOnWindow", parse_PowerOnWindow },
+        { "PowerOnException", parse_PowerOnException },
+        { NULL, NULL }
+    },
+    chime_keys[] = {
+        { "HalfHour", parse_HalfHour },
+        { "FullHour", parse_FullHour },
+        { NULL, NULL }
+    };
+
+static void
+    show_error(
+        char const * const what,
+        char const * const str1 = NULL,
+        char const * const str2 = NULL)
+{
+    char s[128];    // iostream is too big for POFO, use string functions
+    strcpy(s, INIFile::ini_filename);
+    strcat(s, what);
+    if (str1)
+    {
+        strncat(s, str1, 40);
+        if (str2)
+        {
+            strcat(s, "': '");
+            strncat(s, str2, 40);
+        }
+        strcat(s, "'");
+    }
+    strcat(s, "\r\n$");
+    PFBios::show_message_earlystage(s);
+}
+
 INIFile::INIFile(
         Timer::DaytimeHHMM const * const pon_dayt_p,
         Timer::DaytimeHHMM const * const poff_dayt_p,
-        Timer::DaytimeHHMM const * const kbhit_poff_delay_dayt_p) :
+        Timer::DaytimeHHMM const * const kbhit_poff_delay_dayt_p,
+        PwrSched * const pwrsched_p,
+        ToneSeq::melody_t const * const halfhour_melody_p,
+        ToneSeq::melody_t const * const fullhour_melody_p) :
         pon_dayt_p(pon_dayt_p),
         poff_dayt_p(poff_dayt_p),
-        kbhit_poff_delay_dayt_p(kbhit_poff_delay_dayt_p)
+        kbhit_poff_delay_dayt_p(kbhit_poff_delay_dayt_p),
+        pwrsched_p(pwrsched_p ? pwrsched_p : new (arena) PwrSched()),
+        halfhour_melody_p(halfhour_melody_p),
+        fullhour_melody_p(fullhour_melody_p)
 {
+    if (!pwrsched_p && this->pwrsched_p) // the daily times only, can't overflow
+        compile_pwrsched(
+            (PwrSched *) this->pwrsched_p, /* casting away const-ness */
+            pon_dayt_p,
+            poff_dayt_p);
+
 #ifdef NTVDM
         cout
             << "INIFile: Power on time [HH:MM]: "
@@ -37,166 +399,116 @@ INIFile::INIFile(
 #endif
 }
 
-INIFile::~INIFile()
-{
-    if (pon_dayt_p)
-        delete (Timer::DaytimeHHMM *) /* casting away const-ness */
-            pon_dayt_p;
-    if (poff_dayt_p)
-        delete (Timer::DaytimeHHMM *) /* casting away const-ness */
-            poff_dayt_p;
-    if (kbhit_poff_delay_dayt_p)
-        delete (Timer::DaytimeHHMM *) /* casting away const-ness */
-        kbhit_poff_delay_dayt_p;
-}
-
 INIFile *
     INIFile::parse()
 {
-    Timer::DaytimeHHMM const
-        * pon_dayt_p = NULL,
-        * poff_dayt_p = NULL,
-        * kbhit_poff_delay_dayt_p = NULL;
+    parse_ctx_t ctx = { NULL, NULL, NULL, NULL, NULL, NULL };
+    int fd;
+    unsigned int nread = 0;
+
+    ctx.pwrsched_p = new (arena) PwrSched();
 
-    ifstream inifile (ini_filename, ios::in);
+    if (!ctx.pwrsched_p)
+        return NULL;
 
-    if (inifile.rdbuf()->is_open())
+    if (_dos_open(ini_filename, O_RDONLY, &fd) == 0)
     {
         unsigned int inifile_error = FALSE;
-        unsigned int issection_timer = FALSE;
-        char * curr_section = NULL;
-        unsigned char line_buf[128] = { '\0' };
-        char * str_tok;
+        key_handler_t const * keys = NULL;  // of the current section
+        char * line = ini_buf;
+
+        // one read for the whole file
+        if (_dos_read(fd, ini_buf, INI_BUF_SIZE, &nread) != 0)
+            nread = 0;
+        _dos_close(fd);
+
+        if (nread == INI_BUF_SIZE)
+        {
+            show_error(": File too big");
+            return NULL;
+        }
+
+        ini_buf[nread] = '\0';
 
-        while (inifile.eof() == 0)
+        while (*line)
         {
-            inifile.getline(line_buf, '\r\n');
+            char * eol = line;
 
-            if (strlen(line_buf) == 0) continue; // ignore empty lines
-            if (line_buf[0] == ';') continue; // ignore comments
+            while (*eol && *eol != '\r' && *eol != '\n')
+                eol++;
+            char * next = *eol ? eol + 1 : eol;
+            *eol = '\0';
 
-            if (line_buf[0] == '['
-                && line_buf[strlen(line_buf) - 1] == ']')
+            if (line[0] == '\0' || line[0] == ';') // ignore empty lines, comments
             {
-                line_buf[strlen(line_buf) - 1] = '\0';
-                if (strcmpi(line_buf + 1, "Timer") == 0)
+                line = next;
+                continue;
+            }
+
+            if (line[0] == '[' && eol[-1] == ']')
+            {
+                eol[-1] = '\0';
+                if (strcmpi(line + 1, "Timer") == 0)
+                {
+                    keys = timer_keys;
+                }
+                else if (strcmpi(line + 1, "Chime") == 0)
                 {
-                    curr_section = "Timer";
-                    issection_timer = TRUE;
+                    keys = chime_keys;
                 }
                 else
                 {
-                    char s[85];
-                    strcpy(s, ini_filename); // iostream is too big for POFO, use string functions
-                    strcat(s, ": Unknown section: '");
-                    strcat(s, line_buf + 1);
-                    strcat(s, "'\r\n$");
-                    PFBios::show_message_earlystage(s);
-
+                    show_error(": Unknown section: '", line + 1);
                     inifile_error = TRUE;
+                    keys = NULL;
                 }
 
+                line = next;
                 continue;
             }
 
-            str_tok = strtok(line_buf, "=");
-            if (str_tok)
+            char * value = strchr(line, '=');
+
+            if (keys && value)
             {
-                if (issection_timer)
+                key_handler_t const * key = keys;
+
+                *value++ = '\0';
+
+                while (key->key && strcmpi(line, key->key) != 0)
+                    key++;
+
+                if (key->key == NULL)
                 {
-                    int iskey_TriggerPowerOnAt = FALSE;
-                    int iskey_TriggerPowerOffAt = FALSE;
-                    int iskey_PowerOffDelayKbhit = FALSE;
-
-                    if (strcmpi(str_tok, "TriggerPowerOnAt") == 0)
-                    {
-                        iskey_TriggerPowerOnAt = TRUE;
-                    }
-                    else if (strcmpi(str_tok, "TriggerPowerOffAt") == 0)
-                    {
-                        iskey_TriggerPowerOffAt = TRUE;
-                    }
-                    else if (strcmpi(str_tok, "PowerOffDelayKbhit") == 0)
-                    {
-                        iskey_PowerOffDelayKbhit = TRUE;
-                    }
-                    else
-                    {
-                        char s[85];
-                        strcpy(s, ini_filename);
-                        strcat(s, ": Unknown key in section '");
-                        strcat(s, curr_section);
-                        strcat(s, "': '");
-                        strcat(s, line_buf);
-                        strcat(s, "'\r\n$");
-                        PFBios::show_message_earlystage(s);
-
-                        inifile_error = TRUE;
-                        continue;
-                    }
-
-                    str_tok = strtok(NULL, "");
-                    if (str_tok)
-                    {
-                        if (iskey_TriggerPowerOnAt
-                            || iskey_TriggerPowerOffAt
-                            || iskey_PowerOffDelayKbhit)
-                        {
-                            int nfields_ok = -1,
-                                inival_hour = -1,
-                                inival_minute = -1;
-
-                            nfields_ok = sscanf(str_tok, "%2u:%2u",
-                                &inival_hour, &inival_minute);
-
-                            if (nfields_ok == 2 &&
-                                inival_hour >= 0 && inival_hour <= 23 &&
-                                inival_minute >= 0 && inival_minute <= 59)
-                            {
-                                if (iskey_TriggerPowerOnAt)
-                                {
-                                    pon_dayt_p = new Timer::DaytimeHHMM
-                                        (inival_hour, inival_minute);
-                                }
-                                else if (iskey_TriggerPowerOffAt)
-                                {
-                                    poff_dayt_p = new Timer::DaytimeHHMM
-                                        (inival_hour, inival_minute);
-                                }
-                                else if (iskey_PowerOffDelayKbhit)
-                                {
-                                    kbhit_poff_delay_dayt_p = new Timer::DaytimeHHMM
-                                        (inival_hour, inival_minute);
-                                }
-                            }
-                            else
-                            {
-                                char s[85];
-                                strcpy(s, ini_filename);
-                                strcat(s, ": Bad value in section '");
-                                strcat(s, curr_section);
-                                strcat(s, "', key '");
-                                strcat(s, line_buf);
-                                strcat(s, "': '");
-                                strcat(s, str_tok);
-                                strcat(s, "'\r\n$");
-                                PFBios::show_message_earlystage(s);
-
-                                inifile_error = TRUE;
-                                continue;
-                            }
-                        }
-                    }
+                    show_error(": Unknown key: '", line);
+                    inifile_error = TRUE;
+                }
+                else if (key->parse(value, ctx) == RET_FAILURE)
+                {
+                    show_error(": Bad value, key '", line, value);
+                    inifile_error = TRUE;
                 }
             }
+
+            line = next;
         }
 
         if (inifile_error)
             return NULL;
     }
 
-    return new INIFile(
-        pon_dayt_p, // moving ownership to new object
-        poff_dayt_p,
-        kbhit_poff_delay_dayt_p);
+    if (compile_pwrsched(
+            ctx.pwrsched_p, ctx.pon_dayt_p, ctx.poff_dayt_p) == RET_FAILURE)
+    {
+        show_error(": Too many power on windows or exceptions");
+        return NULL;
+    }
+
+    return new (arena) INIFile(
+        ctx.pon_dayt_p,
+        ctx.poff_dayt_p,
+        ctx.kbhit_poff_delay_dayt_p,
+        ctx.pwrsched_p,
+        ctx.halfhour_melody_p,
+        ctx.fullhour_melody_p);
 }
@@ -9,27 +9,56 @@
 #define _INIFILE_H 1
 
 #include "timer.h"
+#include "pwrsched.h"
+#include "toneseq.h"
 
 class INIFile
 {
+public:
+    struct cache_key_t {        // of the INI file the cache was built from
+        unsigned long ini_size;
+        unsigned int ini_date;  // DOS packed
+        unsigned int ini_time;
+        unsigned int ini_checksum;  // Fletcher-16 of the contents
+    };
+
+private:
     static char const * const
-        ini_filename;
+        cache_filename;
+
+    static int
+        read_cache_key(cache_key_t & const);
+    static INIFile *
+        load_cache(cache_key_t const & const);
+    void
+        save_cache(cache_key_t const & const) const;
 
 public:
+    static char const * const
+        ini_filename;
+
     Timer::DaytimeHHMM const // using pointers for nullability
         * const pon_dayt_p,
         * const poff_dayt_p,
         * const kbhit_poff_delay_dayt_p;
+    PwrSched const
+        * const pwrsched_p;     // compiled power on / off schedule
+    ToneSeq::melody_t const
+        * const halfhour_melody_p,  // NULL for a random tone
+        * const fullhour_melody_p;
 
     INIFile(
         Timer::DaytimeHHMM const * const,
         Timer::DaytimeHHMM const * const,
-        Timer::DaytimeHHMM const * const);
-
-    ~INIFile();
+        Timer::DaytimeHHMM const * const,
+        PwrSched * const = NULL,    // placed in the arena, never deleted
+        ToneSeq::melody_t const * const = NULL,
+        ToneSeq::melody_t const * const = NULL);
 
     static INIFile *
         parse();
+    static INIFile *
+        load();
 };
 
 #endif
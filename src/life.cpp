@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "life.h"
+
+#include <stdlib.h>
+#include <mem.h>
+
+unsigned int
+    Life::generation = 0;
+
+// video RAM has the leftmost pixel in bit 7 of the lower byte,
+// the field words have it in bit 15
+static word_t
+    swapped(word_t const w)
+{
+    return w << BITS_PER_BYTE | w >> BITS_PER_BYTE;
+}
+
+static word_t
+    random_word(void)
+{
+    return rand() << 1 ^ rand();    // rand() gives 15 bits
+}
+
+void Life::load(word_t * const cells, int x_offs, unsigned int y)
+{
+    word_t far * const vram_row = Graph::animw_row(x_offs, y);
+
+    for (unsigned int x = 0; x < ANIMW_WIDTH_W; x++)
+        cells[x] = swapped(vram_row[x]);
+}
+
+void Life::seed(int x_offs)
+{
+    generation = 0;
+
+    for (unsigned int y = 0; y < ANIMW_HEIGHT; y++)
+    {
+        word_t far * const vram_row = Graph::animw_row(x_offs, y);
+
+        // 3 of 8 cells alive
+        for (unsigned int x = 0; x < ANIMW_WIDTH_W; x++)
+            vram_row[x] = (random_word() | random_word()) & random_word();
+    }
+}
+
+word_t Life::step_row(
+    int x_offs,
+    unsigned int y,
+    word_t const * const above,
+    word_t const * const self,
+    word_t const * const below)
+{
+    word_t far * const vram_row = Graph::animw_row(x_offs, y);
+    word_t changed = 0;
+
+    for (unsigned int x = 0; x < ANIMW_WIDTH_W; x++)
+    {
+        unsigned int const l = x ? x - 1 : ANIMW_WIDTH_W - 1;
+        unsigned int const r = x + 1 < ANIMW_WIDTH_W ? x + 1 : 0;
+
+        // neighbours to the west and the east, a word over the edges
+        word_t const a = above[x];
+        word_t const a_w = a >> 1 | above[l] << 15;
+        word_t const a_e = a << 1 | above[r] >> 15;
+        word_t const b = self[x];
+        word_t const b_w = b >> 1 | self[l] << 15;
+        word_t const b_e = b << 1 | self[r] >> 15;
+        word_t const c = below[x];
+        word_t const c_w = c >> 1 | below[l] << 15;
+        word_t const c_e = c << 1 | below[r] >> 15;
+
+        // rows above and below: full adders of three, own row: half adder
+        word_t const s_a = a_w ^ a ^ a_e;
+        word_t const k_a = (a_w & a) | ((a_w ^ a) & a_e);
+        word_t const s_c = c_w ^ c ^ c_e;
+        word_t const k_c = (c_w & c) | ((c_w ^ c) & c_e);
+        word_t const s_b = b_w ^ b_e;
+        word_t const k_b = b_w & b_e;
+
+        // count = ones + 2 * (k_a + k_b + k_c + k_1)
+        word_t const ones = s_a ^ s_b ^ s_c;
+        word_t const k_1 = (s_a & s_b) | ((s_a ^ s_b) & s_c);
+        word_t const t = k_a ^ k_b ^ k_c;
+        word_t const twos = t ^ k_1;
+        word_t const fours =    // four or more
+            (k_a & k_b) | ((k_a ^ k_b) & k_c) | (t & k_1);
+
+        // born with 3, survives with 2 or 3
+        word_t const next = twos & ~fours & (ones | b);
+
+        changed |= next ^ b;
+        vram_row[x] = swapped(next);
+    }
+
+    return changed;
+}
+
+int Life::step_finished(int x_offs)
+{
+    word_t rows[3][ANIMW_WIDTH_W];
+    word_t first[ANIMW_WIDTH_W];    // row 0 as it was, below the last one
+    word_t * above = rows[0];
+    word_t * self = rows[1];
+    word_t * below = rows[2];
+    word_t changed = 0;
+
+    // rows are stepped in place, the neighbours come from the copies
+    load(above, x_offs, ANIMW_HEIGHT - 1);
+    load(self, x_offs, 0);
+    memcpy(first, self, sizeof first);
+
+    for (unsigned int y = 0; y < ANIMW_HEIGHT; y++)
+    {
+        if (y + 1 < ANIMW_HEIGHT)
+            load(below, x_offs, y + 1);
+        else
+            below = first;
+
+        changed |= step_row(x_offs, y, above, self, below);
+
+        word_t * const spare = above;
+
+        above = self;
+        self = below;
+        below = spare;
+    }
+
+    return ++generation >= LIFE_GENERATIONS || !changed;
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Game of Life in the animation window, bit-parallel
+ *
+ * The field is the window in video RAM itself, a bit per cell, wrapping
+ * around at the edges. A generation goes a row at a time, 16 cells per
+ * word: the eight neighbour planes (the rows above, beside and below,
+ * shifted by a cell) are summed by bitwise adders into the bits of the
+ * neighbour counts, the rule is a few ANDs of those.
+ */
+
+#ifndef _LIFE_H
+#define _LIFE_H 1
+
+#include "graph.h"
+
+#define LIFE_GENERATIONS 96     // at most, a still field ends it earlier
+
+class Life
+{
+    static unsigned int
+        generation;
+
+    static void
+        load(word_t * const, int, unsigned int);
+    static word_t
+        step_row(int, unsigned int,
+            word_t const * const,
+            word_t const * const,
+            word_t const * const);
+
+public:
+    static void
+        seed(int);
+    static int
+        step_finished(int);
+};
+
+#endif
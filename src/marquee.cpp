@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "marquee.h"
+
+#include <dos.h>
+#include <io.h>
+#include <fcntl.h>
+#include <stdio.h>
+
+char const * const
+    Marquee::txt_filename = "PFWALLCL.TXT";
+
+unsigned char
+    Marquee::chunk[MARQUEE_CHUNK];
+unsigned int
+    Marquee::chunk_len = 0,
+    Marquee::chunk_pos = 0;
+unsigned long
+    Marquee::file_offs = 0;
+
+unsigned int
+    Marquee::glyph = 0,
+    Marquee::column = 0,
+    Marquee::tail_cols = 0;
+
+unsigned int Marquee::read_chunk(void)
+{
+    int fd;
+    unsigned int nread = 0;
+
+    chunk_len = 0;
+    chunk_pos = 0;
+
+    // opened for each chunk, no handle is kept over a power-off
+    if (_dos_open(txt_filename, O_RDONLY, &fd) != 0)
+        return 0;
+
+    if (lseek(fd, file_offs, SEEK_SET) != -1l &&
+        _dos_read(fd, chunk, sizeof chunk, &nread) == 0)
+    {
+        chunk_len = nread;
+        file_offs += nread;
+    }
+
+    _dos_close(fd);
+
+    return chunk_len;
+}
+
+int Marquee::next_char(void)
+{
+    for (;;)
+    {
+        if (chunk_pos == chunk_len && read_chunk() == 0)
+        {
+            file_offs = 0;      // the next message from the start
+            return MARQUEE_EOM;
+        }
+
+        unsigned char c = chunk[chunk_pos++];
+
+        if (c == '\r')
+            continue;
+        if (c == '\n')
+            return MARQUEE_EOM; // end of the message
+        if (c == '\t')
+            c = ' ';
+
+        return c;
+    }
+}
+
+int Marquee::start(void)
+{
+    int c = next_char();
+
+    for (unsigned int skipped = 0;
+        c == MARQUEE_EOM && skipped < MARQUEE_SKIP_MAX;
+        skipped++)
+        c = next_char();
+
+    if (c == MARQUEE_EOM)
+        return RET_FAILURE;     // no file, or nothing in it
+
+    glyph = FntSmall::glyph(c);
+    column = 0;
+    tail_cols = 0;
+
+    return RET_SUCCESS;
+}
+
+void Marquee::scroll_row(word_t far * const vram_row, unsigned int const pixel)
+{
+#ifndef HOSTSIM
+  asm {
+    push ds
+    push si
+    push cx
+    push dx
+    mov  dx,pixel
+    lds  si,vram_row
+    add  si,(ANIMW_WIDTH_W - 1) * 2     // rightmost word first
+    mov  cx,ANIMW_WIDTH_W
+    shr  dx,1           // CF = the pixel shifted in
+  }
+scroll_1:
+  asm {
+    mov  ax,[si]
+    xchg ah,al          // leftmost pixel of the word to bit 15
+    rcl  ax,1           // CF in from the right, out to the left
+    xchg ah,al
+    mov  [si],ax
+    dec  si             // dec and loop keep CF
+    dec  si
+    loop scroll_1
+
+    pop  dx
+    pop  cx
+    pop  si
+    pop  ds
+  }
+#else // #ifdef HOSTSIM
+    unsigned int carry = pixel;
+
+    for (int x = ANIMW_WIDTH_W - 1; x >= 0; x--)
+    {
+        word_t w = vram_row[x] << BITS_PER_BYTE | vram_row[x] >> BITS_PER_BYTE;
+        unsigned int out = w >> 15;
+
+        w = w << 1 | carry;
+        vram_row[x] = w << BITS_PER_BYTE | w >> BITS_PER_BYTE;
+        carry = out;
+    }
+#endif
+}
+
+int Marquee::step_finished(int x_offs)
+{
+    // a font column, MARQUEE_SCALE pixels wide
+    for (unsigned int r = 0; r < FNT_SMALL_HEIGHT; r++)
+    {
+        unsigned int pixel =
+            column < FNT_SMALL_WIDTH ?
+                glyph >>
+                    ((FNT_SMALL_HEIGHT - 1 - r) * 3 +
+                    FNT_SMALL_WIDTH - 1 - column) & 1 :
+                0;
+
+        for (unsigned int sy = 0; sy < MARQUEE_SCALE; sy++)
+        {
+            word_t far * const vram_row =
+                Graph::animw_row(x_offs, MARQUEE_Y + r * MARQUEE_SCALE + sy);
+
+            for (unsigned int sx = 0; sx < MARQUEE_SCALE; sx++)
+                scroll_row(vram_row, pixel);
+        }
+    }
+
+    if (tail_cols)
+        return --tail_cols == 0;
+
+    if (++column < FNT_SMALL_ADVANCE)
+        return FALSE;
+
+    column = 0;
+
+    int c = next_char();
+
+    if (c != MARQUEE_EOM)
+    {
+        glyph = FntSmall::glyph(c);
+    }
+    else
+    {
+        glyph = 0;              // blank till the message is out
+        tail_cols = ANIMW_WIDTH / MARQUEE_SCALE;
+    }
+
+    return FALSE;
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Text marquee in the animation window
+ *
+ * Messages, a line each, come from PFWALLCL.TXT next to the INI file,
+ * read a small chunk at a time from where the last one ended; a run
+ * scrolls one message through the window, the next run the next one,
+ * the end of the file wraps to its start. A step shifts the text rows
+ * a pixel to the left by a carry chain over the row's words and the
+ * pixel shifted in is the newly exposed column of the small font, so
+ * a step costs the same whatever the length of the text.
+ */
+
+#ifndef _MARQUEE_H
+#define _MARQUEE_H 1
+
+#include "graph.h"
+#include "fntsmall.h"
+
+#define MARQUEE_CHUNK 32        // bytes read at a time
+#define MARQUEE_SCALE 2         // pixels a font pixel, either way
+#define MARQUEE_HEIGHT (FNT_SMALL_HEIGHT * MARQUEE_SCALE)
+#define MARQUEE_Y ((ANIMW_HEIGHT - MARQUEE_HEIGHT) / 2)
+#define MARQUEE_SKIP_MAX 8      // empty lines passed over looking for a message
+#define MARQUEE_EOM (-1)        // next_char() past the message, no byte is
+
+class Marquee
+{
+    static char const * const
+        txt_filename;
+
+    static unsigned char
+        chunk[MARQUEE_CHUNK];
+    static unsigned int
+        chunk_len,
+        chunk_pos;
+    static unsigned long
+        file_offs;              // where the next chunk starts
+
+    static unsigned int
+        glyph;                  // the char coming in, 0 past the message
+    static unsigned int
+        column;                 // of the glyph, FNT_SMALL_ADVANCE of them
+    static unsigned int
+        tail_cols;              // left to scroll the message out
+
+    static unsigned int
+        read_chunk(void);
+    static int
+        next_char(void);
+    static void
+        scroll_row(word_t far * const, unsigned int const);
+
+public:
+    static int
+        start(void);
+    static int
+        step_finished(int);
+};
+
+#endif
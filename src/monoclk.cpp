@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "monoclk.h"
+
+#define US_PER_SEC 1000000l
+
+unsigned long volatile
+    MonoClock::ticked_us = 0;
+
+void MonoClock::tick(unsigned int period_sec)
+{
+    // the period set now, also for the tick that ends a longer one
+    ticked_us += period_sec * US_PER_SEC;
+}
+
+unsigned long MonoClock::now_us(void)
+{
+    unsigned long us;
+
+    do  // again if a tick landed between the two word reads
+        us = ticked_us;
+    while (us != ticked_us);
+
+    return us;
+}
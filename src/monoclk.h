@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Monotonic microsecond clock
+ *
+ * Int 1Ch, 1 s or 128 s apart as set with the clockspeed, is the only
+ * periodic interrupt: the PIT counter wraps every ~55 ms, but no IRQ 0
+ * counts the wraps (the BIOS tick count at 0040:006Ch doesn't move
+ * with them, else no hlt would last a second). So the clock advances
+ * by a whole tick period on every tick, and that is its resolution:
+ * a single time shorter than a period reads as 0 or one period, only
+ * sums over many periods mean anything. The value wraps every ~71
+ * minutes, take differences.
+ */
+
+#ifndef _MONOCLK_H
+#define _MONOCLK_H 1
+
+#include "common.h"
+
+class MonoClock
+{
+    static unsigned long volatile
+        ticked_us;
+
+public:
+    static void
+        tick(unsigned int);     // tick interrupt handler only, period in s
+    static unsigned long
+        now_us(void);
+};
+
+#endif
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "msgbox.h"
+#include "fntsmall.h"
+#if defined(TELEMETRY) || defined(PROFILE)
+#include "pit.h"
+#endif
+
+#include <mem.h>
+#include <string.h>
+
+#ifdef NTVDM
+#include <iostream.h>
+#endif
+
+#define MSGBOX_TITLE_Y 2
+#define MSGBOX_SEPARATOR_Y 8
+#define MSGBOX_BODY_Y 10
+
+static byte_t
+    save_under[MSGBOX_HEIGHT * MSGBOX_WIDTH_B];
+
+static byte_t far *
+    box_row(unsigned int y)
+{
+    return
+        (*Graph::vram_cga_evenscanlines.ptr_union.arr_b)[MSGBOX_Y + y] +
+        MSGBOX_X_B;
+}
+
+MsgBox::MsgBox() :
+    msg(NULL),
+    due_sec(0),
+    shown(FALSE),
+    stamped(FALSE)
+{
+}
+
+void MsgBox::show(char const * msg, unsigned long now_sec)
+{
+#ifdef NTVDM
+    cout
+        << "MsgBox: "
+        << msg              // message title
+        << ": ";
+    while (*msg++ != NULL); // move to the next string
+    cout
+        << msg              // message body
+        << endl;
+#else
+    unstamp();              // replacing a box still shown
+
+    this->msg = msg;
+    due_sec = now_sec + MSGBOX_TIMEOUT_SEC;
+    shown = TRUE;
+#endif
+}
+
+void MsgBox::hide(void)
+{
+    unstamp();
+    shown = FALSE;
+}
+
+unsigned int MsgBox::is_shown(void) const
+{
+    return shown;
+}
+
+unsigned int MsgBox::is_expired(unsigned long now_sec) const
+{
+    return shown && now_sec >= due_sec;
+}
+
+void MsgBox::stamp(void)
+{
+    if (!shown || stamped)
+        return;
+
+    for (unsigned int y = 0; y < MSGBOX_HEIGHT; y++)
+        _fmemcpy(save_under + y * MSGBOX_WIDTH_B, box_row(y), MSGBOX_WIDTH_B);
+
+    draw_frame();
+#if defined(TELEMETRY) || defined(PROFILE)
+    PitStopwatch::sample_running();
+#endif
+    draw_text(MSGBOX_TITLE_Y, msg);
+    draw_text(MSGBOX_BODY_Y, msg + strlen(msg) + 1);
+#if defined(TELEMETRY) || defined(PROFILE)
+    PitStopwatch::sample_running();
+#endif
+
+    stamped = TRUE;
+}
+
+void MsgBox::unstamp(void)
+{
+    if (!stamped)
+        return;
+
+    for (unsigned int y = 0; y < MSGBOX_HEIGHT; y++)
+        _fmemcpy(box_row(y), save_under + y * MSGBOX_WIDTH_B, MSGBOX_WIDTH_B);
+
+    stamped = FALSE;
+}
+
+void MsgBox::draw_frame(void)
+{
+    for (unsigned int y = 0; y < MSGBOX_HEIGHT; y++)
+    {
+        byte_t far * row = box_row(y);
+
+        if (y == 0 || y == MSGBOX_SEPARATOR_Y || y == MSGBOX_HEIGHT - 1)
+        {
+            _fmemset(row, 0xff, MSGBOX_WIDTH_B);
+        }
+        else
+        {
+            _fmemset(row, 0, MSGBOX_WIDTH_B);
+            row[0] = 0x80;
+            row[MSGBOX_WIDTH_B - 1] = 0x01;
+        }
+    }
+}
+
+void MsgBox::draw_text(unsigned int y, char const * str)
+{
+    unsigned int len = MIN(strlen(str), MSGBOX_TEXT_CHARS);
+
+    // centered, whole bytes only, two chars a byte
+    unsigned int x_b = 1 + (MSGBOX_TEXT_CHARS - len) / 4;
+
+    for (unsigned int r = 0; r < FNT_SMALL_HEIGHT; r++)
+    {
+        byte_t far * row = box_row(y + r) + x_b;
+        unsigned int shift = (FNT_SMALL_HEIGHT - 1 - r) * 3;
+
+        for (unsigned int i = 0; i < len; i++)
+        {
+            // 3 pixels and a gap in a nibble
+            byte_t nibble = ((FntSmall::glyph(str[i]) >> shift) & 7) << 1;
+
+            if (i & 1)
+                row[i / 2] |= nibble;
+            else
+                row[i / 2] = nibble << 4;
+        }
+    }
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Message box drawn over the graphics screen
+ *
+ * Stays in CGA mode: the box is stamped into the frame buffer with
+ * a small built-in font, the area underneath is saved and put back
+ * when the box goes away, on a key or after a timeout.
+ */
+
+#ifndef _MSGBOX_H
+#define _MSGBOX_H 1
+
+#include "graph.h"
+#include "common.h"
+
+#define MSGBOX_TIMEOUT_SEC 8
+#define MSGBOX_WIDTH_B 26
+#define MSGBOX_HEIGHT 17
+#define MSGBOX_X_B 2            // bytes from the left screen border
+#define MSGBOX_Y ((DISPL_YRES - MSGBOX_HEIGHT) / 2)
+#define MSGBOX_TEXT_CHARS ((MSGBOX_WIDTH_B - 2) * 2)   // 4 pixels per char
+
+class MsgBox
+{
+    char const *
+        msg;                    // title '\0' body '\0'
+    unsigned long
+        due_sec;                // Timer clock
+    unsigned int
+        shown : 1,
+        stamped : 1;            // box in the frame buffer, area saved
+
+    void
+        draw_frame(void);
+    void
+        draw_text(unsigned int, char const *);
+
+public:
+    MsgBox();
+
+    void
+        show(char const *, unsigned long);
+    void
+        hide(void);
+    unsigned int
+        is_shown(void) const;
+    unsigned int
+        is_expired(unsigned long) const;
+    void
+        stamp(void);
+    void
+        unstamp(void);
+};
+
+#endif
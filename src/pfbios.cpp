@@ -6,10 +6,17 @@
  */
 
 #include "pfbios.h"
+#ifdef BIOSTRACE
+#include "biostrc.h"
+#endif
 
 #include <stdlib.h>
 #include <dos.h>
 
+#ifdef HOSTSIM
+#include <string.h>
+#endif
+
 #ifdef NTVDM
 #include <graphics.h>
 #include <iostream.h>
@@ -21,19 +28,11 @@
 #define BIOS_TIME_SERVICE 1Ah
 #define READ_RTC_TIME 02h
 
-#define MSGBOX_XPOS 1
-#define MSGBOX_YPOS 2
 /*
- * | | TEXT.TEXT.TEXT.TEXT.TEXT.TEXT.TEXT | |
- * | | |                                | | |
- * | | |                                | | |
- * Left Screen Border                   | | |
- *   Left Double Line (MSGBOX_XPOS)     | | |
- *     Start Of Text Message            | | |
- *                                      | | |
- *                   End Of Text Message  | |
- *                       Right Double Line  |
- *                        Right Screen Border
+ * MsgBox texts: title '\0' body '\0'
+ *
+ * The rulers mark the width the texts were kept to, that of the BIOS
+ * message box they were shown in before; well within MSGBOX_TEXT_CHARS.
  */
 char const * const
     PFBios::msg_clockspeed_fast =
@@ -49,6 +48,13 @@ char const * const
     //   | | TEXT.TEXT.TEXT.TEXT.TEXT.TEXT.TEXT | |
             "Clock Speed now in NORMAL mode."
             "\0";
+char const * const
+    PFBios::msg_clockspeed_auto =
+            "Clock Speed Change"
+            "\0"
+    //   | | TEXT.TEXT.TEXT.TEXT.TEXT.TEXT.TEXT | |
+            "Clock Speed now in AUTO mode."
+            "\0";
 char const * const
     PFBios::msg_poweroff_delay_override_deact =
             "Power Off Delay"
@@ -64,8 +70,8 @@ char const * const
             "Will power off in 1 hour."
             "\0";
 #define MSG_POWEROFF_DELAY_N_OFFS 36
-char * const
-    PFBios::msg_poweroff_delay_h =
+char
+    PFBios::msg_poweroff_delay_h[] =   // not a literal, N is patched in
             "Power Off Delayed"
             "\0"
     //   | | TEXT.TEXT.TEXT.TEXT.TEXT.TEXT.TEXT | |
@@ -78,7 +84,20 @@ char const * const
     PFBios::msg_err_bios_ver =
             "Unsupported BIOS version. Try with argument 'untested'.$";
 
-const byte_t tone_code[] = {
+unsigned int const
+    PFBios::clockspeed_tick_sec[] = {
+        128,    // clockspeed_normal
+        1,      // clockspeed_fast
+};
+
+/*
+ * Tone generator, written as Int 61h Fn 16h (Melody Tone Generator)
+ * does but without waiting for the tone to end; 0 switches it off
+ */
+#define PORT_TONE_GEN 0x8020
+
+static byte_t const
+    tone_code[PFBIOS_NUM_TONES] = {
         0x30,  //  D#5  622.3 Hz
         0x31,  //  E-5  659.3 Hz
         0x32,  //  F-5  698.5 Hz
@@ -106,10 +125,51 @@ const byte_t tone_code[] = {
         0x07,  //  D#7  2489.0 Hz
 };
 
+#ifdef NTVDM
+static unsigned int const
+    tone_hz[PFBIOS_NUM_TONES] = {
+        622, 659, 699, 740, 784, 831, 881, 932, 988,
+        1047, 1109, 1175, 1245, 1319, 1397, 1480, 1569, 1661, 1760, 1865, 1976,
+        2093, 2218, 2349, 2489,
+};
+#endif
+
+// callers clear the registers they don't set, the trace copies them all
+void PFBios::bios_int86(int intno, union REGS * const regs)
+{
+#ifdef BIOSTRACE
+    union REGS in = * regs;
+    BiosTrace::begin();
+#endif
+    int86(intno, regs, regs);
+#ifdef BIOSTRACE
+    BiosTrace::end(intno, in.x.ax, in.x.bx, in.x.cx, in.x.dx);
+#endif
+}
+
+void PFBios::bios_intr(int intno, struct REGPACK * const regpack)
+{
+#ifdef BIOSTRACE
+    struct REGPACK in = * regpack;
+    BiosTrace::begin();
+#endif
+    intr(intno, regpack);
+#ifdef BIOSTRACE
+    BiosTrace::end(intno, in.r_ax, in.r_bx, in.r_cx, in.r_dx);
+#endif
+}
+
 #pragma warn -rvl
 int
     PFBios::check_machinetype(void)
 {
+#ifdef HOSTSIM
+    // Int 21h, Fn 35h - Get Interrupt Vector
+    struct REGPACK regpack = { 0 };
+    regpack.r_ax = 0x3561;
+    bios_intr(0x21, &regpack);
+    return regpack.r_es == 0;
+#else // #ifndef HOSTSIM
 #ifndef NTVDM
     // check presence of interrupt handler 0x61
     asm {
@@ -127,6 +187,7 @@ int
         mov ax, 0
     }
     end:
+#endif
 }
 #pragma warn +rvl
 
@@ -134,6 +195,14 @@ int
 int
     PFBios::check_biosver(void)
 {
+#ifdef HOSTSIM
+    // Int 61h, Fn 2Ch - Get Bios version number
+    struct REGPACK regpack = { 0 };
+    regpack.r_ax = 0x2c << BITS_PER_BYTE;
+    bios_intr(0x61, &regpack);
+    return strncmp((char far *) MK_FP (0xe000, regpack.r_bx), "1.052", 5) ?
+        2 : 0;
+#else // #ifndef HOSTSIM
     asm {
         push ds
         push bx
@@ -179,6 +248,7 @@ int
         pop bx
         pop ds
     }
+#endif
 }
 #pragma warn +rvl
 
@@ -187,19 +257,19 @@ void
 {
 #ifndef NTVDM
     // Int 61h, Fn 00h - Service Initialization
-    struct REGPACK regpack;
+    struct REGPACK regpack = { 0 };
     regpack.r_ax = 0;
-    intr (0x61, &regpack);
+    bios_intr(0x61, &regpack);
 #endif
 }
 
 void PFBios::set_videomode(byte_t mode)
 {
 #ifndef NTVDM
-    union REGS regs;
+    union REGS regs = { 0 };
     regs.h.ah = INT10_SETMODE;
     regs.h.al = mode;
-    int86(BIOS_VIDEO_SERVICE, &regs, &regs);
+    bios_int86(BIOS_VIDEO_SERVICE, &regs);
 #else // #ifdef NTVDM
     if (mode == VIDMODE_CGA640x200BW)
     {
@@ -219,8 +289,22 @@ void PFBios::read_rtc_time(
     byte_t & const hour_tens,
     byte_t & const hour_ones,
     byte_t & const minute_tens,
-    byte_t & const minute_ones)
+    byte_t & const minute_ones,
+    byte_t & const second)
 {
+#ifdef HOSTSIM
+    union REGS regs = { 0 };
+    regs.h.ah = 0x02;               // read RTC time (BCD)
+    bios_int86(0x1a, &regs);        // BIOS Timer/Clock Service
+    hour_tens = regs.h.ch >> 4;
+    hour_ones = regs.h.ch & 0x0f;
+    minute_tens = regs.h.cl >> 4;
+    minute_ones = regs.h.cl & 0x0f;
+    second = regs.h.dh;
+#else // #ifndef HOSTSIM
+#ifdef BIOSTRACE
+    BiosTrace::begin();
+#endif
     asm {
         push ax
         push bx
@@ -255,16 +339,25 @@ void PFBios::read_rtc_time(
         mov bx, word ptr minute_ones
         mov byte ptr [bx], al
 
+        mov bx, word ptr second
+        mov byte ptr [bx], dh   // seconds in BCD
+
         pop bx
         pop ax
     }
+#ifdef BIOSTRACE
+    BiosTrace::end(0x1a, 0x02 << BITS_PER_BYTE, 0, 0, 0);
+#endif
+#endif
+
+    second = (second >> 4) * 10 + (second & 0x0f);
 }
 
 void PFBios::reset_rtc_alarm(void)
 {
-    union REGS regs;
+    union REGS regs = { 0 };
     regs.h.ah = 0x07;               // reset RTC alarm (not implemented in Dosbox)
-    int86 (0x1a, &regs, &regs);     // BIOS Timer/Clock Service
+    bios_int86(0x1a, &regs);        // BIOS Timer/Clock Service
 }
 
 void PFBios::set_rtc_alarm(
@@ -282,29 +375,29 @@ void PFBios::set_rtc_alarm(
         << minute
         << "\n";
 #endif
-    union REGS regs;
+    union REGS regs = { 0 };
     regs.h.ch = dec2bcd(hour);      // hours (BCD)
     regs.h.cl = dec2bcd(minute);    // minutes (BCD)
     regs.h.dh = 0;                  // seconds (BCD)
     regs.h.ah = 0x06;               // set RTC alarm (not implemented in Dosbox)
-    int86 (0x1a, &regs, &regs);     // BIOS Timer/Clock Service
+    bios_int86(0x1a, &regs);        // BIOS Timer/Clock Service
 }
 
-void PFBios::beep_rndtone(void)
+void PFBios::tone_on(byte_t tone)     // interrupt handlers too
 {
 #ifndef NTVDM
-    // Int 61h, Fn 16h - Melody Tone Generator
-    union REGS regs;
-    regs.h.ah = 0x16;
-    regs.x.cx = 20;                 // Length of tone in 10 ms intervals
-    regs.h.dl = rand() % sizeof(tone_code) / 2 + sizeof(tone_code) / 2; // Rand tone code
-    int86 (0x61, &regs, &regs);
+    outportb(PORT_TONE_GEN, tone_code[tone]);
+#else // #ifdef NTVDM
+    sound(tone_hz[tone]);
+#endif
+}
 
+void PFBios::tone_off(void)
+{
+#ifndef NTVDM
+    outportb(PORT_TONE_GEN, 0);
 #else // #ifdef NTVDM
-    sound(rand() % 7000);
-    delay(100);
     nosound();
-
 #endif
 }
 
@@ -315,10 +408,10 @@ void PFBios::set_clockspeed(PFBios::clockspeed_t clockspeed)
 {
 #ifndef NTVDM
     // Int 61h, Fn 1Eh - Get/Set Clock Tick Speed
-    struct REGPACK regpack;
+    struct REGPACK regpack = { 0 };
     regpack.r_ax = 0x1e << 8 | 1;
     regpack.r_bx = clockspeed;
-    intr (0x61, &regpack);
+    bios_intr(0x61, &regpack);
 #endif
 }
 
@@ -326,9 +419,9 @@ PFBios::clockspeed_t PFBios::get_clockspeed(void)
 {
 #ifndef NTVDM
     // Int 61h, Fn 1Eh - Get/Set Clock Tick Speed
-    struct REGPACK regpack;
+    struct REGPACK regpack = { 0 };
     regpack.r_ax = 0x1e << 8 | 0;
-    intr (0x61, &regpack);
+    bios_intr(0x61, &regpack);
 
     if (regpack.r_bx == PFBios::clockspeed_normal)
         return PFBios::clockspeed_normal;
@@ -347,57 +440,19 @@ void
 {
 #ifndef NTVDM
     // Int 60h, Fn 0Fh - Get/Set Cursor Mode
-    struct REGPACK regpack;
+    struct REGPACK regpack = { 0 };
     regpack.r_bx = mode;                        // BL - New Cursor Mode
     regpack.r_ax = 0x0f << BITS_PER_BYTE | 1;   // AL:1 - Set Mode
-    intr (0x61, &regpack);
+    bios_intr(0x61, &regpack);
 #endif
 }
 
-void
-    PFBios::show_message_box(
-        char const * msg)
-{
-#ifndef NTVDM
-    set_videomode(VIDMODE_MDATEXT80x25);
-
-    // Int 60h, Fn 12h - Show message box
-    struct REGPACK regpack;
-    regpack.r_bx =
-        0 << BITS_PER_BYTE | 0; // BH - Video page number
-    regpack.r_dx =
-        MSGBOX_YPOS << BITS_PER_BYTE |
-        MSGBOX_XPOS;            // DH - Y position (max 8), DL - X position (max 40)
-    regpack.r_ds = FP_SEG(msg);
-    regpack.r_si = FP_OFF(msg);
-    regpack.r_ax = 0x12 << BITS_PER_BYTE;
-    intr (0x60, &regpack);
-
-    asm {
-        // wait for keypress
-        mov ah, 0
-        int 16h
-    }
-
-    set_videomode(VIDMODE_CGA640x200BW);
-#else // #ifdef NTVDM
-    cout
-        << "PFBios: "
-        << msg              // message title
-        << ": ";
-    while (*msg++ != NULL); // move to the next string
-    cout
-        << msg              // message body
-        << endl;
-#endif
-}
-
-void
-    PFBios::show_message_box_poweroff_delay_h(
+char const *
+    PFBios::get_msg_poweroff_delay_h(
         unsigned int intnum)
 {
     msg_poweroff_delay_h[MSG_POWEROFF_DELAY_N_OFFS] = '0' + intnum;
-    show_message_box(msg_poweroff_delay_h);
+    return msg_poweroff_delay_h;
 }
 
 void
@@ -405,20 +460,20 @@ void
         char const * const msg)
 {
     // Int 21h, Fn 09h - Print String
-    struct REGPACK regpack;
+    struct REGPACK regpack = { 0 };
     regpack.r_ax = 0x09 << BITS_PER_BYTE;
     regpack.r_ds = FP_SEG (msg);
     regpack.r_dx = FP_OFF (msg);
-    intr (0x21, &regpack);
+    bios_intr(0x21, &regpack);
 }
 
 void PFBios::poweroff(void)
 {
 #ifndef NTVDM
     // Int 61h, Fn 2Dh - Turn System Off
-    struct REGPACK regpack;
+    struct REGPACK regpack = { 0 };
     regpack.r_ax = 0x2d << 8 | 0;
-    intr (0x61, &regpack);
+    bios_intr(0x61, &regpack);
 #else
     cout
         << "PFBios: Power off now.\n";
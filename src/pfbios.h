@@ -15,8 +15,13 @@
 #define CURSOR_MODE_UNDERLINE 1
 #define CURSOR_MODE_BLOCK 2
 
+#define PFBIOS_NUM_TONES 25     // D#5 .. D#7, semitones
+#define PFBIOS_FIRST_TONE_SEMITONE (5 * 12 + 3) // D#5, counting from C0
+
 #include "common.h"
 
+#include <dos.h>
+
 class PFBios
 {
 public:
@@ -25,16 +30,21 @@ public:
         clockspeed_fast   = 1, // Tick every second (BIOS internal '1')
         };
 
+    static unsigned int const
+        clockspeed_tick_sec[];
+
     static char const * const
         msg_clockspeed_fast;
     static char const * const
         msg_clockspeed_normal;
+    static char const * const
+        msg_clockspeed_auto;
     static char const * const
         msg_poweroff_delay_override_deact;
     static char const * const
         msg_poweroff_delay_1h;
-    static char * const
-        msg_poweroff_delay_h;
+    static char
+        msg_poweroff_delay_h[];
     static char const * const
         msg_err_bios_ver;
     static char const * const
@@ -43,6 +53,10 @@ public:
 private:
     inline unsigned char
         dec2bcd(unsigned int);
+    static void
+        bios_int86(int, union REGS * const);    // traced with BIOSTRACE
+    static void
+        bios_intr(int, struct REGPACK * const);
 
 public:
     int
@@ -60,6 +74,7 @@ public:
             byte_t & const,
             byte_t & const,
             byte_t & const,
+            byte_t & const,
             byte_t & const);
     void
         reset_rtc_alarm(void);
@@ -67,16 +82,16 @@ public:
         set_rtc_alarm(
             unsigned int,
             unsigned int);
-    void
-        beep_rndtone(void);
+    static void
+        tone_on(byte_t);
+    static void
+        tone_off(void);
     void
         set_clockspeed(PFBios::clockspeed_t);
     clockspeed_t
         get_clockspeed(void);
-    void
-        show_message_box(char const *);
-    void
-        show_message_box_poweroff_delay_h(unsigned int);
+    static char const *
+        get_msg_poweroff_delay_h(unsigned int);
     static void
         show_message_earlystage(char const * const);
     void
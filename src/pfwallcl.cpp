@@ -9,18 +9,40 @@
 #include "timer.h"
 #include "graph.h"
 #include "dgclock.h"
+#include "anclock.h"
+#include "dither.h"
 #include "inifile.h"
+#include "evsched.h"
+#include "clkgov.h"
+#include "msgbox.h"
+#include "toneseq.h"
+#include "arena.h"
+#include "bench.h"
+#include "coop.h"
+#include "txtline.h"
+#ifdef TELEMETRY
+#include "tlmlog.h"
+#endif
+#ifdef BIOSTRACE
+#include "biostrc.h"
+#endif
+#ifdef PROFILE
+#include "profiler.h"
+#endif
 
 #include <stdlib.h>
 #include <dos.h>
 #include <conio.h>
-#include <time.h>
 #include <string.h>
 
 #ifdef NTVDM
 #include <iostream.h>
 #endif
 
+#ifdef HOSTSIM
+#include "hostsim.h"
+#endif
+
 #ifdef SSHOT
 #include <io.h>
 #include <stdio.h>
@@ -28,14 +50,85 @@
 #include <sys\stat.h>
 #endif
 
+/*
+ * Everything main() places in the arena, a byte of rounding per object
+ * at most; the build fails with a negative array size when it won't fit
+ */
+#define ARENA_BUDGET_MAIN ( \
+    sizeof(INIFile) + 3 * sizeof(Timer::DaytimeHHMM) + sizeof(PwrSched) + \
+    2 * sizeof(ToneSeq::melody_t) + \
+    sizeof(Timer) + sizeof(Graph) + sizeof(DgClock) + sizeof(AnClock) + \
+    sizeof(EvScheduler) + sizeof(ClkGovernor) + sizeof(MsgBox) + \
+    14)
+
+typedef char
+    arena_budget_main_check[
+        ARENA_SIZE_MAIN >= ARENA_BUDGET_MAIN ? 1 : -1];
+
+#ifdef TELEMETRY
+typedef char
+    arena_budget_tlm_check[
+        ARENA_SIZE_TLM >= sizeof(TlmLog) + 1 ? 1 : -1];
+#endif
+
+#ifdef TESTS
+typedef char
+    arena_budget_tests_check[
+        ARENA_SIZE_TESTS >=
+            sizeof(INIFile) + 3 * sizeof(Timer::DaytimeHHMM) +
+            sizeof(PwrSched) + 5 ? 1 : -1];
+#endif
+
 #define ESC_CHAR '\33'
 #define SPACE_CHAR ' '
 
+#define ARRANGEMENT_SWAP_PERIOD_MINUTES 10
+#define CHIME_HALFHOUR_PERIOD_MINUTES 30
+#define CHIME_FULLHOUR_PERIOD_MINUTES 60
+
+struct internal_state_t {
+    unsigned int refresh_screen : 1;
+    Graph::window_arrangement_t window_arrangement : 2;
+    unsigned int animate_prep : 1;
+    unsigned int all_cylinders : 1;
+    Graph::anim_engine_t anim_engine : 3;   // stepped through by 'a'
+    unsigned int do_clock_sync : 1;
+    unsigned int do_events_dispatch : 1;
+    unsigned int do_dgclock_refresh : 1;
+    unsigned int do_dgclock_resume : 1; // changed digits / hands only
+    unsigned int analog_clock : 1;      // AnClock in place of DgClock
+    unsigned int gray_anim : 1;         // animation through Dither
+    unsigned int do_vram_refresh : 1;
+    unsigned int do_msgbox_refresh : 1; // box rows only
+};
+
+struct main_ctx_t {
+    PFBios * pfbios;
+    Timer * timer;
+    Graph * graph;
+    DgClock * dgclock;
+    AnClock * anclock;
+    EvScheduler * evsched;
+    ClkGovernor * clkgov;
+    MsgBox * msgbox;
+    INIFile const * inifile;
+    struct internal_state_t * internal_state;
+    struct Timer::time_digits_t * time_digits;
+    PFBios::clockspeed_t * clockspeed;
+    int rtc_alarm_daymin;   // -1 if not known
+    int key;                // 0 if none
+    int quit;
+#ifdef TELEMETRY
+    TlmLog * tlmlog;
+#endif
+};
+
 Graph::window_arrangement_t
     switch_window_arrangement(
         Graph::window_arrangement_t const window_arrangement,
         Graph & const graph,
-        DgClock & const dgclock)
+        DgClock & const dgclock,
+        AnClock & const anclock)
 {
     Graph::window_arrangement_t new_window_arrangement =
         window_arrangement;
@@ -49,6 +142,8 @@ Graph::window_arrangement_t
             new_window_arrangement);
         dgclock.set_window_arrangement(
             new_window_arrangement);
+        anclock.set_window_arrangement(
+            new_window_arrangement);
     }
     else if (window_arrangement ==
         Graph::DGCLOCK_RIGHT_ANIM_LEFT)
@@ -59,6 +154,8 @@ Graph::window_arrangement_t
             new_window_arrangement);
         dgclock.set_window_arrangement(
             new_window_arrangement);
+        anclock.set_window_arrangement(
+            new_window_arrangement);
     }
 
     return new_window_arrangement;
@@ -67,18 +164,877 @@ Graph::window_arrangement_t
 void
     set_clockspeed(
         PFBios & const pfbios,
+        Timer & const timer,
         PFBios::clockspeed_t const & const clockspeed)
 {
     pfbios.set_clockspeed(clockspeed);
-    if (clockspeed == PFBios::clockspeed_normal)
-        pfbios.show_message_box(PFBios::msg_clockspeed_normal);
-    if (clockspeed == PFBios::clockspeed_fast)
-        pfbios.show_message_box(PFBios::msg_clockspeed_fast);
+    timer.set_clockspeed(clockspeed);
+}
+
+void
+    show_clkgov_mode(
+        MsgBox & const msgbox,
+        ClkGovernor::mode_t const mode,
+        unsigned long now_sec)
+{
+    if (mode == ClkGovernor::MODE_FORCE_NORMAL)
+        msgbox.show(PFBios::msg_clockspeed_normal, now_sec);
+    if (mode == ClkGovernor::MODE_FORCE_FAST)
+        msgbox.show(PFBios::msg_clockspeed_fast, now_sec);
+    if (mode == ClkGovernor::MODE_AUTO)
+        msgbox.show(PFBios::msg_clockspeed_auto, now_sec);
+}
+
+void
+    sync_clock(
+        main_ctx_t & const ctx)
+{
+    byte_t second;
+
+    ctx.pfbios->read_rtc_time(
+        ctx.time_digits->digit.hour_tens,
+        ctx.time_digits->digit.hour_ones,
+        ctx.time_digits->digit.minute_tens,
+        ctx.time_digits->digit.minute_ones,
+        second);
+
+    unsigned int day_min = ctx.time_digits->get_abs_min();
+
+    ctx.evsched->set_now(day_min);
+    ctx.timer->sync_clock(
+        (unsigned long)day_min * SECONDS_PER_MINUTE + second);
+}
+
+void
+    schedule_poweroff_deadline(
+        main_ctx_t & const ctx)
+{
+    unsigned long due_min;
+
+    // Timer's tick handler checks the deadline on its own, late by up
+    // to two ticks; the RTC alarm bounds that to the minute
+    if (ctx.timer->get_poweroff_alarm_min(due_min))
+        ctx.evsched->schedule_at(
+            EvScheduler::EV_POWEROFF_DEADLINE, due_min);
+    else
+        ctx.evsched->cancel(
+            EvScheduler::EV_POWEROFF_DEADLINE);
+}
+
+void
+    arm_periodic_events(
+        EvScheduler & const evsched)
+{
+    evsched.schedule_on_boundary(
+        EvScheduler::EV_CLOCK_MINUTE, 1);
+    evsched.schedule_on_boundary(
+        EvScheduler::EV_ARRANGEMENT_SWAP, ARRANGEMENT_SWAP_PERIOD_MINUTES);
+    evsched.schedule_on_boundary(
+        EvScheduler::EV_CHIME_HALFHOUR, CHIME_HALFHOUR_PERIOD_MINUTES);
+    evsched.schedule_on_boundary(
+        EvScheduler::EV_CHIME_FULLHOUR, CHIME_FULLHOUR_PERIOD_MINUTES);
+}
+
+void
+    program_rtc_alarm(
+        main_ctx_t & const ctx)
+{
+    unsigned int alarm_daymin;
+
+    if (!ctx.evsched->get_next_due_daymin(alarm_daymin))
+        return;
+
+    // BIOS is not firing missed alarms from the previous day,
+    // if close to the end of the day,
+    // schedule the alarm rather on the next day
+    if (alarm_daymin >= 23 * 60 + 55)
+        alarm_daymin = 0;
+
+    if ((int)alarm_daymin == ctx.rtc_alarm_daymin)
+        return; // already programmed, spare the BIOS calls
+
+    ctx.pfbios->reset_rtc_alarm();
+    ctx.pfbios->set_rtc_alarm(
+        alarm_daymin / 60,
+        alarm_daymin % 60);
+    ctx.rtc_alarm_daymin = alarm_daymin;
+}
+
+void
+    program_poweron_alarm(
+        main_ctx_t & const ctx)
+{
+    unsigned int day, day_min;
+    PwrSched::lookup_t now;
+
+    ctx.timer->read_clock(day, day_min);
+    ctx.inifile->pwrsched_p->lookup(day, day_min, &now);
+
+    ctx.pfbios->reset_rtc_alarm();
+    ctx.rtc_alarm_daymin = -1;
+
+    if (now.to_on < 0)
+        return;
+
+    // RTC alarm is daytime only, on a day without this power on time
+    // we wake up in the off period and go back to sleep after
+    // the kbhit power off delay
+    unsigned int pon_daymin = (day_min + now.to_on) % MINUTES_PER_DAY;
+
+    ctx.pfbios->set_rtc_alarm(
+        pon_daymin / 60,
+        pon_daymin % 60);
+}
+
+#pragma argsused
+void
+    on_clock_minute(
+        void * ctx_p,
+        EvScheduler::event_kind_t kind)
+{
+    main_ctx_t & const ctx = * (main_ctx_t *) ctx_p;
+
+    // the digits or hands changed only, to the LCD alone
+    ctx.internal_state->do_dgclock_resume = TRUE;
+    ctx.evsched->schedule_on_boundary(kind, 1);
+}
+
+#pragma argsused
+void
+    on_arrangement_swap(
+        void * ctx_p,
+        EvScheduler::event_kind_t kind)
+{
+    main_ctx_t & const ctx = * (main_ctx_t *) ctx_p;
+
+    ctx.internal_state->window_arrangement =
+        switch_window_arrangement(
+            ctx.internal_state->window_arrangement,
+            * ctx.graph,
+            * ctx.dgclock,
+            * ctx.anclock);
+    ctx.internal_state->refresh_screen = TRUE;
+    ctx.evsched->schedule_on_boundary(kind, ARRANGEMENT_SWAP_PERIOD_MINUTES);
+}
+
+void
+    play_chime(
+        main_ctx_t & const ctx,
+        ToneSeq::melody_t const * const melody_p)
+{
+    if (melody_p)
+        ToneSeq::queue_melody(* melody_p);
+    else
+        ToneSeq::queue_rndtone();
+
+    // one more pass before halting, the governor switches to the fast tick
+    ctx.internal_state->do_events_dispatch = TRUE;
+}
+
+#pragma argsused
+void
+    on_chime_halfhour(
+        void * ctx_p,
+        EvScheduler::event_kind_t kind)
+{
+    main_ctx_t & const ctx = * (main_ctx_t *) ctx_p;
+
+    play_chime(ctx, ctx.inifile->halfhour_melody_p);
+    ctx.evsched->schedule_on_boundary(kind, CHIME_HALFHOUR_PERIOD_MINUTES);
+}
+
+#pragma argsused
+void
+    on_chime_fullhour(
+        void * ctx_p,
+        EvScheduler::event_kind_t kind)
+{
+    main_ctx_t & const ctx = * (main_ctx_t *) ctx_p;
+
+    play_chime(ctx, ctx.inifile->fullhour_melody_p);
+    ctx.evsched->schedule_on_boundary(kind, CHIME_FULLHOUR_PERIOD_MINUTES);
+}
+
+#pragma argsused
+void
+    on_anim_restart(
+        void * ctx_p,
+        EvScheduler::event_kind_t kind)
+{
+    main_ctx_t & const ctx = * (main_ctx_t *) ctx_p;
+
+    ctx.internal_state->animate_prep = TRUE;
+    ctx.internal_state->all_cylinders = TRUE;
+}
+
+#pragma argsused
+void
+    on_poweroff(
+        void * ctx_p,
+        EvScheduler::event_kind_t kind)
+{
+    main_ctx_t & const ctx = * (main_ctx_t *) ctx_p;
+
+#ifdef TELEMETRY
+    ctx.tlmlog->note_work(TlmLog::WORK_POWEROFF);
+    ctx.tlmlog->end_wake();
+    ctx.tlmlog->flush();    // RAM disk survives, the ring would be lost
+                            // on a battery swap
+#endif
+#ifdef PROFILE
+    Profiler::dump(* ctx.clkgov, * ctx.timer);
+    Profiler::cancel();     // the stage would time the sleep
+#endif
+    program_poweron_alarm(ctx);
+    ToneSeq::stop();
+    ctx.graph->snapshot_save();
+    unsigned long const off_sec = ctx.timer->get_now_sec();
+    ctx.pfbios->poweroff();
+    // zzz...
+#ifdef BIOSTRACE
+    BiosTrace::dump();      // the program rarely exits; after the power off,
+                            // to have the alarm and the power off call in
+#endif
+#ifndef NTVDM
+    ToneSeq::queue_rndtone();
+    ToneSeq::queue_rndtone();
+    ToneSeq::queue_rndtone();
+#endif
+#ifdef TELEMETRY
+    ctx.tlmlog->begin_wake(ctx.timer->get_now_sec());
+    ctx.tlmlog->note_source(TlmLog::SRC_RTC_ALARM);
+#endif
+    ctx.timer->reset_events();
+    ctx.evsched->cancel(EvScheduler::EV_POWEROFF);
+    ctx.evsched->cancel(EvScheduler::EV_POWEROFF_DEADLINE);
+
+    // time has jumped, re-arm periodic events from now on
+    // rather than firing all the ones missed while asleep
+    sync_clock(ctx);
+    ctx.clkgov->leave_out(off_sec, ctx.timer->get_now_sec());
+    arm_periodic_events(* ctx.evsched);
+    ctx.timer->schedule_next_poweroff(ctx.inifile);
+
+    // frame as left, only the digits / hands changed while asleep go to the LCD
+    if (ctx.graph->snapshot_restore())
+        ctx.internal_state->do_dgclock_resume = TRUE;
+    else
+        ctx.internal_state->do_dgclock_refresh = TRUE;
+}
+
+EvScheduler::handler_fp_t const
+    event_handlers[EvScheduler::EV_KINDS_NUM] = {
+        on_clock_minute,        // EV_CLOCK_MINUTE
+        on_arrangement_swap,    // EV_ARRANGEMENT_SWAP
+        on_chime_halfhour,      // EV_CHIME_HALFHOUR
+        on_chime_fullhour,      // EV_CHIME_FULLHOUR
+        on_anim_restart,        // EV_ANIM_RESTART
+        on_poweroff,            // EV_POWEROFF
+        on_poweroff,            // EV_POWEROFF_DEADLINE
+    };
+
+#ifdef SSHOT
+void
+    save_screenshot(
+        PFBios & const pfbios,
+        Graph & const graph)
+{
+    int fd;
+    int res;
+    char const * const filename = "sshot.bin";
+
+    fd = open(filename,
+        O_WRONLY | O_CREAT | O_TRUNC | O_BINARY,
+        S_IREAD | S_IWRITE);
+
+    if (fd == -1)
+    {
+        pfbios.set_videomode(VIDMODE_MDATEXT80x25);
+        perror ("Screenshot: Open file");
+        return;
+    }
+
+    res = graph.take_screenshot(fd);
+
+    if (res == -1)
+    {
+        pfbios.set_videomode(VIDMODE_MDATEXT80x25);
+        perror ("Screenshot: Write");
+        return;
+    }
+    if (res == -2)
+    {
+        pfbios.set_videomode(VIDMODE_MDATEXT80x25);
+        fprintf (stderr, "Screenshot: Couldn't write the buffer to file.");
+        return;
+    }
+
+    res = close (fd);
+
+    if (res != 0)
+    {
+        pfbios.set_videomode(VIDMODE_MDATEXT80x25);
+        perror ("Screenshot: Close file");
+        return;
+    }
+}
+#endif
+
+/*
+ * Main loop tasks, in the priority order: a key first, the timer and
+ * the scheduled events next, then the screen and the animation last.
+ * The clock redraw yields after every second of its steps, the
+ * animation steps a frame a slice, so neither holds a key back for
+ * more than two steps.
+ */
+enum task_id_t {
+    TASK_INPUT,
+    TASK_EVENTS,
+    TASK_DRAW,
+    TASK_ANIM,
+    TASKS_NUM
+};
+
+#pragma argsused
+CoopSched::pt_state_t
+    task_input(
+        void * ctx_p,
+        CoopSched::pt_t & const pt)
+{
+    main_ctx_t & const ctx = * (main_ctx_t *) ctx_p;
+    struct internal_state_t & const internal_state = * ctx.internal_state;
+    PFBios & const pfbios = * ctx.pfbios;
+    Timer & const timer = * ctx.timer;
+    Graph & const graph = * ctx.graph;
+    DgClock & const dgclock = * ctx.dgclock;
+    AnClock & const anclock = * ctx.anclock;
+    EvScheduler & const evsched = * ctx.evsched;
+    ClkGovernor & const clkgov = * ctx.clkgov;
+    MsgBox & const msgbox = * ctx.msgbox;
+    PFBios::clockspeed_t & const clockspeed = * ctx.clockspeed;
+#ifdef TELEMETRY
+    TlmLog & const tlmlog = * ctx.tlmlog;
+#endif
+    int c = ctx.key;
+
+    ctx.key = 0;
+
+    if (c == ESC_CHAR && !msgbox.is_shown())    // Esc closes the box first
+    {
+        ctx.quit = TRUE;
+        return CoopSched::PT_ENDED;
+    }
+
+    if (c && msgbox.is_shown()) // any key just dismisses the box
+    {
+        msgbox.hide();
+        internal_state.do_msgbox_refresh = TRUE;
+        c = 0;
+    }
+
+    if (c == 'a') // animation: off, sine, life, marquee, wireframe, off
+    {
+        if (!internal_state.all_cylinders &&
+            !evsched.is_pending(EvScheduler::EV_ANIM_RESTART))
+        {
+            internal_state.anim_engine = Graph::ANIM_SINE;
+            internal_state.animate_prep = TRUE;
+            internal_state.all_cylinders = TRUE;
+        }
+        else if (internal_state.anim_engine + 1 < Graph::ANIM_ENGINES_NUM)
+        {
+            evsched.cancel(EvScheduler::EV_ANIM_RESTART);
+            internal_state.anim_engine =
+                (Graph::anim_engine_t)(internal_state.anim_engine + 1);
+            internal_state.animate_prep = TRUE;
+            internal_state.all_cylinders = TRUE;
+        }
+        else
+        {
+            evsched.cancel(EvScheduler::EV_ANIM_RESTART);
+            internal_state.animate_prep = FALSE;
+            internal_state.all_cylinders = FALSE;
+        }
+        internal_state.refresh_screen = TRUE;
+    }
+    else if (c == 'c') // toggle digital / analog clock
+    {
+        internal_state.analog_clock = !internal_state.analog_clock;
+        internal_state.refresh_screen = TRUE;
+    }
+    else if (c == 'g') // toggle gray animation trails
+    {
+        internal_state.gray_anim = !internal_state.gray_anim;
+        internal_state.refresh_screen = TRUE;
+    }
+    else if (c >= '0' && c <= '9') // override power-off delay
+    {
+        unsigned int numkey = c - '0';
+
+        if (numkey == 0) // reset power-off delay back as set in the .ini file
+            timer.unset_poweroff_delay_override();
+        else // set power-off delay to <numkey> hours
+            timer.set_poweroff_delay_override(
+                Timer::DaytimeHHMM (numkey));
+
+        if (numkey == 0)
+            msgbox.show(PFBios::msg_poweroff_delay_override_deact, timer.get_now_sec());
+        else if (numkey == 1)
+            msgbox.show(PFBios::msg_poweroff_delay_1h, timer.get_now_sec());
+        else
+            msgbox.show(PFBios::get_msg_poweroff_delay_h(numkey), timer.get_now_sec());
+#ifdef TELEMETRY
+        tlmlog.note_work(TlmLog::WORK_MSGBOX);
+#endif
+
+        internal_state.do_msgbox_refresh = TRUE;
+    }
+    else if (c == 'o') // power-off now
+    {
+        evsched.schedule_in(EvScheduler::EV_POWEROFF, 0);
+        internal_state.do_events_dispatch = TRUE;
+    }
+    else if (c == 'f') // clockspeed override: auto, fast, normal
+    {
+        ClkGovernor::mode_t clkgov_mode =
+            clkgov.cycle_mode(timer.get_now_sec());
+
+        if (clkgov.get_clockspeed() != clockspeed)
+        {
+            clockspeed = clkgov.get_clockspeed();
+            set_clockspeed(pfbios, timer, clockspeed);
+        }
+        show_clkgov_mode(msgbox, clkgov_mode, timer.get_now_sec());
+#ifdef TELEMETRY
+        tlmlog.note_work(TlmLog::WORK_MSGBOX);
+#endif
+        internal_state.do_msgbox_refresh = TRUE;
+    }
+#ifdef SSHOT
+    else if (c == 's')  // take screenshot, save the file to disk
+                        // and exit
+    {
+        save_screenshot(pfbios, graph);
+        ctx.quit = TRUE;
+        return CoopSched::PT_ENDED;
+    }
+#endif
+    else if (c == SPACE_CHAR) // arcade
+    {
+#ifdef NTVDM
+        internal_state.do_clock_sync = TRUE;
+        ToneSeq::queue_rndtone();
+#endif
+        internal_state.window_arrangement =
+            switch_window_arrangement(
+                internal_state.window_arrangement,
+                graph,
+                dgclock,
+                anclock);
+        internal_state.refresh_screen = TRUE;
+    }
+
+    if (! evsched.is_pending(EvScheduler::EV_POWEROFF))
+    {
+        timer.schedule_next_poweroff(ctx.inifile);
+    }
+    internal_state.do_events_dispatch = TRUE;
+
+    return CoopSched::PT_ENDED;
+}
+
+#pragma argsused
+CoopSched::pt_state_t
+    task_events(
+        void * ctx_p,
+        CoopSched::pt_t & const pt)
+{
+    main_ctx_t & const ctx = * (main_ctx_t *) ctx_p;
+    struct internal_state_t & const internal_state = * ctx.internal_state;
+    PFBios & const pfbios = * ctx.pfbios;
+    Timer & const timer = * ctx.timer;
+    EvScheduler & const evsched = * ctx.evsched;
+    ClkGovernor & const clkgov = * ctx.clkgov;
+    MsgBox & const msgbox = * ctx.msgbox;
+    PFBios::clockspeed_t & const clockspeed = * ctx.clockspeed;
+#ifdef TELEMETRY
+    TlmLog & const tlmlog = * ctx.tlmlog;
+#endif
+    Timer::event_t timer_event;
+
+#ifdef PROFILE
+    Profiler::begin();
+#endif
+    // timer events
+    while (timer.receive_event(timer_event))
+    {
+        switch (timer_event)
+        {
+            case Timer::EVT_POWEROFF:
+                evsched.schedule_in(EvScheduler::EV_POWEROFF, 0);
+                internal_state.do_events_dispatch = TRUE;
+                break;
+            case Timer::EVT_RTC_ALARM:
+#ifdef TELEMETRY
+                tlmlog.note_source(TlmLog::SRC_RTC_ALARM);
+#endif
+                internal_state.do_clock_sync = TRUE;
+                break;
+            case Timer::EVT_TICK:
+#ifdef TELEMETRY
+                tlmlog.note_source(TlmLog::SRC_TICK);
+#endif
+                break;
+        }
+    }
+
+    if (msgbox.is_expired(timer.get_now_sec()))
+    {
+        msgbox.hide();
+        internal_state.do_msgbox_refresh = TRUE;
+    }
+
+    // clockspeed governor, fast tick while animating, timing
+    // the message box out or playing notes
+    if (clkgov.evaluate(
+            internal_state.all_cylinders ||
+                msgbox.is_shown(),
+            ToneSeq::is_playing(),
+            timer.get_now_sec()))
+    {
+        clockspeed = clkgov.get_clockspeed();
+        set_clockspeed(pfbios, timer, clockspeed);
+        internal_state.do_events_dispatch = TRUE;
+    }
+
+    // scheduled events
+    if (internal_state.do_clock_sync)
+    {
+        internal_state.do_clock_sync = FALSE;
+        internal_state.do_events_dispatch = TRUE;
+        sync_clock(ctx);
+    }
+    if (internal_state.do_events_dispatch)
+    {
+        internal_state.do_events_dispatch = FALSE;
+        schedule_poweroff_deadline(ctx);
+#ifndef TELEMETRY
+        evsched.dispatch_due();
+#else
+        tlmlog.note_work(TlmLog::WORK_EVENTS);
+        tlmlog.note_events(
+            evsched.dispatch_due());
+#endif
+        program_rtc_alarm(ctx);
+    }
+#ifdef PROFILE
+    Profiler::end(Profiler::STAGE_EVENTS);
+#endif
+
+    return CoopSched::PT_ENDED;
+}
+
+void
+    copy_to_vram(
+        main_ctx_t & const ctx)
+{
+    struct internal_state_t & const internal_state = * ctx.internal_state;
+
+    ctx.msgbox->stamp();
+
+    if (internal_state.do_vram_refresh)
+    {
+        internal_state.do_vram_refresh = FALSE;
+        internal_state.do_msgbox_refresh = FALSE;
+#ifdef PROFILE
+        Profiler::begin();
+#endif
+        ctx.graph->vram_copy();
+#ifdef PROFILE
+        Profiler::end(Profiler::STAGE_VRAM_COPY);
+#endif
+#ifdef TELEMETRY
+        ctx.tlmlog->note_work(TlmLog::WORK_VRAM_COPY);
+#endif
+    }
+    else if (internal_state.do_msgbox_refresh)
+    {
+        internal_state.do_msgbox_refresh = FALSE;
+#ifdef PROFILE
+        Profiler::begin();
+#endif
+        ctx.graph->vram_copy(MSGBOX_Y, MSGBOX_HEIGHT);
+#ifdef PROFILE
+        Profiler::end(Profiler::STAGE_VRAM_COPY);
+#endif
+#ifdef TELEMETRY
+        ctx.tlmlog->note_work(TlmLog::WORK_VRAM_COPY);
+#endif
+    }
+}
+
+void
+    resume_dgclock(
+        main_ctx_t & const ctx)
+{
+    unsigned int first_row = ctx.dgclock->get_y_offs();
+    unsigned int nrows = FNTDATA_HEIGHT;
+    unsigned int first_col_b;
+    unsigned int ncols_b;
+
+#ifdef PROFILE
+    Profiler::begin();
+#endif
+    unsigned int changed =
+        ctx.internal_state->analog_clock ?
+            ctx.anclock->draw_changed(
+                * ctx.time_digits, first_row, nrows, first_col_b, ncols_b) :
+            ctx.dgclock->draw_changed(
+                * ctx.time_digits, first_col_b, ncols_b);
+#ifdef PROFILE
+    Profiler::end(Profiler::STAGE_DGCLOCK);
+#endif
+    if (!changed)
+        return;
+
+    ctx.msgbox->stamp();
+#ifdef PROFILE
+    Profiler::begin();
+#endif
+    ctx.graph->vram_copy(first_row, nrows, first_col_b, ncols_b);
+#ifdef PROFILE
+    Profiler::end(Profiler::STAGE_VRAM_COPY);
+#endif
+#ifdef TELEMETRY
+    ctx.tlmlog->note_work(TlmLog::WORK_DGCLOCK);
+    ctx.tlmlog->note_work(TlmLog::WORK_VRAM_COPY);
+#endif
+}
+
+CoopSched::pt_state_t
+    task_draw(
+        void * ctx_p,
+        CoopSched::pt_t & const pt)
+{
+    main_ctx_t & const ctx = * (main_ctx_t *) ctx_p;
+    struct internal_state_t & const internal_state = * ctx.internal_state;
+    Graph & const graph = * ctx.graph;
+    EvScheduler & const evsched = * ctx.evsched;
+
+    PT_BEGIN(pt);
+
+    // box off the screen while drawing underneath, back on before the copy;
+    // nothing else draws while this one yields, it's ready until the end
+    ctx.msgbox->unstamp();
+
+    if (internal_state.refresh_screen)
+    {
+        internal_state.refresh_screen = FALSE;
+#ifdef NTVDM
+        graph.cls_withpattern(0);
+#else
+        graph.cls_withzigzag();
+#endif
+#ifdef TELEMETRY
+        ctx.tlmlog->sample();   // the stages of a slice add up past a wrap
+#endif
+        internal_state.do_dgclock_refresh = TRUE;
+
+        if (internal_state.all_cylinders ||
+            evsched.is_pending(EvScheduler::EV_ANIM_RESTART))
+        {
+            evsched.cancel(EvScheduler::EV_ANIM_RESTART);
+            internal_state.animate_prep = TRUE;
+            internal_state.all_cylinders = TRUE;
+        }
+        PT_YIELD_IF_OVER(pt);
+    }
+
+    if (internal_state.do_dgclock_resume)
+    {
+        internal_state.do_dgclock_resume = FALSE;
+
+        if (!internal_state.do_dgclock_refresh)    // else redrawn whole below
+            resume_dgclock(ctx);
+    }
+
+    if (internal_state.do_dgclock_refresh)
+    {
+        internal_state.do_dgclock_refresh = FALSE;
+        internal_state.do_vram_refresh = TRUE;
+#ifdef PROFILE
+        Profiler::begin();
+#endif
+        if (internal_state.analog_clock)
+            ctx.anclock->draw(* ctx.time_digits);
+        else
+            ctx.dgclock->draw(* ctx.time_digits);
+#ifdef PROFILE
+        Profiler::end(Profiler::STAGE_DGCLOCK);
+#endif
+#ifdef TELEMETRY
+        ctx.tlmlog->note_work(TlmLog::WORK_DGCLOCK);
+        ctx.tlmlog->sample();
+#endif
+        PT_YIELD_IF_OVER(pt);
+    }
+
+    if (internal_state.animate_prep)
+    {
+        internal_state.animate_prep = FALSE;
+        internal_state.do_vram_refresh = TRUE;
+#ifdef PROFILE
+        Profiler::begin();
+#endif
+        graph.anim_prep(internal_state.anim_engine);
+        if (internal_state.gray_anim)
+            Dither::start();
+#ifdef PROFILE
+        Profiler::end(Profiler::STAGE_ANIM_PREP);
+#endif
+#ifdef TELEMETRY
+        ctx.tlmlog->sample();
+#endif
+    }
+
+    copy_to_vram(ctx);
+
+    PT_END(pt);
+}
+
+void
+    anim_gray_step(
+        main_ctx_t & const ctx)
+{
+    struct internal_state_t & const internal_state = * ctx.internal_state;
+    int const x_offs = ctx.graph->get_animw_x_offs();
+
+    if (Dither::is_frame_due())
+    {
+        ctx.msgbox->unstamp();
+        Dither::keep_plane(x_offs);
+#ifdef TELEMETRY
+        ctx.tlmlog->note_work(TlmLog::WORK_ANIM);
+#endif
+#ifdef PROFILE
+        Profiler::begin();
+#endif
+        int anim_finished = ctx.graph->animate_finished();
+#ifdef PROFILE
+        Profiler::end(Profiler::STAGE_ANIMATE);
+#endif
+        if (anim_finished)
+        {
+            internal_state.all_cylinders = FALSE;
+            ctx.evsched->schedule_on_boundary(
+                EvScheduler::EV_ANIM_RESTART, 1);
+            internal_state.do_events_dispatch = TRUE;
+        }
+        ctx.msgbox->stamp();
+    }
+
+    // no trails over the box, none left once stopped
+#ifdef PROFILE
+    Profiler::begin();
+#endif
+    Dither::present(x_offs,
+        internal_state.all_cylinders && !ctx.msgbox->is_shown());
+#ifdef PROFILE
+    Profiler::end(Profiler::STAGE_VRAM_COPY);
+#endif
+#ifdef TELEMETRY
+    ctx.tlmlog->note_work(TlmLog::WORK_VRAM_COPY);
+#endif
+}
+
+#pragma argsused
+CoopSched::pt_state_t
+    task_anim(
+        void * ctx_p,
+        CoopSched::pt_t & const pt)
+{
+    main_ctx_t & const ctx = * (main_ctx_t *) ctx_p;
+    struct internal_state_t & const internal_state = * ctx.internal_state;
+
+    if (internal_state.gray_anim)
+    {
+        // the window alone, a present a slice, a frame every few
+        anim_gray_step(ctx);
+        return CoopSched::PT_ENDED;
+    }
+
+    ctx.msgbox->unstamp();
+
+    // frames while the budget lasts, each one shown
+    do
+    {
+        internal_state.do_vram_refresh = TRUE;
+#ifdef TELEMETRY
+        ctx.tlmlog->note_work(TlmLog::WORK_ANIM);
+#endif
+#ifdef PROFILE
+        Profiler::begin();
+#endif
+        int anim_finished = ctx.graph->animate_finished();
+#ifdef PROFILE
+        Profiler::end(Profiler::STAGE_ANIMATE);
+#endif
+        if (anim_finished)
+        {
+            internal_state.all_cylinders = FALSE;
+            ctx.evsched->schedule_on_boundary(
+                EvScheduler::EV_ANIM_RESTART, 1);
+            internal_state.do_events_dispatch = TRUE;
+        }
+#ifdef TELEMETRY
+        ctx.tlmlog->sample();
+#endif
+    }
+    while (internal_state.all_cylinders && !CoopSched::is_slice_over());
+
+    copy_to_vram(ctx);
+
+    return CoopSched::PT_ENDED;     // woken again while all_cylinders
+}
+
+CoopSched::task_def_t const
+    task_defs[TASKS_NUM] = {
+        { task_input, 0 },          // TASK_INPUT
+        { task_events, 0 },         // TASK_EVENTS
+        { task_draw, 1 },           // TASK_DRAW
+        { task_anim, 0 },           // TASK_ANIM, a frame a slice
+    };
+
+void
+    wake_tasks(
+        CoopSched & const coop,
+        main_ctx_t & const ctx)
+{
+    struct internal_state_t & const internal_state = * ctx.internal_state;
+
+    if (ctx.timer->has_events() ||
+        internal_state.do_clock_sync ||
+        internal_state.do_events_dispatch ||
+        (ToneSeq::is_playing() &&   // notes just queued, the governor
+            * ctx.clockspeed != PFBios::clockspeed_fast))    // speeds up
+        coop.wake(TASK_EVENTS);
+
+    if (internal_state.refresh_screen ||
+        internal_state.do_dgclock_refresh ||
+        internal_state.do_dgclock_resume ||
+        internal_state.animate_prep ||
+        internal_state.do_vram_refresh ||
+        internal_state.do_msgbox_refresh)
+        coop.wake(TASK_DRAW);
+
+    if (internal_state.all_cylinders)
+        coop.wake(TASK_ANIM);
 }
 
 int main(int const argc, char * const * const argv)
 {
     int do_check_biosver = TRUE;
+    int do_bench = FALSE;
 
     if (argc > 1)
     {
@@ -90,11 +1046,15 @@ int main(int const argc, char * const * const argv)
             {
                 do_check_biosver = FALSE;
             }
+            else if (strcmp(*arg, "bench") == 0)
+            {
+                do_bench = TRUE;
+            }
             else
             {
                 char s [40] = "Unknown argument: ";
                 strncat(s, *arg, 15);
-                strncat(s, "\r\n$", 3);
+                strcat(s, "\r\n$");
 
                 PFBios::show_message_earlystage(s);
                 unsupported_arg = TRUE;
@@ -108,7 +1068,7 @@ int main(int const argc, char * const * const argv)
         }
     }
 
-    INIFile * inifile = INIFile::parse();
+    INIFile * inifile = INIFile::load();
 
     if (!inifile)
     {
@@ -140,353 +1100,212 @@ int main(int const argc, char * const * const argv)
         clockspeed =
             pfbios.get_clockspeed();
 
-    struct Timer::timer_events_t
-        timer_events;
-
     struct Timer::time_digits_t
         time_digits;
 
-    time_t
-        nextalarm_time_t;
-
-    struct tm *
-        nextalarm_tm;
-
-    pfbios.read_rtc_time(
-        time_digits.digit.hour_tens,
-        time_digits.digit.hour_ones,
-        time_digits.digit.minute_tens,
-        time_digits.digit.minute_ones);
-
-    Timer timer = Timer (
-        clockspeed);
+    Timer & const timer =
+        * new (arena) Timer(
+            clockspeed);
 
 #ifdef TESTS
-    clockspeed = PFBios::clockspeed_normal;
+    timer.set_clockspeed(PFBios::clockspeed_normal);
     timer.test_schedule_next_poweroff();
-    clockspeed = PFBios::clockspeed_fast;
+    timer.set_clockspeed(PFBios::clockspeed_fast);
     timer.test_schedule_next_poweroff();
+    timer.test_poweroff_deadline();
     cout << "OK: All tests passed.\n";
     return EXIT_SUCCESS;
 #endif
 
     timer.register_handlers();
 
-    struct internal_state_t {
-        unsigned int refresh_screen : 1;
-        Graph::window_arrangement_t window_arrangement : 2;
-        unsigned int animate_prep : 1;
-        unsigned int animate_waitnextminute : 1;
-        unsigned int all_cylinders : 1;
-        unsigned int force_passed1minute_event : 1;
-        unsigned int force_poweroff_event : 1;
-        unsigned int do_dgclock_refresh : 1;
-        unsigned int do_vram_refresh : 1;
-    } internal_state = {
+    struct internal_state_t internal_state = {
         TRUE,   // refresh_screen
         Graph::DGCLOCK_LEFT_ANIM_RIGHT, // window_arrangement
         FALSE,  // animate_prep
-        FALSE,  // animate_waitnextminute
         FALSE,  // all_cylinders
-        TRUE,   // force_passed1minute_event
-        FALSE,  // force_poweroff_event
+        Graph::ANIM_SINE,   // anim_engine
+        FALSE,  // do_clock_sync
+        TRUE,   // do_events_dispatch
         TRUE,   // do_dgclock_refresh
-        TRUE    // do_vram_refresh
+        FALSE,  // do_dgclock_resume
+        FALSE,  // analog_clock
+        FALSE,  // gray_anim
+        TRUE,   // do_vram_refresh
+        FALSE   // do_msgbox_refresh
     };
 
-    Graph graph =
-        Graph(
+    Graph & const graph =
+        * new (arena) Graph(
             internal_state.window_arrangement);
 
-    DgClock dgclock =
-        DgClock(
+    DgClock & const dgclock =
+        * new (arena) DgClock(
             internal_state.window_arrangement);
 
-    pfbios.set_videomode(VIDMODE_CGA640x200BW);
-
-    int c = 0;
-#ifdef NTVDM
-    gotoxy(1,18);
-#endif
+    AnClock & const anclock =
+        * new (arena) AnClock(
+            internal_state.window_arrangement);
 
-    // kbhit loop
-    do
+    if (do_bench)
     {
-        if (c == 'a') // toggle animation
-        {
-            if (!internal_state.all_cylinders &&
-                !internal_state.animate_waitnextminute)
-            {
-                internal_state.animate_prep = TRUE;
-                internal_state.all_cylinders = TRUE;
-            }
-            else
-            {
-                internal_state.animate_waitnextminute = FALSE;
-                internal_state.animate_prep = FALSE;
-                internal_state.all_cylinders = FALSE;
-            }
-            internal_state.refresh_screen = TRUE;
-        }
-        else if (c >= '0' && c <= '9') // override power-off delay
-        {
-            unsigned int numkey = c - '0';
-
-            if (numkey == 0) // reset power-off delay back as set in the .ini file
-                timer.unset_poweroff_delay_override();
-            else // set power-off delay to <numkey> hours
-                timer.set_poweroff_delay_override(
-                    Timer::DaytimeHHMM (numkey));
-
-            if (numkey == 0)
-                pfbios.show_message_box(PFBios::msg_poweroff_delay_override_deact);
-            else if (numkey == 1)
-                pfbios.show_message_box(PFBios::msg_poweroff_delay_1h);
-            else
-                pfbios.show_message_box_poweroff_delay_h(numkey);
+        pfbios.set_videomode(VIDMODE_CGA640x200BW);
+        set_clockspeed(pfbios, timer, PFBios::clockspeed_fast);
+        Bench::run(graph, dgclock);
+        timer.deregister_handlers();
+        pfbios.set_clockspeed(PFBios::clockspeed_normal);
+        pfbios.set_cursor_mode(CURSOR_MODE_BLOCK);
+        pfbios.set_videomode(VIDMODE_MDATEXT80x25);
 
-            internal_state.refresh_screen = TRUE;
-        }
-        else if (c == 'o') // power-off now
-        {
-            internal_state.force_poweroff_event = TRUE;
-        }
-        else if (c == 'f') // fast-tick toggle
+        Bench::show();
+        if (Bench::append())
         {
-            if (clockspeed == PFBios::clockspeed_normal)
-            {
-                clockspeed = PFBios::clockspeed_fast;
-                set_clockspeed(pfbios, clockspeed);
-            }
-            else if (clockspeed == PFBios::clockspeed_fast)
-            {
-                clockspeed = PFBios::clockspeed_normal;
-                set_clockspeed(pfbios, clockspeed);
-            }
-            internal_state.refresh_screen = TRUE;
+            pfbios.show_message_earlystage("ERR: Bench results not saved.\r\n$");
+            return EXIT_FAILURE;
         }
-#ifdef SSHOT
-        else if (c == 's')  // take screenshot, save the file to disk
-                            // and exit
-        {
-            int fd;
-            int res;
-            char const * const filename = "sshot.bin";
+        return EXIT_SUCCESS;
+    }
 
-            fd = open(filename,
-                O_WRONLY | O_CREAT | O_TRUNC | O_BINARY,
-                S_IREAD | S_IWRITE);
+    main_ctx_t main_ctx;
+#ifdef TELEMETRY
+    TlmLog & const tlmlog =
+        * new (arena) TlmLog();
+    main_ctx.tlmlog = & tlmlog;
+#endif
 
-            if (fd == -1)
-            {
-                pfbios.set_videomode(VIDMODE_MDATEXT80x25);
-                perror ("Screenshot: Open file");
-                goto exit;
-            }
+    EvScheduler & const evsched =
+        * new (arena) EvScheduler(
+            event_handlers,
+            & main_ctx);
 
-            res = graph.take_screenshot(fd);
+    main_ctx.pfbios = & pfbios;
+    main_ctx.timer = & timer;
+    main_ctx.graph = & graph;
+    main_ctx.dgclock = & dgclock;
+    main_ctx.anclock = & anclock;
+    main_ctx.evsched = & evsched;
+    main_ctx.inifile = inifile;
+    main_ctx.clockspeed = & clockspeed;
+    main_ctx.key = 0;
+    main_ctx.quit = FALSE;
+    main_ctx.internal_state = & internal_state;
+    main_ctx.time_digits = & time_digits;
+    main_ctx.rtc_alarm_daymin = -1;
 
-            if (res == -1)
-            {
-                pfbios.set_videomode(VIDMODE_MDATEXT80x25);
-                perror ("Screenshot: Write");
-                goto exit;
-            }
-            if (res == -2)
-            {
-                pfbios.set_videomode(VIDMODE_MDATEXT80x25);
-                fprintf (stderr, "Screenshot: Couldn't write the buffer to file.");
-                goto exit;
-            }
+    sync_clock(main_ctx);
+    arm_periodic_events(evsched);
 
-            res = close (fd);
+    ClkGovernor & const clkgov =
+        * new (arena) ClkGovernor(
+            clockspeed,
+            timer.get_now_sec());
 
-            if (res != 0)
-            {
-                pfbios.set_videomode(VIDMODE_MDATEXT80x25);
-                perror ("Screenshot: Close file");
-                goto exit;
-            }
+    MsgBox & const msgbox =
+        * new (arena) MsgBox();
 
-            goto exit;
-        }
+    main_ctx.clkgov = & clkgov;
+    main_ctx.msgbox = & msgbox;
+
+#ifdef NTVDM
+    cout
+        << "Arena: "
+        << arena.get_used()
+        << " of "
+        << (unsigned int)ARENA_SIZE
+        << " bytes used.\n";
 #endif
-        else if (c == SPACE_CHAR) // arcade
-        {
+
+#ifdef TELEMETRY
+    tlmlog.begin_run(timer.get_now_sec());
+#endif
+
+    pfbios.set_videomode(VIDMODE_CGA640x200BW);
+
 #ifdef NTVDM
-            internal_state.force_passed1minute_event = TRUE;
-            pfbios.beep_rndtone();
-#endif
-            internal_state.window_arrangement =
-                switch_window_arrangement(
-                    internal_state.window_arrangement,
-                    graph,
-                    dgclock);
-            internal_state.refresh_screen = TRUE;
-        }
+    gotoxy(1,18);
+#endif
+
+    CoopSched coop(task_defs, TASKS_NUM, & main_ctx);
+
+    coop.wake(TASK_INPUT);      // first pass as after a key, arms the power-off
 
-        if (! internal_state.force_poweroff_event)
+    for (;;)
+    {
+        if (kbhit())            // <- this will reset the POFO's
+                                // internal power-off ticks counter
         {
-            timer.schedule_next_poweroff(inifile);
+            main_ctx.key = getch();
+#ifdef TELEMETRY
+            tlmlog.note_source(TlmLog::SRC_KEY);
+#endif
+            coop.wake(TASK_INPUT);
         }
 
-        // on timer interrupt
-        do
+        wake_tasks(coop, main_ctx);
+
+        if (coop.run_next())
         {
-            // timer events
-            if (timer.receive_poweroff_event() ||
-                internal_state.force_poweroff_event)
-            {
-                internal_state.force_poweroff_event = FALSE;
-                pfbios.reset_rtc_alarm();
-                if (inifile->pon_dayt_p)
-                    pfbios.set_rtc_alarm(
-                        inifile->pon_dayt_p->get_hour(),
-                        inifile->pon_dayt_p->get_min());
-                pfbios.poweroff();
-                // zzz...
-#ifndef NTVDM
-                pfbios.beep_rndtone();
-                pfbios.beep_rndtone();
-                pfbios.beep_rndtone();
+            if (main_ctx.quit)
+                break;
+#ifdef TELEMETRY
+            if (ToneSeq::is_playing())
+                tlmlog.note_work(TlmLog::WORK_TONE);
+            tlmlog.sample();
 #endif
-                timer.reset_events();
-                timer.schedule_next_poweroff(inifile);
-                internal_state.force_passed1minute_event = TRUE;
-            }
-            if (timer.receive_passed1minute_event() ||
-                internal_state.force_passed1minute_event)
-            {
-                pfbios.read_rtc_time(
-                    time_digits.digit.hour_tens,
-                    time_digits.digit.hour_ones,
-                    time_digits.digit.minute_tens,
-                    time_digits.digit.minute_ones);
-
-                timer_events = timer.eval_events(time_digits);
-
-                nextalarm_time_t =
-                    (unsigned long)time_digits.digit.hour_tens *   36000ul +
-                    (unsigned long)time_digits.digit.hour_ones *    3600ul +
-                    (unsigned long)time_digits.digit.minute_tens *   600ul +
-                    (unsigned long)time_digits.digit.minute_ones *    60ul +
-                    60ul +
-                    2ul;    // safety measure if close to next minute,
-                            // if late, RTC alarm would never fire (well, after 24 hours)
-
-                nextalarm_tm = gmtime (& nextalarm_time_t);
-
-                // BIOS is not firing missed alarms from the previous day,
-                // if close to the end of the day,
-                // schedule the alarm rather on the next day
-                if (nextalarm_tm->tm_hour == 23 &&
-                    nextalarm_tm->tm_min >= 55)
-                {
-                    nextalarm_tm->tm_hour = 0;
-                    nextalarm_tm->tm_min = 0;
-                }
-
-                pfbios.reset_rtc_alarm();
-
-                pfbios.set_rtc_alarm(
-                    nextalarm_tm->tm_hour,
-                    nextalarm_tm->tm_min);
-
-                if (internal_state.animate_waitnextminute &&
-                    !internal_state.force_passed1minute_event)
-                {
-                    internal_state.animate_waitnextminute = FALSE;
-                    internal_state.animate_prep = TRUE;
-                    internal_state.all_cylinders = TRUE;
-                }
-                internal_state.force_passed1minute_event = FALSE;
-                internal_state.do_dgclock_refresh = TRUE;
-
-                if (timer_events.passed_10minutes)
-                {
-                    internal_state.window_arrangement =
-                        switch_window_arrangement(
-                            internal_state.window_arrangement,
-                            graph,
-                            dgclock);
-                    internal_state.refresh_screen = TRUE;
-                }
-                if (timer_events.passed_halfanhour)
-                {
-                    pfbios.beep_rndtone();
-                }
-                if (timer_events.passed_fullhour)
-                {
-                    pfbios.beep_rndtone();
-                }
-            }
+            continue;
+        }
 
-            // internal state events
-            if (internal_state.refresh_screen)
-            {
-                internal_state.refresh_screen = FALSE;
-#ifdef NTVDM
-                graph.cls_withpattern(0);
-#else
-                graph.cls_withzigzag();
+#ifdef TELEMETRY
+        tlmlog.end_wake();
 #endif
-                internal_state.do_dgclock_refresh = TRUE;
-
-                if (internal_state.all_cylinders ||
-                    internal_state.animate_waitnextminute)
-                {
-                    internal_state.animate_prep = TRUE;
-                    internal_state.all_cylinders = TRUE;
-                }
-            }
-
-            if (internal_state.do_dgclock_refresh)
-            {
-                internal_state.do_dgclock_refresh = FALSE;
-                internal_state.do_vram_refresh = TRUE;
-                dgclock.draw(time_digits);
-            }
-            if (internal_state.animate_prep)
-            {
-                internal_state.animate_prep = FALSE;
-                internal_state.do_vram_refresh = TRUE;
-                graph.anim_prep();
-            }
-            if (internal_state.all_cylinders)
-            {
-                internal_state.do_vram_refresh = TRUE;
-                if (graph.animate_finished())
-                {
-                    internal_state.all_cylinders = FALSE;
-                    internal_state.animate_waitnextminute = TRUE;
-                }
-            }
-            if (internal_state.do_vram_refresh)
-            {
-                internal_state.do_vram_refresh = FALSE;
-                graph.vram_copy();
+#ifndef HOSTSIM
+        // an event posted since wake_tasks() looked would sleep till the
+        // next interrupt, so the last look is with interrupts masked;
+        // sti lets them in only once hlt has started
+        asm cli;
+        if (timer.has_events())
+        {
+            asm sti;
+        }
+        else
+        {
+            // halts POFO interruptibly, for either 1 second, or
+            // ~2 minutes; depending on the current clocktick speed
+            asm {
+                sti
+                hlt
             }
-            if (!internal_state.all_cylinders)
-            {
-                asm hlt;    // <- this will halt POFO interruptibly,
-                            // for either 1 second, or ~2 minutes;
-                            // depending on the current clocktick speed
+        }
+#else // #ifdef HOSTSIM
+        hostsim_halt();
+#endif
+#ifdef TELEMETRY
+        tlmlog.begin_wake(timer.get_now_sec());
+#endif
 
 #ifdef NTVDM
-                delay(50);
+        delay(50);
 #endif
-            }
-        }
-        while (!kbhit());   // <- this will reset the POFO's
-                            // internal power-off ticks counter
     }
-    while ((c = getch()) != ESC_CHAR);
 
-exit:
+#ifdef TELEMETRY
+    tlmlog.end_wake();
+    tlmlog.flush();
+#endif
+#ifdef BIOSTRACE
+    BiosTrace::dump();
+#endif
+#ifdef PROFILE
+    Profiler::dump(clkgov, timer);
+#endif
+    unsigned long const now_sec = timer.get_now_sec();
+
     timer.deregister_handlers();
     pfbios.set_clockspeed(PFBios::clockspeed_normal);
     pfbios.set_cursor_mode(CURSOR_MODE_BLOCK);
     pfbios.set_videomode(VIDMODE_MDATEXT80x25);
 
+    clkgov.write(TXTLINE_STDOUT, now_sec);
+
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2022-2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "pit.h"
+
+#include <stddef.h>
+
+#ifdef HOSTSIM
+#include <dos.h>
+#endif
+
+#define PIT_PORT_COUNTER0 0x40
+#define PIT_PORT_MODE 0x43
+#define PIT_LATCH_COUNTER0 0x00
+
+PitStopwatch *
+    PitStopwatch::running = NULL;
+
+PitStopwatch::PitStopwatch() :
+    outer(NULL),
+    last_count(0),
+    elapsed(0)
+{
+}
+
+#pragma warn -rvl
+word_t PitStopwatch::read_counter(void)
+{
+#ifndef HOSTSIM
+    asm {
+        pushf
+        cli
+        mov  al,PIT_LATCH_COUNTER0
+        out  PIT_PORT_MODE,al
+        in   al,PIT_PORT_COUNTER0   // LSB
+        mov  ah,al
+        in   al,PIT_PORT_COUNTER0   // MSB
+        xchg al,ah
+        popf
+    }
+#else // #ifdef HOSTSIM
+    outportb(PIT_PORT_MODE, PIT_LATCH_COUNTER0);
+    word_t count = inportb(PIT_PORT_COUNTER0);     // LSB
+    return count | inportb(PIT_PORT_COUNTER0) << BITS_PER_BYTE;
+#endif
+}
+#pragma warn +rvl
+
+void PitStopwatch::start(void)
+{
+    last_count = read_counter();
+    elapsed = 0;
+
+    for (PitStopwatch * sw = running; sw != NULL; sw = sw->outer)
+        if (sw == this)
+            return;             // restarted, stays where it is
+
+    outer = running;
+    running = this;
+}
+
+void PitStopwatch::stop(void)
+{
+    sample();
+
+    if (running == this)
+        running = outer;
+    outer = NULL;
+}
+
+void PitStopwatch::sample(void)
+{
+    /*
+     * Counter runs down and wraps every 65536 counts (~55 ms),
+     * must be sampled more often than that to not lose wraps;
+     * stages that run longer call sample_running() in between.
+     */
+    word_t count = read_counter();
+
+    elapsed += (word_t)(last_count - count);
+    last_count = count;
+}
+
+void PitStopwatch::sample_running(void)
+{
+    for (PitStopwatch * sw = running; sw != NULL; sw = sw->outer)
+        sw->sample();
+}
+
+unsigned long PitStopwatch::get_elapsed(void) const
+{
+    return elapsed;
+}
+
+unsigned long PitStopwatch::counts_to_us(unsigned long counts)
+{
+    // whole seconds apart, a count is 0.838 us
+    return counts / PIT_HZ * 1000000l + counts % PIT_HZ * 838 / 1000;
+}
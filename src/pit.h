@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2022-2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Programmable interval timer (8253/8254), channel 0
+ *
+ * The counter runs, only its wraps (~55 ms) raise no interrupt that
+ * anything counts, see monoclk.h. A stopwatch takes the differences
+ * of its reads, so a span longer than a wrap has to be sampled in
+ * between. Stopwatches nest, the telemetry's awake one around the
+ * profiler's stage one; sample_running() samples all of the started.
+ */
+
+#ifndef _PIT_H
+#define _PIT_H 1
+
+#include "common.h"
+
+#define PIT_HZ 1193182l         // counter input clock
+
+class PitStopwatch
+{
+    static PitStopwatch *
+        running;                // the one started last
+    PitStopwatch *
+        outer;                  // started before it, still running
+    word_t
+        last_count;
+    unsigned long
+        elapsed;
+
+public:
+    PitStopwatch();
+
+    static word_t
+        read_counter(void);
+    void
+        start(void);
+    void
+        stop(void);             // sampled, off the running ones
+    void
+        sample(void);
+    static void
+        sample_running(void);   // from inside stages longer than a wrap
+    unsigned long
+        get_elapsed(void) const;
+    static unsigned long
+        counts_to_us(unsigned long);
+};
+
+#endif
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifdef PROFILE
+
+#include "profiler.h"
+#include "txtline.h"
+
+#include <dos.h>
+#include <string.h>
+
+char const * const
+    Profiler::dump_filename = "PFWALLCL.PRF";
+
+char const * const
+    Profiler::stage_names[STAGES_NUM] = {
+        "EVENTS",
+        "DGCLOCK",
+        "ANIM_PREP",
+        "ANIMATE",
+        "VRAM_COPY"
+    };
+
+Profiler::stage_sum_t
+    Profiler::sums[STAGES_NUM];
+
+PitStopwatch
+    Profiler::stopwatch;
+unsigned int
+    Profiler::started = FALSE;
+
+void Profiler::begin(void)
+{
+    stopwatch.start();
+    started = TRUE;
+}
+
+void Profiler::end(Profiler::stage_t stage)
+{
+    if (!started)
+        return;
+    started = FALSE;
+
+    stopwatch.stop();
+    unsigned long us = PitStopwatch::counts_to_us(stopwatch.get_elapsed());
+    stage_sum_t & const sum = sums[stage];
+
+    if (sum.calls == 0 || us < sum.min_us)
+        sum.min_us = us;
+    if (us > sum.max_us)
+        sum.max_us = us;
+    sum.total_us += us;
+    sum.calls++;
+}
+
+void Profiler::cancel(void)
+{
+    if (started)
+        stopwatch.stop();
+    started = FALSE;
+}
+
+int Profiler::dump(ClkGovernor const & const clkgov, Timer & const timer)
+{
+    int fd;
+    int res = RET_SUCCESS;
+    char line[64];
+
+    if (_dos_creat(dump_filename, _A_NORMAL, &fd) != 0)
+        return RET_FAILURE;
+
+    strcpy(line, "STAGE          CALLS     MIN US     AVG US     MAX US");
+    res |= TxtLine::write(fd, line, line + strlen(line));
+
+    for (unsigned int i = 0; i < STAGES_NUM; i++)
+    {
+        stage_sum_t const & const sum = sums[i];
+        char * s = line;
+
+        s = TxtLine::put_str(s, stage_names[i], 9);
+        s = TxtLine::put_dec(s, sum.calls, 10);
+        s = TxtLine::put_dec(s, sum.min_us, 10);
+        s = TxtLine::put_dec(s, sum.calls ? sum.total_us / sum.calls : 0, 10);
+        s = TxtLine::put_dec(s, sum.max_us, 10);
+        res |= TxtLine::write(fd, line, s);
+    }
+
+    res |= clkgov.write(fd, timer.get_now_sec());
+
+    strcpy(line, "TIMER EVENTS  COUNT");
+    res |= TxtLine::write(fd, line, line + strlen(line));
+    char * s = TxtLine::put_str(line, "DROPPED", 9);
+    s = TxtLine::put_dec(s, timer.get_events_dropped(), 9);
+    res |= TxtLine::write(fd, line, s);
+
+    _dos_close(fd);
+
+    return res ? RET_FAILURE : RET_SUCCESS;
+}
+
+#endif
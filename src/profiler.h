@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Main loop stage profiler, PROFILE builds only
+ *
+ * The main loop brackets each stage with begin() / end(), timed with
+ * a PIT stopwatch; calls, min, avg and max per stage. dump() writes
+ * them out as text, with the governor's time in each clockspeed and
+ * the timer events dropped for a full ring.
+ *
+ * The PIT counter wraps every ~55 ms unseen, so the stages that take
+ * longer sample it in between (PitStopwatch::sample_running()), as for
+ * the telemetry; the monotonic clock, a tick period at a time, is for
+ * spans of many ticks only.
+ */
+
+#ifndef _PROFILER_H
+#define _PROFILER_H 1
+
+#include "common.h"
+#include "pit.h"
+#include "clkgov.h"
+#include "timer.h"
+
+class Profiler
+{
+public:
+    enum stage_t {
+        STAGE_EVENTS,
+        STAGE_DGCLOCK,
+        STAGE_ANIM_PREP,
+        STAGE_ANIMATE,
+        STAGE_VRAM_COPY,
+        STAGES_NUM
+    };
+
+    struct stage_sum_t {
+        unsigned long calls;
+        unsigned long min_us;
+        unsigned long max_us;
+        unsigned long total_us;
+    };
+
+private:
+    static char const * const
+        dump_filename;
+    static char const * const
+        stage_names[STAGES_NUM];
+
+    static stage_sum_t
+        sums[STAGES_NUM];
+
+    static PitStopwatch
+        stopwatch;
+    static unsigned int
+        started;
+
+public:
+    static void
+        begin(void);
+    static void
+        end(stage_t);
+    static void
+        cancel(void);           // e.g. the stage powers off
+    static int
+        dump(ClkGovernor const & const, Timer & const);
+};
+
+#endif
@@ -0,0 +1,476 @@
+/*
+ * Copyright (c) 2022-2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "pwrsched.h"
+
+#define SOURCE_NONE 0xff
+
+static byte_t const
+    days_in_month[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+static unsigned int
+    is_leap_year(unsigned int year)
+{
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+PwrSched::PwrSched() :
+    nweek_windows(0),
+    nexceptions(0),
+    nexception_windows(0),
+    daily_on_min(PWRSCHED_UNSET),
+    daily_off_min(PWRSCHED_UNSET),
+    nspecial_days(0),
+    nwindows(0)
+{
+    table_first[0] = 0;
+    for (unsigned int t = 1; t <= PWRSCHED_MAX_TABLES; t++)
+        table_first[t] = 0;
+}
+
+unsigned int
+    PwrSched::days_since_1980(
+        unsigned int year, unsigned int month, unsigned int mday)
+{
+    unsigned int days = 0;
+
+    for (unsigned int y = 1980; y < year; y++)
+        days += is_leap_year(y) ? 366 : 365;
+
+    for (unsigned int m = 1; m < month; m++)
+        days += days_in_month[m - 1] + (m == 2 && is_leap_year(year));
+
+    return days + mday - 1;
+}
+
+unsigned int
+    PwrSched::weekday(unsigned int day)
+{
+    return (day + 2) % PWRSCHED_DAYS_PER_WEEK; // 1980-01-01 was a Tuesday
+}
+
+int
+    PwrSched::add_week_window(
+        byte_t day_mask, unsigned int on_min, unsigned int off_min)
+{
+    if (nweek_windows >= PWRSCHED_MAX_WEEK_WINDOWS)
+        return RET_FAILURE;
+
+    week_windows[nweek_windows].window.on_min = on_min;
+    week_windows[nweek_windows].window.off_min = off_min;
+    week_windows[nweek_windows].day_mask = day_mask;
+    nweek_windows++;
+
+    return RET_SUCCESS;
+}
+
+int
+    PwrSched::find_exception(unsigned int day) const
+{
+    for (unsigned int i = 0; i < nexceptions; i++)
+        if (exception_days[i] == day)
+            return i;
+
+    return -1;
+}
+
+int
+    PwrSched::add_exception(unsigned int day)
+{
+    if (find_exception(day) >= 0)
+        return RET_SUCCESS;
+
+    if (nexceptions >= PWRSCHED_MAX_EXCEPTIONS)
+        return RET_FAILURE;
+
+    exception_days[nexceptions++] = day;
+
+    return RET_SUCCESS;
+}
+
+int
+    PwrSched::add_exception_window(
+        unsigned int day, unsigned int on_min, unsigned int off_min)
+{
+    // an exception covers its own date only
+    if (off_min <= on_min
+        || nexception_windows >= PWRSCHED_MAX_EXCEPTION_WINDOWS
+        || add_exception(day) == RET_FAILURE)
+        return RET_FAILURE;
+
+    exception_windows[nexception_windows].window.on_min = on_min;
+    exception_windows[nexception_windows].window.off_min = off_min;
+    exception_windows[nexception_windows].exception = find_exception(day);
+    nexception_windows++;
+
+    return RET_SUCCESS;
+}
+
+int
+    PwrSched::set_daily(int pon_min, int poff_min)
+{
+    // both given, a window every day, night mode crosses midnight
+    if (pon_min != PWRSCHED_UNSET && poff_min != PWRSCHED_UNSET
+        && pon_min != poff_min)
+        return add_week_window(PWRSCHED_ALL_DAYS, pon_min, poff_min);
+
+    // otherwise plain power on / off times, no on period
+    daily_on_min = pon_min;
+    daily_off_min = poff_min;
+
+    return RET_SUCCESS;
+}
+
+int
+    PwrSched::add_special_day(
+        unsigned int day, byte_t own_source, byte_t spill_source)
+{
+    unsigned int i = nspecial_days;
+
+    if (nspecial_days >= PWRSCHED_MAX_SPECIAL_DAYS)
+        return RET_FAILURE;
+
+    // insertion sort, by day
+    for (; i > 0 && special_days[i - 1].day > day; i--)
+        special_days[i] = special_days[i - 1];
+
+    special_days[i].day = day;
+    special_days[i].own_source = own_source;
+    special_days[i].spill_source = spill_source;
+    nspecial_days++;
+
+    return RET_SUCCESS;
+}
+
+int
+    PwrSched::append_window(unsigned int on_min, unsigned int off_min)
+{
+    if (on_min >= off_min)
+        return RET_SUCCESS; // empty
+
+    if (nwindows >= PWRSCHED_MAX_WINDOWS)
+        return RET_FAILURE;
+
+    windows[nwindows].on_min = on_min;
+    windows[nwindows].off_min = off_min;
+    nwindows++;
+
+    return RET_SUCCESS;
+}
+
+int
+    PwrSched::append_source(byte_t source, unsigned int spill)
+{
+    if (source == SOURCE_NONE)
+        return RET_SUCCESS;
+
+    if (source < PWRSCHED_DAYS_PER_WEEK)
+    {
+        for (unsigned int i = 0; i < nweek_windows; i++)
+        {
+            window_t const * const
+                w = &week_windows[i].window;
+            unsigned int const
+                crosses_midnight = w->off_min <= w->on_min;
+
+            if (!(week_windows[i].day_mask & (1 << source)))
+                continue;
+
+            if (spill ?
+                    crosses_midnight &&
+                        append_window(0, w->off_min) == RET_FAILURE :
+                    append_window(
+                        w->on_min,
+                        crosses_midnight ? MINUTES_PER_DAY : w->off_min)
+                            == RET_FAILURE)
+                return RET_FAILURE;
+        }
+    }
+    else if (!spill) // exception windows never spill
+    {
+        for (unsigned int i = 0; i < nexception_windows; i++)
+        {
+            if (exception_windows[i].exception
+                    != source - PWRSCHED_DAYS_PER_WEEK)
+                continue;
+
+            if (append_window(
+                    exception_windows[i].window.on_min,
+                    exception_windows[i].window.off_min) == RET_FAILURE)
+                return RET_FAILURE;
+        }
+    }
+
+    return RET_SUCCESS;
+}
+
+void
+    PwrSched::sort_merge_table(unsigned int first)
+{
+    unsigned int i, j;
+
+    // insertion sort, by power on time
+    for (i = first + 1; i < nwindows; i++)
+    {
+        window_t w = windows[i];
+
+        for (j = i; j > first && windows[j - 1].on_min > w.on_min; j--)
+            windows[j] = windows[j - 1];
+
+        windows[j] = w;
+    }
+
+    // merge the overlapping and adjacent ones
+    for (i = first, j = first + 1; j < nwindows; j++)
+    {
+        if (windows[j].on_min <= windows[i].off_min)
+            windows[i].off_min = MAX(windows[i].off_min, windows[j].off_min);
+        else
+            windows[++i] = windows[j];
+    }
+
+    if (nwindows > first)
+        nwindows = i + 1;
+}
+
+int
+    PwrSched::compile(void)
+{
+    unsigned int i;
+
+    nspecial_days = 0;
+    nwindows = 0;
+
+    for (i = 0; i < nexceptions; i++)
+    {
+        unsigned int const
+            day = exception_days[i];
+
+        if (add_special_day(
+                day,
+                PWRSCHED_DAYS_PER_WEEK + i,
+                find_exception(day - 1) >= 0 ?
+                    SOURCE_NONE :
+                    weekday(day - 1)) == RET_FAILURE)
+            return RET_FAILURE;
+    }
+
+    // day after an exception, no spill from the weekday before
+    for (i = 0; i < nexceptions; i++)
+    {
+        unsigned int const
+            day = exception_days[i] + 1;
+
+        if (find_exception(day) < 0
+            && add_special_day(
+                day, weekday(day), SOURCE_NONE) == RET_FAILURE)
+            return RET_FAILURE;
+    }
+
+    for (unsigned int t = 0;
+        t < PWRSCHED_DAYS_PER_WEEK + (unsigned int)nspecial_days; t++)
+    {
+        byte_t own_source = t;
+        byte_t spill_source = (t + PWRSCHED_DAYS_PER_WEEK - 1) % PWRSCHED_DAYS_PER_WEEK;
+
+        if (t >= PWRSCHED_DAYS_PER_WEEK)
+        {
+            own_source = special_days[t - PWRSCHED_DAYS_PER_WEEK].own_source;
+            spill_source = special_days[t - PWRSCHED_DAYS_PER_WEEK].spill_source;
+        }
+
+        table_first[t] = nwindows;
+
+        if (append_source(own_source, FALSE) == RET_FAILURE
+            || append_source(spill_source, TRUE) == RET_FAILURE)
+            return RET_FAILURE;
+
+        sort_merge_table(table_first[t]);
+    }
+
+    table_first[PWRSCHED_DAYS_PER_WEEK + nspecial_days] = nwindows;
+
+    return RET_SUCCESS;
+}
+
+unsigned int
+    PwrSched::table_for_day(unsigned int day) const
+{
+    unsigned int lo = 0, hi = nspecial_days;
+
+    while (lo < hi)
+    {
+        unsigned int mid = (lo + hi) / 2;
+
+        if (special_days[mid].day < day)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo < nspecial_days && special_days[lo].day == day)
+        return PWRSCHED_DAYS_PER_WEEK + lo;
+
+    return weekday(day);
+}
+
+unsigned int
+    PwrSched::starts_at_midnight(unsigned int table) const
+{
+    return table_first[table] < table_first[table + 1]
+        && windows[table_first[table]].on_min == 0;
+}
+
+unsigned int
+    PwrSched::ends_at_midnight(unsigned int table) const
+{
+    return table_first[table] < table_first[table + 1]
+        && windows[table_first[table + 1] - 1].off_min == MINUTES_PER_DAY;
+}
+
+void
+    PwrSched::lookup(
+        unsigned int day,
+        unsigned int now_min,
+        PwrSched::lookup_t * const result) const
+{
+    int const
+        horizon = PWRSCHED_HORIZON_DAYS * MINUTES_PER_DAY;
+    unsigned int
+        prev_table = table_for_day(day - 1),
+        table = table_for_day(day),
+        lo = table_first[table],
+        hi = table_first[table + 1];
+
+    // first window of the day ending at or after now
+    while (lo < hi)
+    {
+        unsigned int mid = (lo + hi) / 2;
+
+        if (windows[mid].off_min < now_min)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    result->on_now =
+        lo < table_first[table + 1]
+        && windows[lo].on_min <= now_min
+        && now_min < windows[lo].off_min;
+    result->to_on = -1;
+    result->to_off = -1;
+
+    // powered off at midnight just now
+    if (now_min == 0
+        && ends_at_midnight(prev_table) && !starts_at_midnight(table))
+        result->to_off = 0;
+
+    /*
+     * Walk the windows forward day by day, skipping the midnight
+     * window edges that only split an on period over two days.
+     */
+    for (unsigned int k = 0;
+        k <= PWRSCHED_HORIZON_DAYS
+            && (result->to_on < 0 || result->to_off < 0);
+        k++)
+    {
+        unsigned int const
+            next_table = table_for_day(day + k + 1);
+        int const
+            base = (int)(k * MINUTES_PER_DAY) - (int)now_min;
+
+        for (unsigned int i = k == 0 ? lo : table_first[table];
+            i < table_first[table + 1];
+            i++)
+        {
+            int const to_on = base + windows[i].on_min;
+            int const to_off = base + windows[i].off_min;
+
+            if (result->to_on < 0
+                && to_on >= 0 && to_on < horizon
+                && !(windows[i].on_min == 0 && ends_at_midnight(prev_table)))
+                result->to_on = to_on;
+
+            if (result->to_off < 0
+                && to_off >= 0 && to_off < horizon
+                && !(windows[i].off_min == MINUTES_PER_DAY
+                    && starts_at_midnight(next_table)))
+                result->to_off = to_off;
+        }
+
+        prev_table = table;
+        table = next_table;
+    }
+
+    // plain daily power on / off times
+    if (daily_on_min != PWRSCHED_UNSET)
+    {
+        int to_on = (daily_on_min + MINUTES_PER_DAY - now_min) % MINUTES_PER_DAY;
+        if (result->to_on < 0 || to_on < result->to_on)
+            result->to_on = to_on;
+    }
+    if (daily_off_min != PWRSCHED_UNSET)
+    {
+        int to_off = (daily_off_min + MINUTES_PER_DAY - now_min) % MINUTES_PER_DAY;
+        if (result->to_off < 0 || to_off < result->to_off)
+            result->to_off = to_off;
+    }
+}
+
+unsigned int
+    PwrSched::poweroff_delay_min(
+        unsigned int day,
+        unsigned int now_min,
+        int kbhit_poff_delay_min) const
+{
+    PwrSched::lookup_t now;
+
+    lookup(day, now_min, &now);
+
+    return poweroff_delay_min(&now, kbhit_poff_delay_min);
+}
+
+unsigned int
+    PwrSched::poweroff_delay_min(
+        PwrSched::lookup_t const * const now,
+        int kbhit_poff_delay_min)
+{
+    /*
+        - In an on period, power off at its power off time.
+        - If power off time is crossed by khit + power off delay,
+          we're leaving an on period, power off at its power off time.
+        - If power on time is crossed, we're landing in an on period,
+          power off at its power off time, or kbhit power off delay after
+          the power on time if there's none.
+        - Kbhit power off delay applies otherwise.
+        Power off time is never sooner than the minimal kbhit power off delay,
+        with no power off time within the horizon, stay on until its end.
+    */
+
+    unsigned int const
+        kbhit_poff_delay =
+            kbhit_poff_delay_min != PWRSCHED_UNSET ?
+                kbhit_poff_delay_min :
+                DEFAULT_POFF_DELAY_ONKBHIT_MINUTES;
+    unsigned int const
+        poff_delay =
+            now->to_off < 0 ?
+                PWRSCHED_HORIZON_DAYS * MINUTES_PER_DAY :
+                MAX(now->to_off, MIN_POFF_DELAY_ONKBHIT_MINUTES);
+
+    if (now->on_now
+        || (now->to_off > 0 && kbhit_poff_delay > (unsigned int)now->to_off)
+        ) /* in- or leaving onperiod */
+        return poff_delay;
+    else if (now->to_on >= 0 && kbhit_poff_delay > (unsigned int)now->to_on
+        ) /* entering on period */
+        return now->to_off >= 0 ?
+            poff_delay :
+            now->to_on + kbhit_poff_delay;
+    else /* in offperiod */
+        return kbhit_poff_delay;
+}
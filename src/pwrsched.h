@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2022-2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Power on / off schedule: weekly windows and date exceptions compiled
+ * into per-day tables of sorted windows, portable (also built by the host
+ * tests)
+ */
+
+#ifndef _PWRSCHED_H
+#define _PWRSCHED_H 1
+
+#include "common.h"
+
+#define PWRSCHED_UNSET -1
+#define PWRSCHED_DAYS_PER_WEEK 7
+#define PWRSCHED_ALL_DAYS 0x7f
+#define PWRSCHED_HORIZON_DAYS 8     // how far the next power on / off is looked up
+#define PWRSCHED_MAX_WEEK_WINDOWS 16
+#define PWRSCHED_MAX_EXCEPTIONS 8
+#define PWRSCHED_MAX_EXCEPTION_WINDOWS 16
+#define PWRSCHED_MAX_SPECIAL_DAYS (2 * PWRSCHED_MAX_EXCEPTIONS)
+#define PWRSCHED_MAX_TABLES (PWRSCHED_DAYS_PER_WEEK + PWRSCHED_MAX_SPECIAL_DAYS)
+#define PWRSCHED_MAX_WINDOWS 64
+
+class PwrSched
+{
+public:
+    struct lookup_t {
+        unsigned int on_now;
+        int to_on;              // minutes to the next power on time,
+                                // -1 if none within the horizon
+        int to_off;             // minutes to the next power off time,
+                                // -1 if none within the horizon
+    };
+
+private:
+    struct window_t {
+        unsigned int on_min;
+        unsigned int off_min;   // compiled: on_min < off_min <= MINUTES_PER_DAY,
+                                // input: off_min <= on_min crosses midnight
+    };
+
+    struct week_window_t {
+        window_t window;
+        byte_t day_mask;        // bit 0 is Sunday
+    };
+
+    struct exception_window_t {
+        window_t window;
+        byte_t exception;       // index into exception_days
+    };
+
+    /*
+     * Day with a table of its own: an exception date, or the day after one
+     * (weekday windows spilling over midnight must not reach it).
+     * Window sources are weekdays 0..6, exceptions from 7 on.
+     */
+    struct special_day_t {
+        unsigned int day;
+        byte_t own_source;
+        byte_t spill_source;    // windows spilling over from the day before
+    };
+
+    week_window_t
+        week_windows[PWRSCHED_MAX_WEEK_WINDOWS];
+    byte_t
+        nweek_windows;
+    unsigned int
+        exception_days[PWRSCHED_MAX_EXCEPTIONS];
+    byte_t
+        nexceptions;
+    exception_window_t
+        exception_windows[PWRSCHED_MAX_EXCEPTION_WINDOWS];
+    byte_t
+        nexception_windows;
+    int
+        daily_on_min;           // TriggerPowerOn/OffAt not forming a window
+    int
+        daily_off_min;
+
+    // compiled
+    special_day_t
+        special_days[PWRSCHED_MAX_SPECIAL_DAYS]; // sorted by day
+    byte_t
+        nspecial_days;
+    window_t
+        windows[PWRSCHED_MAX_WINDOWS];
+    byte_t
+        table_first[PWRSCHED_MAX_TABLES + 1];   // table t is windows
+                                                // [table_first[t], table_first[t + 1])
+    byte_t
+        nwindows;
+
+    int
+        find_exception(unsigned int) const;
+    int
+        add_special_day(unsigned int, byte_t, byte_t);
+    int
+        append_window(unsigned int, unsigned int);
+    int
+        append_source(byte_t, unsigned int);
+    void
+        sort_merge_table(unsigned int);
+    unsigned int
+        table_for_day(unsigned int) const;
+    unsigned int
+        starts_at_midnight(unsigned int) const;
+    unsigned int
+        ends_at_midnight(unsigned int) const;
+
+public:
+    PwrSched();
+
+    int
+        add_week_window(byte_t, unsigned int, unsigned int);
+    int
+        add_exception(unsigned int);
+    int
+        add_exception_window(unsigned int, unsigned int, unsigned int);
+    int
+        set_daily(int, int);
+    int
+        compile(void);
+    void
+        lookup(unsigned int, unsigned int, lookup_t * const) const;
+    unsigned int
+        poweroff_delay_min(unsigned int, unsigned int, int) const;
+    static unsigned int
+        poweroff_delay_min(lookup_t const * const, int);
+
+    static unsigned int
+        days_since_1980(unsigned int, unsigned int, unsigned int);
+    static unsigned int
+        weekday(unsigned int);
+};
+
+#endif
@@ -9,13 +9,24 @@
 
 #include "timer.h"
 #include "inifile.h"
+#include "arena.h"
 
-#include <time.h>
-#include <stdlib.h>
 #include <conio.h>
 #include <limits.h>
 #include <assert.h>
 
+static unsigned int
+    fake_now_min = 0;
+
+static void
+    fake_clock_source(
+        unsigned int & const day,
+        unsigned int & const day_min)
+{
+    day = 0;
+    day_min = fake_now_min;
+}
+
 unsigned int Timer::test_poweroff_delay(
     struct dostime_t * const fake_now,
     INIFile const * const inifile,
@@ -25,20 +36,20 @@ unsigned int Timer::test_poweroff_delay(
         poweroff_min = MIN_POFF_DELAY_ONKBHIT_MINUTES;
 
     set_poweroff_delay_minutes(poweroff_min);
-    unsigned long expected_ticks = internal_state.poweroff_ticks;
+    unsigned long expected_deadline = internal_state.poweroff_deadline_sec;
 
-    _dos_settime (fake_now);
+    fake_now_min = fake_now->hour * 60 + fake_now->minute;
     schedule_next_poweroff(inifile);
-    unsigned int real_ticks = internal_state.poweroff_ticks;
+    unsigned long real_deadline = internal_state.poweroff_deadline_sec;
 
     cout.width(5);
     cout
-        << "test_poweroff_delay: poweroff_ticks: expected "
-        << expected_ticks
+        << "test_poweroff_delay: poweroff_deadline_sec: expected "
+        << expected_deadline
         << ", got "
-        << real_ticks ;
+        << real_deadline ;
 
-    if (expected_ticks == real_ticks)
+    if (expected_deadline == real_deadline)
     {
         cout << " -> OK.\n";
         return TRUE;
@@ -53,16 +64,14 @@ unsigned int Timer::test_poweroff_delay(
 void Timer::test_schedule_next_poweroff(void)
 {
     struct dostime_t fake_now = { 0 };
-    fake_now.hsecond = 20;  // needs to be here, otherwise the time will be set
-                            // a little under the specified full hour.
-    putenv("TZ=UTC0");
-    tzset();
 
     INIFile * inifile;
+    unsigned int arena_mark = arena.mark();     // each case rewinds to here
 
     deregister_handlers();
+    set_clock_source(& fake_clock_source);
 
-    inifile = new INIFile(
+    inifile = new (arena) INIFile(
         NULL,
         NULL,
         NULL);
@@ -72,10 +81,10 @@ void Timer::test_schedule_next_poweroff(void)
     fake_now.minute = 0;
     assert(test_poweroff_delay(&fake_now, inifile, DEFAULT_POFF_DELAY_ONKBHIT_MINUTES));
 
-    delete inifile;
+    arena.release(arena_mark);
 
-    inifile = new INIFile(
-        new Timer::DaytimeHHMM(6),
+    inifile = new (arena) INIFile(
+        new (arena) Timer::DaytimeHHMM(6),
         NULL,
         NULL);
 
@@ -94,11 +103,11 @@ void Timer::test_schedule_next_poweroff(void)
     fake_now.minute = 56;
     assert(test_poweroff_delay(&fake_now, inifile, DEFAULT_POFF_DELAY_ONKBHIT_MINUTES + 4));
 
-    delete inifile;
+    arena.release(arena_mark);
 
-    inifile = new INIFile(
+    inifile = new (arena) INIFile(
         NULL,
-        new Timer::DaytimeHHMM(21),
+        new (arena) Timer::DaytimeHHMM(21),
         NULL);
 
     // default kbhit_delay not crossing poff
@@ -116,12 +125,12 @@ void Timer::test_schedule_next_poweroff(void)
     fake_now.minute = 58;
     assert(test_poweroff_delay(&fake_now, inifile, MIN_POFF_DELAY_ONKBHIT_MINUTES));
 
-    delete inifile;
+    arena.release(arena_mark);
 
-    inifile = new INIFile(
+    inifile = new (arena) INIFile(
         NULL,
         NULL,
-        new Timer::DaytimeHHMM(0, 30));
+        new (arena) Timer::DaytimeHHMM(0, 30));
 
     // kbhit_delay
     fake_now.hour = 4;
@@ -133,12 +142,12 @@ void Timer::test_schedule_next_poweroff(void)
     fake_now.minute = 58;
     assert(test_poweroff_delay(&fake_now, inifile, 30));
 
-    delete inifile;
+    arena.release(arena_mark);
 
-    inifile = new INIFile(
+    inifile = new (arena) INIFile(
         NULL,
-        new Timer::DaytimeHHMM(21),
-        new Timer::DaytimeHHMM(0, 30));
+        new (arena) Timer::DaytimeHHMM(21),
+        new (arena) Timer::DaytimeHHMM(0, 30));
 
     // kbhit_delay not crossing poff
     fake_now.hour = 4;
@@ -155,11 +164,11 @@ void Timer::test_schedule_next_poweroff(void)
     fake_now.minute = 58;
     assert(test_poweroff_delay(&fake_now, inifile, MIN_POFF_DELAY_ONKBHIT_MINUTES));
 
-    delete inifile;
+    arena.release(arena_mark);
 
-    inifile = new INIFile(
-        new Timer::DaytimeHHMM(4),
-        new Timer::DaytimeHHMM(5),
+    inifile = new (arena) INIFile(
+        new (arena) Timer::DaytimeHHMM(4),
+        new (arena) Timer::DaytimeHHMM(5),
         NULL);
 
     // default kbhit_delay not crossing poff
@@ -192,14 +201,14 @@ void Timer::test_schedule_next_poweroff(void)
     fake_now.minute = 1;
     assert(test_poweroff_delay(&fake_now, inifile, DEFAULT_POFF_DELAY_ONKBHIT_MINUTES));
 
-    delete inifile;
+    arena.release(arena_mark);
 
     // pon < poff
 
-    inifile = new INIFile(
-        new Timer::DaytimeHHMM(6),
-        new Timer::DaytimeHHMM(20),
-        new Timer::DaytimeHHMM(1, 30));
+    inifile = new (arena) INIFile(
+        new (arena) Timer::DaytimeHHMM(6),
+        new (arena) Timer::DaytimeHHMM(20),
+        new (arena) Timer::DaytimeHHMM(1, 30));
 
     fake_now.minute = 0;
 
@@ -227,14 +236,14 @@ void Timer::test_schedule_next_poweroff(void)
     fake_now.hour = 5;
     assert(test_poweroff_delay(&fake_now, inifile, 1 * 60 + (20 - 6) * 60));
 
-    delete inifile;
+    arena.release(arena_mark);
 
     // pon > poff
 
-    inifile = new INIFile(
-        new Timer::DaytimeHHMM(20),
-        new Timer::DaytimeHHMM(6),
-        new Timer::DaytimeHHMM(1, 30));
+    inifile = new (arena) INIFile(
+        new (arena) Timer::DaytimeHHMM(20),
+        new (arena) Timer::DaytimeHHMM(6),
+        new (arena) Timer::DaytimeHHMM(1, 30));
 
     // kbhit between pon .. poff, kbhit_delay not crossing midnight
     fake_now.hour = 22;
@@ -260,19 +269,68 @@ void Timer::test_schedule_next_poweroff(void)
     fake_now.hour = 19;
     assert(test_poweroff_delay(&fake_now, inifile,  (24 - 19 + 6) * 60));
 
-    delete inifile;
+    arena.release(arena_mark);
 
-    inifile = new INIFile(
+    inifile = new (arena) INIFile(
         NULL,
         NULL,
-        new Timer::DaytimeHHMM(18));
+        new (arena) Timer::DaytimeHHMM(18));
 
     // kbhit_delay > UINT_MAX
     fake_now.hour = 0;
     fake_now.minute = 0;
     assert(test_poweroff_delay(&fake_now, inifile, 18 * 60));
 
-    delete inifile;
+    arena.release(arena_mark);
+
+    set_clock_source(& Timer::dos_clock_source);
+}
+
+static unsigned int
+    poweroff_posted(Timer & const timer)
+{
+    Timer::event_t event;
+    unsigned int posted = FALSE;
+
+    while (timer.receive_event(event))
+        posted |= event == Timer::EVT_POWEROFF;
+
+    return posted;
+}
+
+void Timer::test_poweroff_deadline(void)
+{
+    unsigned long const sync_sec = 10l * 60 * SECONDS_PER_MINUTE;  // 10:00:00
+    unsigned long due_min;
+
+    // handlers deregistered by test_schedule_next_poweroff(), ticks by hand
+    set_clockspeed(PFBios::clockspeed_normal);
+    reset_events();
+    sync_clock(sync_sec);
+    set_poweroff_delay_minutes(1);      // between the first two ticks
+
+    // RTC alarm on the minute of the deadline
+    assert(get_poweroff_alarm_min(due_min));
+    assert(due_min == sync_sec / SECONDS_PER_MINUTE + 1);
+
+    // the first tick may come right after the sync, no time counted
+    tick();
+    assert(internal_state.now_sec == sync_sec);
+    assert(!poweroff_posted(* this));
+
+    // a whole period later for sure, the deadline has passed
+    tick();
+    assert(internal_state.now_sec ==
+        sync_sec + PFBios::clockspeed_tick_sec[PFBios::clockspeed_normal]);
+    assert(poweroff_posted(* this));
+    assert(!get_poweroff_alarm_min(due_min));
+
+    // an RTC behind the ticks doesn't take the clock backwards
+    sync_clock(sync_sec + SECONDS_PER_MINUTE);
+    assert(internal_state.now_sec ==
+        sync_sec + PFBios::clockspeed_tick_sec[PFBios::clockspeed_normal]);
+
+    cout << "test_poweroff_deadline: -> OK.\n";
 }
 
 #endif
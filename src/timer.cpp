@@ -7,6 +7,10 @@
 
 #include "timer.h"
 #include "inifile.h"
+#include "critsec.h"
+#include "pwrsched.h"
+#include "toneseq.h"
+#include "monoclk.h"
 
 #include <dos.h>
 #include <mem.h>
@@ -15,19 +19,62 @@
 
 struct Timer::internal_state_t
     Timer::internal_state =
-        { FALSE, FALSE, -1, 0, 0 };
+        { 0, 0, 0, 0, 0 };
+
+struct Timer::evring_t volatile
+    Timer::evring =
+        { { 0 }, 0, 0, 0 };
 
 Timer::time_digits_t::time_digits_t()
 {
     memset(digit_arr, -1, sizeof digit_arr);
 }
 
+unsigned int Timer::time_digits_t::get_abs_min() const
+{
+    return
+        (digit.hour_tens * 10 + digit.hour_ones) * 60 +
+        digit.minute_tens * 10 + digit.minute_ones;
+}
+
 Timer::Timer(
-    PFBios::clockspeed_t & const clockspeed) :
-    clockspeed (clockspeed),
+    PFBios::clockspeed_t const clockspeed) :
+    synced_sec(0),
+    last_day_sec(-1),
+    clock_source(& Timer::dos_clock_source),
     int1c_handler_orig_fp(NULL),
     int4a_handler_orig_fp(NULL)
 {
+    set_clockspeed(clockspeed);
+}
+
+void Timer::dos_clock_source(
+    unsigned int & const day,
+    unsigned int & const day_min)
+{
+    struct date
+        datep;
+    struct time
+        timep;
+
+    getdate(&datep);
+    gettime(&timep);
+
+    day = PwrSched::days_since_1980(datep.da_year, datep.da_mon, datep.da_day);
+    day_min = timep.ti_hour * 60 + timep.ti_min;
+}
+
+void Timer::read_clock(
+    unsigned int & const day,
+    unsigned int & const day_min)
+{
+    clock_source(day, day_min);
+}
+
+void Timer::set_clock_source(
+    Timer::clock_source_fp_t const clock_source)
+{
+    this->clock_source = clock_source;
 }
 
 void Timer::register_handler_int1c(void)
@@ -68,227 +115,194 @@ void Timer::deregister_handlers(void)
     deregister_handler_int1c();
 }
 
+void Timer::set_clockspeed(
+    PFBios::clockspeed_t const clockspeed)
+{
+    // only the tick period changes, the power-off deadline is kept;
+    // the next tick may come at once, as after a sync
+    CritSection critsec;
+    internal_state.tick_period_sec =
+        PFBios::clockspeed_tick_sec[clockspeed];
+    internal_state.ticks_since_sync = 0;
+}
+
+void Timer::sync_clock(unsigned long day_sec)
+{
+    /*
+     * Same as with the scheduler's minutes: accumulate the forward
+     * distance to the last known RTC daytime, epoch is midnight
+     * of the first day seen.
+     */
+    if (last_day_sec == -1)
+        synced_sec = day_sec;
+    else
+        synced_sec +=
+            (day_sec + SECONDS_PER_DAY - last_day_sec) % SECONDS_PER_DAY;
+
+    last_day_sec = day_sec;
+
+    // ticks counted short of the RTC, if anything; kept monotonic
+    CritSection critsec;
+    internal_state.now_sec = MAX(internal_state.now_sec, synced_sec);
+    internal_state.ticks_since_sync = 0;
+}
+
+unsigned long Timer::get_now_sec(void)
+{
+    CritSection critsec;
+    return internal_state.now_sec;
+}
+
+unsigned int Timer::get_poweroff_alarm_min(
+    unsigned long & const due_min)
+{
+    unsigned long poweroff_deadline_sec;
+    {
+        CritSection critsec;
+        poweroff_deadline_sec = internal_state.poweroff_deadline_sec;
+    }
+
+    if (poweroff_deadline_sec == 0)
+        return FALSE;
+
+    /*
+     * The tick handler sees the deadline up to two tick periods late
+     * (see tick()), over four minutes in normal mode. The RTC alarm at
+     * the minute rounded up is never early and under a minute late,
+     * whichever comes first powers off.
+     */
+    due_min =
+        (poweroff_deadline_sec + SECONDS_PER_MINUTE - 1) / SECONDS_PER_MINUTE;
+    return TRUE;
+}
+
 void Timer::set_poweroff_delay_override(
     Timer::DaytimeHHMM const & const poweroff_delay_override_dayt)
 {
-    asm { cli };
+    CritSection critsec;
     internal_state.poweroff_delay_override = poweroff_delay_override_dayt.get_abs_min();
-    asm { sti };
 }
 
 void Timer::unset_poweroff_delay_override()
 {
-    asm { cli };
+    CritSection critsec;
     internal_state.poweroff_delay_override = 0;
-    asm { sti };
 }
 
 void Timer::schedule_next_poweroff(
     INIFile const * const inifile)
 {
-    /*
-        What's behind the monstrous conditional below?
-        - User can specify power on at / power off at / power off delay on-keyboard-hit time(s).
-        - If either power off or power on time is crossed by khit + power off delay,
-          we're leaving from ... or landing in between power on -- power off times;
-          -> -power off at- time will be applied as defined in the .ini file,
-          kbhit power off delay won't be applied, it will apply otherwise.
-        - Either of the above-mentioned config options can be omitted by the user.
-    */
-
-    /*
-        Legend (apply below):
-        'pon'  : power on time as specified in the ini file.
-        'poff' : power off time as specified in the ini file.
-        'kbhit_poff_delay' : power off delay on keyboard hit as spec. in the ini file.
-    */
-
-    /*
-        From the priority point of view: pon = poff > kbhit_poff_delay
-    */
-
-    asm { cli };
-    if (internal_state.poweroff_delay_override)
+    unsigned int poweroff_delay_override;
     {
-        set_poweroff_delay_minutes(internal_state.poweroff_delay_override);
-        asm { sti };
+        CritSection critsec;
+        poweroff_delay_override = internal_state.poweroff_delay_override;
+    }
+    if (poweroff_delay_override)
+    {
+        set_poweroff_delay_minutes(poweroff_delay_override);
         return;
     }
-    asm { sti };
 
-    struct time
-        timep;
+    unsigned int day, day_min;
 
-    gettime(&timep);
+    clock_source(day, day_min);
 
-    Timer::DaytimeHHMM const
-        now (
-            timep.ti_hour, timep.ti_min);
-    Timer::DaytimeHHMM const & const
-        pon =
-            * inifile->pon_dayt_p;
-    Timer::DaytimeHHMM const & const
-        poff =
-            * inifile->poff_dayt_p;
-    int
-        now_poff_delay =
-            inifile->poff_dayt_p ?
-                poff - now :
-                -1;
-    int
-        now_pon_delay =
-            inifile->pon_dayt_p ?
-                pon - now :
-                -1;
-    unsigned int
-        kbhit_poff_delay =
+    set_poweroff_delay_minutes(
+        inifile->pwrsched_p->poweroff_delay_min(
+            day,
+            day_min,
             inifile->kbhit_poff_delay_dayt_p ?
                 inifile->kbhit_poff_delay_dayt_p->get_abs_min() :
-                DEFAULT_POFF_DELAY_ONKBHIT_MINUTES;
-    unsigned int
-        now_poff_delay_on_kbhit =
-            now_poff_delay < MIN_POFF_DELAY_ONKBHIT_MINUTES ?
-                MIN_POFF_DELAY_ONKBHIT_MINUTES :
-                now_poff_delay;
-    unsigned int
-        kbhit_poff_delay_has_crossed_pon =
-            now_pon_delay >= 0 ?
-                kbhit_poff_delay > now_pon_delay :
-                FALSE;
-    unsigned int
-        kbhit_poff_delay_has_crossed_poff =
-            now_poff_delay > 0 ?
-                kbhit_poff_delay > now_poff_delay :
-                FALSE;
-    unsigned int
-        in_onperiod_daymode =
-            inifile->pon_dayt_p && inifile->poff_dayt_p ?
-                pon < poff && (now >= pon && now < poff) :
-                FALSE;
-    unsigned int
-        in_onperiod_nightmode =
-            inifile->pon_dayt_p && inifile->poff_dayt_p ?
-                pon > poff && (now >= pon || now < poff) :
-                FALSE;
-
-    if (kbhit_poff_delay_has_crossed_poff
-        || in_onperiod_daymode
-        || in_onperiod_nightmode
-        ) /* in- or leaving onperiod */
-        set_poweroff_delay_minutes(now_poff_delay_on_kbhit);
-    else if (kbhit_poff_delay_has_crossed_pon
-        ) /* entering on period */
-        inifile->poff_dayt_p ?
-            set_poweroff_delay_minutes(now_poff_delay_on_kbhit) :
-            set_poweroff_delay_minutes(now_pon_delay + kbhit_poff_delay);
-    else /* in offperiod */
-        set_poweroff_delay_minutes(kbhit_poff_delay);
+                PWRSCHED_UNSET));
 }
 
 void Timer::set_poweroff_delay_minutes(unsigned int minutes)
 {
-    if (clockspeed == PFBios::clockspeed_normal)
-        set_poweroff_ticks(minutes / 2u);
-
-    else if (clockspeed == PFBios::clockspeed_fast)
-        set_poweroff_ticks(minutes * 60l);
-}
-
-void Timer::set_poweroff_ticks(unsigned long poweroff_ticks)
-{
-    poweroff_ticks = MAX(poweroff_ticks, 1);
+    minutes = MAX(minutes, 1);
 #ifdef NTVDM
     cout
         << "Timer: Will power-off in "
-        << poweroff_ticks
-        << " ticks.\n";
+        << minutes
+        << " minutes.\n";
 #endif
-    asm { cli; };
-    internal_state.poweroff_now = FALSE;
-    internal_state.poweroff_ticks = poweroff_ticks;
-    asm { sti; };
+    CritSection critsec;
+    internal_state.poweroff_deadline_sec =
+        internal_state.now_sec + (unsigned long)minutes * SECONDS_PER_MINUTE;
+}
+
+unsigned int Timer::receive_event(event_t & const event)
+{
+    byte_t tail = evring.tail;
+
+    if (tail == evring.head)    // single byte read, atomic
+        return FALSE;
+
+    event = (event_t)evring.events[tail];
+    evring.tail = (tail + 1) & (TIMER_EVRING_SIZE - 1);
+
+    return TRUE;
 }
 
-unsigned int Timer::receive_passed1minute_event(void)
+unsigned int Timer::has_events(void) const
 {
-    asm { cli };
-    unsigned int passed_1minute = internal_state.passed_1minute;
-    internal_state.passed_1minute = FALSE;
-    asm { sti };
-    return passed_1minute;
+    return evring.tail != evring.head;  // single byte reads, atomic
 }
 
-unsigned int Timer::receive_poweroff_event(void)
+unsigned int Timer::get_events_dropped(void) const
 {
-    asm { cli };
-    unsigned int poweroff_now = internal_state.poweroff_now;
-    internal_state.poweroff_now = FALSE;
-    asm { sti };
-    return poweroff_now;
+    return evring.events_dropped;       // single word read, atomic
 }
 
 void
     Timer::reset_events(void)
 {
-    asm { cli };
-    internal_state.passed_1minute = FALSE;
-    internal_state.poweroff_now = FALSE;
-    internal_state.last_minute_tens = -1;
+    evring.tail = evring.head;  // drop pending, main loop owns the tail
+
+    CritSection critsec;
     internal_state.poweroff_delay_override = 0;
-    internal_state.poweroff_ticks = 0;
-    asm { sti };
+    internal_state.poweroff_deadline_sec = 0;
 }
 
-struct Timer::timer_events_t Timer::eval_events(
-    struct time_digits_t const & const time_digits)
+void Timer::post_event(event_t event)   // interrupt handlers only
 {
-    struct Timer::timer_events_t timer_events =
-        { FALSE, FALSE, FALSE };
-
-    asm { cli };
-    if (internal_state.last_minute_tens == -1)
+    byte_t head = evring.head;
+    byte_t used = (head - evring.tail) & (TIMER_EVRING_SIZE - 1);
+    byte_t vacant = TIMER_EVRING_SIZE - 1 - used;
+
+    // ticks may coalesce, keep room for the events that may not
+    if (event == EVT_TICK ?
+        vacant <= TIMER_EVRING_RESERVED :
+        vacant == 0)
     {
-        goto no_last_minute_tens;
-    }
-    if (internal_state.last_minute_tens != time_digits.digit.minute_tens)
-    {
-#ifdef NTVDM
-        cout
-            << "Timer: passed_10minutes: " << time_digits << "\n";
-#endif
-        timer_events.passed_10minutes = TRUE;
-    }
-    if (internal_state.last_minute_tens < 3) // first half of an hour
-    {
-        if (time_digits.digit.minute_tens >= 3)
-        {
-#ifdef NTVDM
-            cout
-                << "Timer: passed_halfanhour: " << time_digits << "\n";
-#endif
-            timer_events.passed_halfanhour = TRUE;
-        }
-    }
-    else // second half of an hour
-    {
-        if (time_digits.digit.minute_tens < 3)
-        {
-#ifdef NTVDM
-            cout
-                << "Timer: passed_halfanhour: " << time_digits << "\n"
-                << "Timer: passed_fullhour: " << time_digits << "\n";
-#endif
-            timer_events.passed_halfanhour = TRUE;
-            timer_events.passed_fullhour = TRUE;
-        }
+        evring.events_dropped++;
+        return;
     }
 
-no_last_minute_tens:
-    internal_state.last_minute_tens =
-        time_digits.digit.minute_tens;
-    asm { sti };
+    evring.events[head] = event;
+    evring.head = (head + 1) & (TIMER_EVRING_SIZE - 1); // publish
+}
 
-    return timer_events;
+void Timer::tick(void)  // Int 1Ch handler only
+{
+    /*
+     * The ticks' phase is not the RTC's, the first tick after a sync
+     * (or a clockspeed change) may follow it at once and counts for no
+     * time. Each further one adds a whole period, so now_sec stays at
+     * or behind the real time, by up to a period, and a deadline it
+     * reaches has passed.
+     */
+    if (internal_state.ticks_since_sync < 2)
+        internal_state.ticks_since_sync++;  // saturates, only the first matters
+    if (internal_state.ticks_since_sync > 1)
+        internal_state.now_sec += internal_state.tick_period_sec;
+
+    if (internal_state.poweroff_deadline_sec != 0 &&
+        internal_state.now_sec >= internal_state.poweroff_deadline_sec)
+    {
+        internal_state.poweroff_deadline_sec = 0;
+        internal_state.poweroff_delay_override = 0;
+        post_event(EVT_POWEROFF);
+    }
 }
 
 void interrupt Timer::int1c_handler(__CPPARGS)  // Timer tick int. handler;
@@ -297,21 +311,16 @@ void interrupt Timer::int1c_handler(__CPPARGS)  // Timer tick int. handler;
                                                 // int. controller, hence it cannot
                                                 // be interrupted by another interrupt
 {
-    if (internal_state.poweroff_ticks > 0)
-    {
-        if (--internal_state.poweroff_ticks == 0)
-        {
-            internal_state.last_minute_tens = -1;
-            internal_state.poweroff_delay_override = 0;
-            internal_state.poweroff_now = TRUE;
-        }
-    }
+    post_event(EVT_TICK);
+    MonoClock::tick(internal_state.tick_period_sec);
+    ToneSeq::step();
+    tick();
 }
 
 void interrupt Timer::int4a_handler(__CPPARGS)  // RTC alarm int. handler;
-                                                // on wake-up & passed_1minute event
+                                                // on wake-up & next scheduled event due
 {
-    internal_state.passed_1minute = TRUE;
+    post_event(EVT_RTC_ALARM);
 }
 
 #ifdef NTVDM
@@ -22,6 +22,9 @@
     #define __CPPARGS
 #endif
 
+#define TIMER_EVRING_SIZE 16    // power of 2
+#define TIMER_EVRING_RESERVED 2 // slots kept free from tick events
+
 class INIFile;
 
 class Timer
@@ -65,51 +68,88 @@ public:
     };
 
     struct time_digits_t {
+        struct time_digit_t {
+            byte_t hour_tens;
+            byte_t hour_ones;
+            byte_t minute_tens;
+            byte_t minute_ones;
+        };
         union {
-            struct time_digit_t {
-                byte_t hour_tens;
-                byte_t hour_ones;
-                byte_t minute_tens;
-                byte_t minute_ones;
-            } digit;
+            time_digit_t digit;
             byte_t digit_arr[4];
         };
         time_digits_t();
+        unsigned int
+            get_abs_min() const;
 #ifdef NTVDM
         friend ostream & const
             operator << (ostream & const, time_digits_t const & const);
 #endif
     };
 
-    struct timer_events_t {
-        unsigned int passed_10minutes : 1;
-        unsigned int passed_halfanhour : 1;
-        unsigned int passed_fullhour : 1;
+    typedef void                        // days since 1980-01-01,
+        (* clock_source_fp_t)(          // minutes after midnight
+            unsigned int & const,
+            unsigned int & const);
+
+    enum event_t {
+        EVT_TICK,       // Int 1Ch, clock tick
+        EVT_RTC_ALARM,  // Int 4Ah, RTC alarm
+        EVT_POWEROFF,   // power-off delay elapsed
     };
 
 private:
     struct internal_state_t
     {
-        unsigned int passed_1minute : 1;
-        unsigned int poweroff_now : 1;
-        char last_minute_tens;
         unsigned int poweroff_delay_override;
-        unsigned long poweroff_ticks;
+        unsigned int tick_period_sec;
+        unsigned long now_sec;  // since epoch, advanced by tick handler,
+                                // re-synced from RTC by the main loop;
+                                // never ahead of the RTC, never backwards
+        unsigned int ticks_since_sync;  // saturates at 2
+        unsigned long poweroff_deadline_sec; // 0 if none
+    };
+
+    /*
+     * Single-producer/single-consumer ring of events.
+     *
+     * Producer are the interrupt handlers, both run with interrupts
+     * masked and so never preempt each other. Consumer is the main
+     * loop. Each side only writes its own index, no locking needed.
+     */
+    struct evring_t
+    {
+        byte_t events[TIMER_EVRING_SIZE];
+        byte_t head;            // written by the interrupt handlers only
+        byte_t tail;            // written by the main loop only
+        unsigned int events_dropped;  // not posted, ring full; ticks
+                                      // dropped first, see post_event()
     };
 
     static struct internal_state_t internal_state;
+    static struct evring_t volatile evring;
 
-    PFBios::clockspeed_t const & const
-        clockspeed;
+    unsigned long
+        synced_sec;
+    long
+        last_day_sec;
+    clock_source_fp_t
+        clock_source;
 
+    static void
+        dos_clock_source(
+            unsigned int & const,
+            unsigned int & const);
     void
         set_poweroff_delay_minutes(unsigned int);
-    void
-        set_poweroff_ticks(unsigned long);
     void interrupt
         (* int1c_handler_orig_fp)(__CPPARGS);
     void interrupt
         (* int4a_handler_orig_fp)(__CPPARGS);
+    static void
+        post_event(event_t);
+    static void
+        tick(void);
     static void
         interrupt int1c_handler(__CPPARGS);
     static void
@@ -125,17 +165,31 @@ private:
 
 public:
     Timer(
-        PFBios::clockspeed_t & const);
+        PFBios::clockspeed_t const);
     void
         register_handlers(void);
     void
         deregister_handlers(void);
-    struct Timer::timer_events_t
-        eval_events(struct time_digits_t const & const);
+    void
+        set_clock_source(clock_source_fp_t const);
+    void
+        read_clock(
+            unsigned int & const,
+            unsigned int & const);
+    void
+        set_clockspeed(PFBios::clockspeed_t const);
+    void
+        sync_clock(unsigned long);
+    unsigned long
+        get_now_sec(void);
+    unsigned int
+        get_poweroff_alarm_min(unsigned long & const);
     unsigned int
-        receive_passed1minute_event(void);
+        receive_event(event_t & const);
     unsigned int
-        receive_poweroff_event(void);
+        has_events(void) const;
+    unsigned int
+        get_events_dropped(void) const;
     void
         reset_events(void);
     void
@@ -153,6 +207,8 @@ public:
             unsigned int);
     void
         test_schedule_next_poweroff(void);
+    void
+        test_poweroff_deadline(void);
 #endif
 };
 
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2022-2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "tlmlog.h"
+
+#include <dos.h>
+#include <io.h>
+#include <stdio.h>
+#include <fcntl.h>
+
+char const * const
+    TlmLog::log_filename = "PFWALLCL.TLM";
+
+TlmLog::TlmLog() :
+    ring_head(0),
+    ring_len(0)
+{
+    wake.source = 0;
+    wake.work = 0;
+    wake.events = 0;
+    wake.timestamp_sec = 0;
+    wake.awake_pit = 0;
+}
+
+void TlmLog::append(record_t const & const record)
+{
+    unsigned int tail = (ring_head + ring_len) % TLM_RING_RECORDS;
+
+    ring[tail] = record;
+
+    if (ring_len < TLM_RING_RECORDS)
+        ring_len++;
+    else // full, flush must have failed, overwrite the oldest
+        ring_head = (ring_head + 1) % TLM_RING_RECORDS;
+
+    if (ring_len >= TLM_FLUSH_THRESHOLD)
+        flush();
+}
+
+void TlmLog::begin_run(unsigned long now_sec)
+{
+    struct dosdate_t dosdate;
+    _dos_getdate(&dosdate);
+
+    record_t run;
+    run.source = SRC_RUN;
+    run.work = 0;
+    run.events = 0;
+    run.timestamp_sec = now_sec;
+    run.awake_pit =     // DOS packed date
+        (unsigned long)(dosdate.year - 1980) << 9 |
+        dosdate.month << 5 |
+        dosdate.day;
+
+    append(run);
+    begin_wake(now_sec);
+}
+
+void TlmLog::begin_wake(unsigned long now_sec)
+{
+    wake.source = 0;
+    wake.work = 0;
+    wake.events = 0;
+    wake.timestamp_sec = now_sec;
+    stopwatch.start();
+}
+
+void TlmLog::note_source(source_t const source)
+{
+    wake.source |= source;
+}
+
+void TlmLog::note_work(work_t const work)
+{
+    wake.work |= work;
+}
+
+void TlmLog::note_events(unsigned int events)
+{
+    wake.events += events;
+}
+
+void TlmLog::sample(void)
+{
+    stopwatch.sample();
+}
+
+void TlmLog::end_wake(void)
+{
+    stopwatch.sample();
+    wake.awake_pit = stopwatch.get_elapsed();
+    append(wake);
+}
+
+int TlmLog::write_records(
+    int fd, unsigned int first, unsigned int count)
+{
+    unsigned int nbytes = count * sizeof(record_t);
+    unsigned int written;
+
+    if (_dos_write(fd, &ring[first], nbytes, &written) != 0 ||
+        written != nbytes)
+        return RET_FAILURE;
+
+    return RET_SUCCESS;
+}
+
+int TlmLog::flush(void)
+{
+    int fd;
+    int res = RET_SUCCESS;
+
+    if (ring_len == 0)
+        return RET_SUCCESS;
+
+    if (_dos_open(log_filename, O_WRONLY, &fd) == 0)
+    {
+        if (lseek(fd, 0l, SEEK_END) == -1l)
+            res = RET_FAILURE;
+    }
+    else
+    {
+        if (_dos_creat(log_filename, _A_NORMAL, &fd) != 0)
+            return RET_FAILURE;
+
+        file_header_t header;
+        header.magic = TLM_FILE_MAGIC;
+        header.version = TLM_FILE_VERSION;
+        header.record_size = sizeof(record_t);
+
+        unsigned int written;
+        if (_dos_write(fd, &header, sizeof header, &written) != 0 ||
+            written != sizeof header)
+            res = RET_FAILURE;
+    }
+
+    // at most two writes, the ring may wrap around
+    unsigned int first_count =
+        MIN(ring_len, TLM_RING_RECORDS - ring_head);
+
+    if (res == RET_SUCCESS)
+        res = write_records(fd, ring_head, first_count);
+    if (res == RET_SUCCESS && ring_len > first_count)
+        res = write_records(fd, 0, ring_len - first_count);
+
+    _dos_close(fd);
+
+    if (res == RET_SUCCESS)
+    {
+        ring_head = 0;
+        ring_len = 0;
+    }
+
+    return res;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2022-2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Wakeup telemetry log
+ *
+ * One fixed-size record per wake (hlt to hlt), kept in a RAM ring
+ * and appended to a binary log file only once the ring fills up.
+ * File layout is read by tools/tlmsum.
+ */
+
+#ifndef _TLMLOG_H
+#define _TLMLOG_H 1
+
+#include "pit.h"
+#include "common.h"
+
+#define TLM_RING_RECORDS 64
+#define TLM_FLUSH_THRESHOLD 48
+
+#define TLM_FILE_MAGIC 0x4C54    // 'TL'
+#define TLM_FILE_VERSION 1
+
+class TlmLog
+{
+public:
+    enum source_t {             // what woke us up, or'ed
+        SRC_TICK = 0x01,
+        SRC_RTC_ALARM = 0x02,
+        SRC_KEY = 0x04,
+        SRC_RUN = 0x80,         // run start marker, awake_pit holds DOS date
+        };
+
+    enum work_t {               // what was done while awake, or'ed
+        WORK_EVENTS = 0x01,
+        WORK_DGCLOCK = 0x02,
+        WORK_ANIM = 0x04,
+        WORK_VRAM_COPY = 0x08,
+        WORK_MSGBOX = 0x10,
+        WORK_POWEROFF = 0x20,
+        WORK_TONE = 0x40,       // notes playing
+        };
+
+    struct file_header_t {
+        word_t magic;
+        byte_t version;
+        byte_t record_size;
+    };
+
+    struct record_t {
+        byte_t source;
+        byte_t work;
+        word_t events;              // scheduler events dispatched
+        unsigned long timestamp_sec; // Timer clock at wake
+        unsigned long awake_pit;    // PIT counts awake
+    };
+
+private:
+    static char const * const
+        log_filename;
+
+    record_t
+        ring[TLM_RING_RECORDS];
+    unsigned int
+        ring_head,
+        ring_len;
+
+    record_t
+        wake;
+    PitStopwatch
+        stopwatch;
+
+    void
+        append(record_t const & const);
+    int
+        write_records(int, unsigned int, unsigned int);
+
+public:
+    TlmLog();
+
+    void
+        begin_run(unsigned long);
+    void
+        begin_wake(unsigned long);
+    void
+        note_source(source_t const);
+    void
+        note_work(work_t const);
+    void
+        note_events(unsigned int);
+    void
+        sample(void);
+    void
+        end_wake(void);
+    int
+        flush(void);
+};
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "toneseq.h"
+#include "critsec.h"
+
+#include <stdlib.h>
+
+#ifdef NTVDM
+#include <dos.h>
+#endif
+
+ToneSeq::note_t volatile
+    ToneSeq::queue[TONESEQ_QUEUE_SIZE];
+byte_t volatile
+    ToneSeq::head = 0;
+byte_t volatile
+    ToneSeq::tail = 0;
+byte_t volatile
+    ToneSeq::ticks_left = 0;
+
+int ToneSeq::queue_note(byte_t tone, byte_t ticks)
+{
+#ifndef NTVDM
+    byte_t next = (head + 1) & (TONESEQ_QUEUE_SIZE - 1);
+
+    if (next == tail)
+        return RET_FAILURE;
+
+    queue[head].tone = tone;
+    queue[head].ticks = MAX(ticks, 1);
+    head = next;                // publish
+#else // #ifdef NTVDM
+    // no tick handler here, play it right away
+    if (tone != TONESEQ_REST)
+        PFBios::tone_on(tone);
+    delay(100 * ticks);
+    PFBios::tone_off();
+#endif
+    return RET_SUCCESS;
+}
+
+int ToneSeq::queue_melody(ToneSeq::melody_t const & const melody)
+{
+    for (unsigned int i = 0; i < melody.nnotes; i++)
+        if (queue_note(melody.notes[i].tone, melody.notes[i].ticks)
+                == RET_FAILURE)
+            return RET_FAILURE;
+
+    return RET_SUCCESS;
+}
+
+int ToneSeq::queue_rndtone(void)
+{
+    // upper half of the tone range
+    return queue_note(
+        rand() % PFBIOS_NUM_TONES / 2 + PFBIOS_NUM_TONES / 2, 1);
+}
+
+unsigned int ToneSeq::is_playing(void)
+{
+    return ticks_left != 0 || head != tail;
+}
+
+void ToneSeq::stop(void)
+{
+    CritSection critsec;
+
+    tail = head;
+    ticks_left = 0;
+    PFBios::tone_off();
+}
+
+void ToneSeq::step(void)
+{
+    if (ticks_left == 0 && tail == head)
+        return;                 // idle
+
+    if (ticks_left != 0 && --ticks_left != 0)
+        return;                 // note goes on
+
+    if (tail == head)
+    {
+        PFBios::tone_off();     // last note done
+        return;
+    }
+
+    note_t note = ((note_t *)queue)[tail];  // casting away volatile
+    tail = (tail + 1) & (TONESEQ_QUEUE_SIZE - 1);
+
+    if (note.tone == TONESEQ_REST)
+        PFBios::tone_off();
+    else
+        PFBios::tone_on(note.tone);
+
+    ticks_left = note.ticks;
+}
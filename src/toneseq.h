@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Tone sequencer
+ *
+ * The main loop queues notes, the tick interrupt handler plays them,
+ * one step per tick: the tone generator is switched with a port write
+ * and nothing waits for a note to end.
+ *
+ * Int 1Ch is the only periodic interrupt, so notes come in whole ticks
+ * of the fast clockspeed, 1 s: the 200 ms beeps of Int 61h Fn 16h grow
+ * to a second, which is the price of not blocking. `pfwallcl bench`
+ * times step() idle and playing (TONE_IDLE, TONE_PLAY), tools/cyc86
+ * counts its cycles per call.
+ */
+
+#ifndef _TONESEQ_H
+#define _TONESEQ_H 1
+
+#include "pfbios.h"
+#include "common.h"
+
+#define TONESEQ_QUEUE_SIZE 16   // power of 2
+#define TONESEQ_MELODY_MAX 8
+#define TONESEQ_REST 0xff
+
+class ToneSeq
+{
+public:
+    struct note_t {
+        byte_t tone;            // PFBios tone, or TONESEQ_REST
+        byte_t ticks;           // 1 s each at the fast clockspeed
+    };
+
+    struct melody_t {
+        byte_t nnotes;
+        note_t notes[TONESEQ_MELODY_MAX];
+    };
+
+private:
+    static note_t volatile
+        queue[TONESEQ_QUEUE_SIZE];
+    static byte_t volatile
+        head;                   // main loop only
+    static byte_t volatile
+        tail;                   // tick handler only
+    static byte_t volatile
+        ticks_left;             // of the note being played
+
+public:
+    static int
+        queue_note(byte_t, byte_t);
+    static int
+        queue_melody(melody_t const & const);
+    static int
+        queue_rndtone(void);
+    static unsigned int
+        is_playing(void);
+    static void
+        stop(void);
+    static void
+        step(void);             // tick interrupt handler only
+};
+
+#endif
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "txtline.h"
+
+#include <dos.h>
+#include <stdlib.h>
+#include <string.h>
+
+char * TxtLine::put_str(
+    char * s, char const * const str, unsigned int width)
+{
+    unsigned int len = strlen(str);
+
+    strcpy(s, str);
+    s += len;
+    while (len++ < width)
+        *s++ = ' ';             // left aligned
+    *s++ = ' ';
+
+    return s;
+}
+
+char * TxtLine::put_hex(
+    char * s, unsigned int value,
+    unsigned int digits, unsigned int width)
+{
+    static char const hex[] = "0123456789ABCDEF";
+    unsigned int i;
+
+    for (i = 0; i < digits; i++)
+        s[i] = hex[(value >> ((digits - 1 - i) * 4)) & 0x0f];
+    for ( ; i < width; i++)
+        s[i] = ' ';             // left aligned
+    s[width] = ' ';
+
+    return s + width + 1;
+}
+
+char * TxtLine::put_dec(
+    char * s, unsigned long value, unsigned int width)
+{
+    char num[12];
+    unsigned int len = strlen(ultoa(value, num, 10));
+
+    while (width-- > len)
+        *s++ = ' ';             // right aligned
+    strcpy(s, num);
+    s += len;
+    *s++ = ' ';
+
+    return s;
+}
+
+char * TxtLine::put_fract(
+    char * s, unsigned long dividend, unsigned long divisor,
+    unsigned int width)
+{
+    // quotient with two decimals, for divisors up to 40 million
+    unsigned long hundredths =
+        dividend % divisor * 100 / divisor;
+
+    s = put_dec(s, dividend / divisor, width - 3);
+    s[-1] = '.';
+    *s++ = '0' + (char)(hundredths / 10);
+    *s++ = '0' + (char)(hundredths % 10);
+    *s++ = ' ';
+
+    return s;
+}
+
+int TxtLine::write(int fd, char * const line, char * end)
+{
+    unsigned int written;
+
+    if (end > line && end[-1] == ' ')
+        end--;                  // the put_*() separator
+    *end++ = '\r';
+    *end++ = '\n';
+
+    return _dos_write(fd, line, end - line, &written) != 0
+        || written != (unsigned int)(end - line) ?
+            RET_FAILURE : RET_SUCCESS;
+}
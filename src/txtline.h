@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Text line formatting for the trace, profile and bench dumps
+ *
+ * The put_*() append a field and a separating space, return the end;
+ * write() ends the line with CR LF and writes it to a DOS handle.
+ */
+
+#ifndef _TXTLINE_H
+#define _TXTLINE_H 1
+
+#include "common.h"
+
+#define TXTLINE_STDOUT 1        // DOS handle
+
+class TxtLine
+{
+public:
+    static char *
+        put_str(char *, char const * const, unsigned int);
+    static char *
+        put_hex(char *, unsigned int, unsigned int, unsigned int);
+    static char *
+        put_dec(char *, unsigned long, unsigned int);
+    static char *
+        put_fract(char *, unsigned long, unsigned long, unsigned int);
+    static int
+        write(int, char * const, char *);
+};
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "wirefrm.h"
+
+#include <stdlib.h>
+
+#define STEP_X_DIV_MIN 40       // step angles pi / 40 to pi / 71 a frame
+#define STEP_Y_DIV_MIN 20       // and pi / 20 to pi / 51
+#define STEP_DIV_RANGE 32
+#define TILT_STEPS 8            // pi / 5 about x, pi / 7 about y, roughly
+
+FixedpMat3
+    Wireframe::orient,
+    Wireframe::step_rot;
+
+unsigned int
+    Wireframe::frame = 0;
+
+unsigned int
+    Wireframe::recip_arr[WIRE_RECIP_NUM];
+
+int
+    Wireframe::drawn_arr[WIRE_VERTICES][2];
+
+void Wireframe::recip_prep(void)
+{
+    Fixedp const focal_fixedp ((Fixedp::fixedp_t)WIRE_FOCAL);
+    Fixedp const distance_fixedp ((Fixedp::fixedp_t)WIRE_DISTANCE);
+
+    for (int i = 0; i < WIRE_RECIP_NUM; i++)
+    {
+        Fixedp const depth_fixedp (
+            (Fixedp::fixedp_t)(i - WIRE_RECIP_NUM / 2) *
+                (1l << (SCALE - WIRE_RECIP_SHIFT)),
+            TRUE);
+
+        recip_arr[i] = (unsigned int)
+            ((focal_fixedp / (distance_fixedp + depth_fixedp)).rawvalue >>
+                (SCALE - 8));
+    }
+}
+
+void Wireframe::start(void)
+{
+    Fixedp const pi_fixedp (FIXEDP_PI_RAW, TRUE);
+
+    if (recip_arr[0] == 0)      // once, they don't change
+        recip_prep();
+
+    frame = 0;
+
+    // tilted to begin with, corners towards the viewer:
+    // a small rotation repeated, no large angles needed
+    step_rot.set_rotation_xy(
+        Fixedp::quasisin_fixedp(pi_fixedp / (long)(TILT_STEPS * 5)),
+        Fixedp::quasisin_fixedp(pi_fixedp / (long)(TILT_STEPS * 7)));
+    orient.set_identity();
+    for (unsigned int i = 0; i < TILT_STEPS; i++)
+        orient = step_rot * orient;
+
+    // small angles a frame, turned by from now on
+    Fixedp const sin_x_fixedp = Fixedp::quasisin_fixedp(
+        pi_fixedp / (long)(STEP_X_DIV_MIN + rand() % STEP_DIV_RANGE));
+    Fixedp sin_y_fixedp = Fixedp::quasisin_fixedp(
+        pi_fixedp / (long)(STEP_Y_DIV_MIN + rand() % STEP_DIV_RANGE));
+
+    if (rand() % 2)             // either way round
+        sin_y_fixedp = -sin_y_fixedp;
+
+    step_rot.set_rotation_xy(sin_x_fixedp, sin_y_fixedp);
+}
+
+int Wireframe::scaled(Fixedp const coord, unsigned int recip)
+{
+    // 8.8 times 8.8, rounded; a single 16 by 16 bit multiply, signed
+    // as the reciprocals stay below 128
+    int const coord_88 = (int)(coord.rawvalue >> (SCALE - 8));
+    long product;
+
+#ifndef HOSTSIM
+    asm {
+        push ax
+        push dx
+        mov  ax,coord_88
+        mov  dx,recip
+        imul dx
+        mov  word ptr [ product ],ax
+        mov  word ptr [ product + 2 ],dx
+        pop  dx
+        pop  ax
+    }
+#else // #ifdef HOSTSIM
+    product = (long)coord_88 * (int)recip;
+#endif
+
+    return (int)((product + 0x8000l) >> 16);
+}
+
+void Wireframe::project(int x_center)
+{
+    int const y_center = GRAPH_Y_OFFS + ANIMW_HEIGHT / 2;
+    FixedpVec3 const col_z = orient.column(2);
+    FixedpVec3 xy_arr[4];       // indexed by bits 0, 1 of the vertex
+
+    xy_arr[3] = orient.column(0) + orient.column(1);
+    xy_arr[1] = orient.column(0) - orient.column(1);
+    xy_arr[0] = -xy_arr[3];
+    xy_arr[2] = -xy_arr[1];
+
+    for (unsigned int v = 0; v < WIRE_VERTICES; v++)
+    {
+        FixedpVec3 const p =
+            v & 4 ? xy_arr[v & 3] + col_z : xy_arr[v & 3] - col_z;
+        unsigned int const recip =
+            recip_arr[
+                (int)(p.z.rawvalue >> (SCALE - WIRE_RECIP_SHIFT)) +
+                WIRE_RECIP_NUM / 2];
+
+        drawn_arr[v][0] = x_center + scaled(p.x, recip);
+        drawn_arr[v][1] = y_center - scaled(p.y, recip);
+    }
+}
+
+void Wireframe::draw_edges(void)
+{
+    // an edge for every two vertices a bit apart
+    for (unsigned int v = 0; v < WIRE_VERTICES; v++)
+    {
+        for (unsigned int bit = 1; bit < WIRE_VERTICES; bit <<= 1)
+        {
+            if (v & bit)
+                continue;
+
+            Graph::line(
+                drawn_arr[v][0], drawn_arr[v][1],
+                drawn_arr[v | bit][0], drawn_arr[v | bit][1],
+                Graph::PIX_XOR);
+        }
+    }
+}
+
+int Wireframe::step_finished(int x_offs)
+{
+    if (frame)
+        draw_edges();           // the previous frame off
+
+    orient = step_rot * orient;
+    project(x_offs + ANIMW_WIDTH / 2);
+    draw_edges();
+
+    return ++frame >= WIRE_FRAMES;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Rotating wireframe cube in the animation window
+ *
+ * The orientation is a fixed point matrix, turned a frame at a time by
+ * a step rotation computed at the start; a cube's vertices are signed
+ * sums of its columns, so no multiply per vertex. The perspective
+ * divide is a look-up in a table of reciprocals by depth. The edges
+ * are drawn XOR, drawn once more they erase the previous frame, the
+ * window is never cleared.
+ */
+
+#ifndef _WIREFRM_H
+#define _WIREFRM_H 1
+
+#include "graph.h"
+#include "fixedp3.h"
+
+#define WIRE_FRAMES 192
+#define WIRE_VERTICES 8         // bits 0, 1, 2 of the index: x, y, z positive
+
+// units of half the edge: a vertex sqrt(3) off the center shows
+// sqrt(3 - z^2) / (4 + z) * 34 <= 16.4 pixels off it, the window is 36 high
+#define WIRE_DISTANCE 4         // viewer to the center of the cube
+#define WIRE_FOCAL 34           // pixels per unit at distance 1
+
+#define WIRE_RECIP_SHIFT 4      // reciprocals per unit of depth, log2
+#define WIRE_RECIP_NUM ((4 << WIRE_RECIP_SHIFT) + 1)    // depth -2 to 2
+
+class Wireframe
+{
+    static FixedpMat3
+        orient,
+        step_rot;
+    static unsigned int
+        frame;
+    static unsigned int
+        recip_arr[WIRE_RECIP_NUM];  // focal / (distance + depth), 8.8
+    static int
+        drawn_arr[WIRE_VERTICES][2];    // screen x, y
+
+    static void
+        recip_prep(void);
+    static int
+        scaled(Fixedp const, unsigned int);
+    static void
+        project(int);
+    static void
+        draw_edges(void);
+
+public:
+    static void
+        start(void);
+    static int
+        step_finished(int);
+};
+
+#endif
@@ -0,0 +1,2024 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Cycle counting 8086 emulator for the pfwallcl hot paths.
+ *
+ * Loads the linked PFWALLCL.EXE and its TLINK map (publics), runs it with
+ * the "bench" argument (src/bench.cpp) on a minimal DOS / BIOS, and counts
+ * the cycles of every call of the routines below: the bench workload
+ * calls them with real arguments, their entry points come from the map.
+ *
+ * The counts are the 8086 execution times of the Intel data sheet, plus
+ * 4 cycles for every word the 8-bit bus of the 80C88 transfers; the
+ * prefetch queue and wait states are not modelled. Multiply and divide
+ * take the middle of their data dependent range. DOS and BIOS calls cost
+ * the INT and the IRET only. The counts are exact in the sense that
+ * a build always gives the same ones, which is what a regression check
+ * needs; on the Portfolio itself, time the same workload with
+ * `pfwallcl bench`.
+ *
+ * Int 1Ch comes every 1 or 128 s of emulated time, as set with Int 61h
+ * Fn 1Eh, so MonoClock and the bench results file read emulated time;
+ * the cycles of its handler are left out, the counts don't depend on
+ * where the ticks fall. PIT channel 0 counts with the cycles (CPU_HZ),
+ * I/O ports are stubbed otherwise.
+ * The program's console output goes to stderr, stdout has the results
+ * only, to be kept as the baseline of a later run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#define CPU_HZ 4915200.0        // 80C88 of the Portfolio
+#define PIT_HZ 1193182.0
+
+#define MEM_SIZE 0x100000
+#define ENV_SEG 0x0f00
+#define PSP_SEG 0x1000
+#define MEM_TOP_SEG 0xa000
+#define STUB_SEG 0xf000         // Int n vectors point to F000:n
+#define BIOS_VER_SEG 0xe000
+#define BIOS_VER_OFFS 0x0100
+#define VRAM_FIRST 0xb0000UL    // B000h..BFFFh mirror the 8 KB video RAM
+#define VRAM_MIRROR 0x2000UL
+#define TICK_SEC_NORMAL 128
+#define TICK_SEC_FAST 1
+
+#define DOS_HANDLES 20
+#define FRAMES_MAX 64
+#define ROUTINES_MAX 16
+#define DEFAULT_MAX_INSNS 4000000000ULL
+
+#define F_CF 0x0001
+#define F_PF 0x0004
+#define F_AF 0x0010
+#define F_ZF 0x0040
+#define F_SF 0x0080
+#define F_TF 0x0100
+#define F_IF 0x0200
+#define F_DF 0x0400
+#define F_OF 0x0800
+
+enum
+{ AX, CX, DX, BX, SP, BP, SI, DI };
+enum
+{ ES, CS, SS, DS };
+
+struct ea_t
+{
+    int       mod, reg, rm;
+    uint16_t  seg, off;
+};
+
+struct routine_t
+{
+    char const *name;
+    char const *map_prefix;     // Borland C++ mangled name, up to the args
+    uint32_t  entry;            // linear, 0 if not in the map
+    unsigned long calls;
+    uint64_t  total, min, max;
+};
+
+struct frame_t
+{
+    int       routine;
+    uint16_t  ret_cs, ret_ip, sp;
+    uint64_t  start;
+};
+
+static struct routine_t routines[ROUTINES_MAX] = {
+    {"Fixedp::operator*", "@Fixedp@$bmul$", 0, 0, 0, 0, 0},
+    {"Fixedp::operator/", "@Fixedp@$bdiv$", 0, 0, 0, 0, 0},
+    {"Fixedp::quasisin_fixedp", "@Fixedp@quasisin_fixedp$", 0, 0, 0, 0, 0},
+    {"Graph::animate_finished", "@Graph@animate_finished$", 0, 0, 0, 0, 0},
+    {"Life::step_finished", "@Life@step_finished$", 0, 0, 0, 0, 0},
+    {"Wireframe::step_finished", "@Wireframe@step_finished$", 0, 0, 0, 0, 0},
+    {"Graph::vram_copy", "@Graph@vram_copy$", 0, 0, 0, 0, 0},
+    {"Dither::present", "@Dither@present$", 0, 0, 0, 0, 0},
+    {"DgClock::draw", "@DgClock@draw$", 0, 0, 0, 0, 0},
+    {"ToneSeq::step", "@ToneSeq@step$", 0, 0, 0, 0, 0},
+};
+static unsigned int nroutines = 10;
+
+static uint8_t mem[MEM_SIZE];
+static uint16_t r[8], s[4], ip, fl;
+static uint64_t cycles, insns;
+static int seg_ovr, rep;
+static uint16_t insn_cs, insn_ip;
+static uint64_t insn_cycles;
+static int running = 1, exit_code;
+
+static struct frame_t frames[FRAMES_MAX];
+static unsigned int nframes;
+
+static int dos_fds[DOS_HANDLES];
+static uint16_t pit_latch;
+static int pit_read_msb;
+
+static unsigned int clockspeed = 0;     // Int 61h Fn 1Eh, 0 normal, 1 fast
+static uint64_t next_tick_cycles = TICK_SEC_NORMAL * CPU_HZ;
+static int in_tick;
+static uint16_t tick_sp;
+static uint64_t tick_cycles;
+
+/*
+ * Memory
+ */
+
+static uint32_t
+lin( uint16_t seg, uint16_t off )
+{
+    uint32_t  a = ( ( ( uint32_t ) seg << 4 ) + off ) & ( MEM_SIZE - 1 );
+
+    if ( a - VRAM_FIRST < 0x10000 )
+        a = VRAM_FIRST + ( a & ( VRAM_MIRROR - 1 ) );
+    return a;
+}
+
+static uint8_t
+rd8( uint16_t seg, uint16_t off )
+{
+    return mem[lin( seg, off )];
+}
+
+static void
+wr8( uint16_t seg, uint16_t off, uint8_t v )
+{
+    mem[lin( seg, off )] = v;
+}
+
+static uint16_t
+rd16( uint16_t seg, uint16_t off )
+{
+    cycles += 4;                // 8-bit bus, second byte
+    return rd8( seg, off ) | rd8( seg, off + 1 ) << 8;
+}
+
+static void
+wr16( uint16_t seg, uint16_t off, uint16_t v )
+{
+    cycles += 4;
+    wr8( seg, off, v & 0xff );
+    wr8( seg, off + 1, v >> 8 );
+}
+
+static uint8_t
+fetch8( void )
+{
+    return rd8( s[CS], ip++ );
+}
+
+static uint16_t
+fetch16( void )
+{
+    uint16_t  v = rd8( s[CS], ip ) | rd8( s[CS], ip + 1 ) << 8;
+
+    ip += 2;
+    return v;
+}
+
+static void
+push( uint16_t v )
+{
+    r[SP] -= 2;
+    wr16( s[SS], r[SP], v );
+}
+
+static uint16_t
+pop( void )
+{
+    uint16_t  v = rd16( s[SS], r[SP] );
+
+    r[SP] += 2;
+    return v;
+}
+
+/*
+ * Registers, flags
+ */
+
+static uint8_t
+get_r8( int n )
+{
+    return n < 4 ? r[n] & 0xff : r[n - 4] >> 8;
+}
+
+static void
+set_r8( int n, uint8_t v )
+{
+    if ( n < 4 )
+        r[n] = ( r[n] & 0xff00 ) | v;
+    else
+        r[n - 4] = ( r[n - 4] & 0x00ff ) | v << 8;
+}
+
+static uint16_t
+get_reg( int n, int w )
+{
+    return w ? r[n] : get_r8( n );
+}
+
+static void
+set_reg( int n, int w, uint16_t v )
+{
+    if ( w )
+        r[n] = v;
+    else
+        set_r8( n, v );
+}
+
+static void
+set_flag( uint16_t f, int on )
+{
+    if ( on )
+        fl |= f;
+    else
+        fl &= ~f;
+}
+
+static void
+set_szp( uint16_t v, int w )
+{
+    uint8_t   p = v & 0xff;
+
+    p ^= p >> 4;
+    p ^= p >> 2;
+    p ^= p >> 1;
+    set_flag( F_PF, !( p & 1 ) );
+    set_flag( F_ZF, ( w ? v : v & 0xff ) == 0 );
+    set_flag( F_SF, v & ( w ? 0x8000 : 0x80 ) );
+}
+
+static int
+cond( int n )
+{
+    int       c;
+
+    switch ( n >> 1 )
+    {
+    case 0:
+        c = fl & F_OF;
+        break;
+    case 1:
+        c = fl & F_CF;
+        break;
+    case 2:
+        c = fl & F_ZF;
+        break;
+    case 3:
+        c = fl & ( F_CF | F_ZF );
+        break;
+    case 4:
+        c = fl & F_SF;
+        break;
+    case 5:
+        c = fl & F_PF;
+        break;
+    case 6:
+        c = !( fl & F_SF ) != !( fl & F_OF );
+        break;
+    default:
+        c = ( fl & F_ZF ) || !( fl & F_SF ) != !( fl & F_OF );
+        break;
+    }
+    return ( n & 1 ) ? !c : !!c;
+}
+
+// ADD OR ADC SBB AND SUB XOR CMP
+static uint16_t
+alu( int op, uint16_t a, uint16_t b, int w )
+{
+    uint32_t  mask = w ? 0xffff : 0xff;
+    uint32_t  sign = w ? 0x8000 : 0x80;
+    uint32_t  res, cin;
+
+    switch ( op )
+    {
+    case 0:
+    case 2:
+        cin = op == 2 && ( fl & F_CF );
+        res = ( uint32_t ) a + b + cin;
+        set_flag( F_CF, res > mask );
+        set_flag( F_OF, ( a ^ res ) & ( b ^ res ) & sign );
+        set_flag( F_AF, ( a ^ b ^ res ) & 0x10 );
+        break;
+    case 3:
+    case 5:
+    case 7:
+        cin = op == 3 && ( fl & F_CF );
+        res = ( uint32_t ) a - b - cin;
+        set_flag( F_CF, ( uint32_t ) a < ( uint32_t ) b + cin );
+        set_flag( F_OF, ( a ^ b ) & ( a ^ res ) & sign );
+        set_flag( F_AF, ( a ^ b ^ res ) & 0x10 );
+        break;
+    case 1:
+        res = a | b;
+        fl &= ~( F_CF | F_OF | F_AF );
+        break;
+    case 4:
+        res = a & b;
+        fl &= ~( F_CF | F_OF | F_AF );
+        break;
+    default:
+        res = a ^ b;
+        fl &= ~( F_CF | F_OF | F_AF );
+        break;
+    }
+    res &= mask;
+    set_szp( res, w );
+    return res;
+}
+
+static uint16_t
+inc_dec( uint16_t a, int dec, int w )
+{
+    uint16_t  cf = fl & F_CF;
+    uint16_t  res = alu( dec ? 5 : 0, a, 1, w );
+
+    fl = ( fl & ~F_CF ) | cf;
+    return res;
+}
+
+/*
+ * Effective address
+ */
+
+static void
+decode_ea( struct ea_t *e )
+{
+    uint8_t   b = fetch8(  );
+    int       seg = DS, cyc;
+
+    e->mod = b >> 6;
+    e->reg = b >> 3 & 7;
+    e->rm = b & 7;
+    if ( e->mod == 3 )
+        return;
+
+    switch ( e->rm )
+    {
+    case 0:
+        e->off = r[BX] + r[SI];
+        cyc = 7;
+        break;
+    case 1:
+        e->off = r[BX] + r[DI];
+        cyc = 8;
+        break;
+    case 2:
+        e->off = r[BP] + r[SI];
+        cyc = 8;
+        seg = SS;
+        break;
+    case 3:
+        e->off = r[BP] + r[DI];
+        cyc = 7;
+        seg = SS;
+        break;
+    case 4:
+        e->off = r[SI];
+        cyc = 5;
+        break;
+    case 5:
+        e->off = r[DI];
+        cyc = 5;
+        break;
+    case 6:
+        if ( e->mod == 0 )
+        {
+            e->off = fetch16(  );
+            cyc = 6;
+        }
+        else
+        {
+            e->off = r[BP];
+            cyc = 5;
+            seg = SS;
+        }
+        break;
+    default:
+        e->off = r[BX];
+        cyc = 5;
+        break;
+    }
+    if ( e->mod == 1 )
+    {
+        e->off += ( int8_t ) fetch8(  );
+        cyc += 4;
+    }
+    else if ( e->mod == 2 )
+    {
+        e->off += fetch16(  );
+        cyc += 4;
+    }
+    if ( seg_ovr >= 0 )
+    {
+        seg = seg_ovr;
+        cyc += 2;
+    }
+    e->seg = s[seg];
+    cycles += cyc;
+}
+
+static uint16_t
+get_rm( struct ea_t const *e, int w )
+{
+    if ( e->mod == 3 )
+        return get_reg( e->rm, w );
+    return w ? rd16( e->seg, e->off ) : rd8( e->seg, e->off );
+}
+
+static void
+set_rm( struct ea_t const *e, int w, uint16_t v )
+{
+    if ( e->mod == 3 )
+        set_reg( e->rm, w, v );
+    else if ( w )
+        wr16( e->seg, e->off, v );
+    else
+        wr8( e->seg, e->off, v );
+}
+
+// register operand or memory operand cycles, EA already counted
+static void
+cost( struct ea_t const *e, int reg_cyc, int mem_cyc )
+{
+    cycles += e->mod == 3 ? reg_cyc : mem_cyc;
+}
+
+/*
+ * Routine accounting
+ */
+
+static void
+on_call( uint16_t target_cs, uint16_t target_ip, uint16_t sp )
+{
+    uint32_t  target = lin( target_cs, target_ip );
+
+    for ( unsigned int i = 0; i < nroutines; i++ )
+    {
+        if ( routines[i].entry != target )
+            continue;
+        if ( nframes == FRAMES_MAX )
+            return;
+        frames[nframes].routine = i;
+        frames[nframes].ret_cs = s[CS];
+        frames[nframes].ret_ip = ip;
+        frames[nframes].sp = sp;
+        frames[nframes].start = insn_cycles;    // the call included
+        nframes++;
+        return;
+    }
+}
+
+static void
+on_return( void )
+{
+    while ( nframes > 0 )
+    {
+        struct frame_t *f = &frames[nframes - 1];
+
+        if ( s[CS] != f->ret_cs || ip != f->ret_ip ||
+             ( int16_t ) ( r[SP] - f->sp ) < 0 )
+            return;
+
+        struct routine_t *rt = &routines[f->routine];
+        uint64_t  n = cycles - f->start;
+
+        if ( rt->calls == 0 || n < rt->min )
+            rt->min = n;
+        if ( n > rt->max )
+            rt->max = n;
+        rt->total += n;
+        rt->calls++;
+        nframes--;
+    }
+}
+
+/*
+ * DOS, BIOS
+ */
+
+static void
+interrupt( uint8_t n )
+{
+    push( fl | 0xf002 );
+    push( s[CS] );
+    push( ip );
+    fl &= ~( F_IF | F_TF );
+    ip = rd16( 0, n * 4 );
+    s[CS] = rd16( 0, n * 4 + 2 );
+}
+
+static void
+iret( void )
+{
+    ip = pop(  );
+    s[CS] = pop(  );
+    fl = pop(  );
+}
+
+static uint64_t
+tick_period_cycles( void )
+{
+    return ( clockspeed ? TICK_SEC_FAST : TICK_SEC_NORMAL ) * CPU_HZ;
+}
+
+// Int 1Ch as from the BIOS timer interrupt, between two instructions
+static void
+tick( void )
+{
+    next_tick_cycles += tick_period_cycles(  );
+    tick_sp = r[SP];
+    tick_cycles = cycles;
+    in_tick = 1;
+    interrupt( 0x1c );
+}
+
+// at the IRET of the tick handler, its cycles taken back
+static void
+tick_returned( void )
+{
+    if ( !in_tick || r[SP] != tick_sp )
+        return;
+    cycles = tick_cycles;
+    in_tick = 0;
+}
+
+// flags the stub returns through IRET
+static void
+set_ret_flag( uint16_t f, int on )
+{
+    uint16_t  off = r[SP] + 4;
+    uint16_t  v = rd8( s[SS], off ) | rd8( s[SS], off + 1 ) << 8;
+
+    v = on ? v | f : v & ~f;
+    wr8( s[SS], off, v & 0xff );
+    wr8( s[SS], off + 1, v >> 8 );
+}
+
+static void
+dos_error( uint16_t code )
+{
+    r[AX] = code;
+    set_ret_flag( F_CF, 1 );
+}
+
+static void
+get_asciiz( uint16_t seg, uint16_t off, char *buf, size_t len )
+{
+    size_t    i;
+
+    for ( i = 0; i + 1 < len && rd8( seg, off + i ); i++ )
+        buf[i] = rd8( seg, off + i );
+    buf[i] = '\0';
+}
+
+static int
+new_handle( int fd )
+{
+    for ( int h = 5; h < DOS_HANDLES; h++ )
+        if ( dos_fds[h] < 0 )
+        {
+            dos_fds[h] = fd;
+            return h;
+        }
+    close( fd );
+    return -1;
+}
+
+static double
+emulated_sec( void )
+{
+    return cycles / CPU_HZ;
+}
+
+static void
+dos_int21( void )
+{
+    uint8_t   ah = r[AX] >> 8;
+    uint8_t   al = r[AX] & 0xff;
+    uint16_t  h = r[BX];
+    char      name[128];
+    int       fd;
+
+    set_ret_flag( F_CF, 0 );
+
+    switch ( ah )
+    {
+    case 0x02:                 // display output
+        fputc( r[DX] & 0xff, stderr );
+        break;
+    case 0x09:                 // display string
+        for ( uint16_t o = r[DX]; rd8( s[DS], o ) != '$'; o++ )
+            fputc( rd8( s[DS], o ), stderr );
+        break;
+    case 0x0b:                 // check input status, no key
+        r[AX] &= 0xff00;
+        break;
+    case 0x19:                 // current drive, C:
+        r[AX] = ( r[AX] & 0xff00 ) | 2;
+        break;
+    case 0x1a:                 // set DTA
+    case 0x4a:                 // resize memory block
+        break;
+    case 0x25:                 // set interrupt vector
+        wr8( 0, al * 4, r[DX] & 0xff );
+        wr8( 0, al * 4 + 1, r[DX] >> 8 );
+        wr8( 0, al * 4 + 2, s[DS] & 0xff );
+        wr8( 0, al * 4 + 3, s[DS] >> 8 );
+        break;
+    case 0x2a:                 // get date, fixed for repeatable runs
+        r[CX] = 2023;
+        r[DX] = 6 << 8 | 1;
+        r[AX] = ( r[AX] & 0xff00 ) | 4;
+        break;
+    case 0x2c:                 // get time, noon plus the emulated time
+        {
+            unsigned long hund = emulated_sec(  ) * 100;
+            unsigned long sec = 12 * 3600 + hund / 100;
+
+            r[CX] = ( sec / 3600 % 24 ) << 8 | ( sec / 60 % 60 );
+            r[DX] = ( sec % 60 ) << 8 | ( hund % 100 );
+        }
+        break;
+    case 0x30:                 // DOS version, 2.11 as on the Portfolio
+        r[AX] = 11 << 8 | 2;
+        r[BX] = r[CX] = 0;
+        break;
+    case 0x33:                 // Ctrl-Break check, off
+        r[DX] &= 0xff00;
+        break;
+    case 0x35:                 // get interrupt vector
+        r[BX] = rd8( 0, al * 4 ) | rd8( 0, al * 4 + 1 ) << 8;
+        s[ES] = rd8( 0, al * 4 + 2 ) | rd8( 0, al * 4 + 3 ) << 8;
+        break;
+    case 0x3c:                 // create file
+        get_asciiz( s[DS], r[DX], name, sizeof( name ) );
+        fd = open( name, O_RDWR | O_CREAT | O_TRUNC, 0644 );
+        if ( fd < 0 || ( r[AX] = new_handle( fd ) ) == 0xffff )
+            dos_error( fd < 0 ? 5 : 4 );
+        break;
+    case 0x3d:                 // open file
+        get_asciiz( s[DS], r[DX], name, sizeof( name ) );
+        fd = open( name, ( al & 3 ) == 0 ? O_RDONLY :
+                   ( al & 3 ) == 1 ? O_WRONLY : O_RDWR );
+        if ( fd < 0 || ( r[AX] = new_handle( fd ) ) == 0xffff )
+            dos_error( fd < 0 ? 2 : 4 );
+        break;
+    case 0x3e:                 // close file
+        if ( h >= 5 && h < DOS_HANDLES && dos_fds[h] >= 0 )
+        {
+            close( dos_fds[h] );
+            dos_fds[h] = -1;
+        }
+        else if ( h >= 5 )
+            dos_error( 6 );
+        break;
+    case 0x3f:                 // read file
+        if ( h >= 5 && h < DOS_HANDLES && dos_fds[h] >= 0 )
+        {
+            uint8_t   buf[0x10000];
+            ssize_t   n = read( dos_fds[h], buf, r[CX] );
+
+            if ( n < 0 )
+                dos_error( 5 );
+            else
+            {
+                for ( ssize_t i = 0; i < n; i++ )
+                    wr8( s[DS], r[DX] + i, buf[i] );
+                r[AX] = n;
+            }
+        }
+        else if ( h < 5 )
+            r[AX] = 0;
+        else
+            dos_error( 6 );
+        break;
+    case 0x40:                 // write file
+        {
+            uint8_t   buf[0x10000];
+
+            for ( uint16_t i = 0; i < r[CX]; i++ )
+                buf[i] = rd8( s[DS], r[DX] + i );
+            if ( h == 1 || h == 2 )
+                fwrite( buf, 1, r[CX], stderr );
+            else if ( h >= 5 && h < DOS_HANDLES && dos_fds[h] >= 0 )
+            {
+                if ( write( dos_fds[h], buf, r[CX] ) != r[CX] )
+                {
+                    dos_error( 5 );
+                    break;
+                }
+            }
+            else if ( h >= 5 )
+            {
+                dos_error( 6 );
+                break;
+            }
+            r[AX] = r[CX];
+        }
+        break;
+    case 0x42:                 // move file pointer
+        if ( h >= 5 && h < DOS_HANDLES && dos_fds[h] >= 0 && al <= 2 )
+        {
+            off_t     pos = lseek( dos_fds[h],
+                                   ( int32_t ) ( ( uint32_t ) r[CX] << 16 | r[DX] ),
+                                   al == 0 ? SEEK_SET :
+                                   al == 1 ? SEEK_CUR : SEEK_END );
+
+            if ( pos < 0 )
+                dos_error( 25 );
+            else
+            {
+                r[AX] = pos & 0xffff;
+                r[DX] = pos >> 16;
+            }
+        }
+        else
+            dos_error( 6 );
+        break;
+    case 0x44:                 // IOCTL, device information
+        if ( al == 0 )
+            r[DX] = h < 3 ? 0x80d3 : h < 5 ? 0x80c0 : 0x0002;
+        else
+            r[AX] = 0;
+        break;
+    case 0x4c:                 // terminate
+        exit_code = al;
+        running = 0;
+        break;
+    case 0x57:                 // file date and time
+        {
+            struct stat st;
+
+            if ( h < 5 || h >= DOS_HANDLES || dos_fds[h] < 0 ||
+                 fstat( dos_fds[h], &st ) != 0 )
+            {
+                dos_error( 6 );
+                break;
+            }
+            struct tm *t = localtime( &st.st_mtime );
+
+            r[CX] = t->tm_hour << 11 | t->tm_min << 5 | t->tm_sec / 2;
+            r[DX] = ( t->tm_year - 80 ) << 9 | ( t->tm_mon + 1 ) << 5 |
+                t->tm_mday;
+        }
+        break;
+    default:
+        fprintf( stderr, "cyc86: Int 21h Fn %02Xh not supported\n", ah );
+        dos_error( 1 );
+        break;
+    }
+}
+
+static void
+bios_int( uint8_t n )
+{
+    uint8_t   ah = r[AX] >> 8;
+
+    switch ( n )
+    {
+    case 0x00:
+        fprintf( stderr, "cyc86: divide error at %04X:%04X\n",
+                 insn_cs, insn_ip );
+        exit_code = EXIT_FAILURE;
+        running = 0;
+        break;
+    case 0x10:                 // video, get mode
+        if ( ah == 0x0f )
+            r[AX] = 80 << 8 | 0x07;
+        break;
+    case 0x16:                 // keyboard, no key, Esc if waited for
+        if ( ah == 0x00 )
+            r[AX] = 0x011b;
+        else if ( ah == 0x01 )
+            set_ret_flag( F_ZF, 1 );
+        break;
+    case 0x1a:                 // clock
+        if ( ah == 0x02 )       // RTC time, 12:00:00 BCD
+        {
+            r[CX] = 0x1200;
+            r[DX] = 0x0000;
+        }
+        set_ret_flag( F_CF, 0 );
+        break;
+    case 0x20:
+        running = 0;
+        break;
+    case 0x21:
+        dos_int21(  );
+        break;
+    case 0x61:                 // Portfolio BIOS
+        if ( ah == 0x2c )       // version string
+            r[BX] = BIOS_VER_OFFS;
+        else if ( ah == 0x1e && ( r[AX] & 0xff ) == 0 )  // get tick speed
+            r[BX] = clockspeed;
+        else if ( ah == 0x1e && ( r[BX] & 1 ) != clockspeed )
+        {
+            clockspeed = r[BX] & 1;
+            next_tick_cycles = cycles + tick_period_cycles(  );
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * I/O ports
+ */
+
+static uint8_t
+port_in( uint16_t port )
+{
+    if ( port == 0x40 )         // PIT counter 0, latched LSB then MSB
+    {
+        pit_read_msb ^= 1;
+        return pit_read_msb ? pit_latch & 0xff : pit_latch >> 8;
+    }
+    return 0xff;
+}
+
+static void
+port_out( uint16_t port, uint8_t v )
+{
+    if ( port == 0x43 && v == 0x00 )    // latch counter 0
+    {
+        uint64_t  counts = ( uint64_t ) ( emulated_sec(  ) * PIT_HZ );
+
+        pit_latch = 0xffff - ( counts & 0xffff );
+        pit_read_msb = 0;
+    }
+}
+
+/*
+ * Instructions
+ */
+
+static void
+invalid( uint8_t opc )
+{
+    fprintf( stderr, "cyc86: invalid opcode %02Xh at %04X:%04X\n",
+             opc, insn_cs, insn_ip );
+    exit_code = EXIT_FAILURE;
+    running = 0;
+}
+
+static void
+shift( struct ea_t const *e, int w, unsigned int count )
+{
+    uint32_t  sign = w ? 0x8000 : 0x80;
+    uint32_t  mask = w ? 0xffff : 0xff;
+    uint32_t  v = get_rm( e, w );
+    uint32_t  orig = v;
+    int       cf = fl & F_CF ? 1 : 0;
+
+    if ( count == 0 )
+        return;
+
+    for ( unsigned int i = 0; i < count; i++ )
+    {
+        switch ( e->reg )
+        {
+        case 0:                // ROL
+            cf = ( v & sign ) != 0;
+            v = ( v << 1 | cf ) & mask;
+            break;
+        case 1:                // ROR
+            cf = v & 1;
+            v = v >> 1 | ( cf ? sign : 0 );
+            break;
+        case 2:                // RCL
+            {
+                int       out = ( v & sign ) != 0;
+
+                v = ( v << 1 | cf ) & mask;
+                cf = out;
+            }
+            break;
+        case 3:                // RCR
+            {
+                int       out = v & 1;
+
+                v = v >> 1 | ( cf ? sign : 0 );
+                cf = out;
+            }
+            break;
+        case 4:                // SHL
+        case 6:
+            cf = ( v & sign ) != 0;
+            v = v << 1 & mask;
+            break;
+        case 5:                // SHR
+            cf = v & 1;
+            v >>= 1;
+            break;
+        default:               // SAR
+            cf = v & 1;
+            v = v >> 1 | ( v & sign );
+            break;
+        }
+    }
+
+    set_flag( F_CF, cf );
+    if ( e->reg >= 4 )
+    {
+        set_szp( v, w );
+        set_flag( F_OF, e->reg == 7 ? 0 :
+                  e->reg == 5 ? ( orig & sign ) != 0 :
+                  ( ( v & sign ) != 0 ) != cf );
+    }
+    else if ( e->reg == 0 || e->reg == 2 )
+        set_flag( F_OF, ( ( v & sign ) != 0 ) != cf );
+    else
+        set_flag( F_OF, ( ( v ^ v << 1 ) & sign ) != 0 );
+    set_rm( e, w, v );
+}
+
+static void
+grp3( struct ea_t const *e, int w )
+{
+    uint16_t  v = get_rm( e, w );
+    int       mem_op = e->mod != 3;
+
+    switch ( e->reg )
+    {
+    case 0:                    // TEST
+    case 1:
+        alu( 4, v, w ? fetch16(  ) : fetch8(  ), w );
+        cost( e, 5, 11 );
+        break;
+    case 2:                    // NOT
+        set_rm( e, w, ~v );
+        cost( e, 3, 16 );
+        break;
+    case 3:                    // NEG
+        set_rm( e, w, alu( 5, 0, v, w ) );
+        cost( e, 3, 16 );
+        break;
+    case 4:                    // MUL
+        if ( w )
+        {
+            uint32_t  p = ( uint32_t ) r[AX] * v;
+
+            r[AX] = p & 0xffff;
+            r[DX] = p >> 16;
+            set_flag( F_CF | F_OF, r[DX] != 0 );
+            cycles += mem_op ? 131 : 125;
+        }
+        else
+        {
+            r[AX] = ( r[AX] & 0xff ) * v;
+            set_flag( F_CF | F_OF, r[AX] >> 8 != 0 );
+            cycles += mem_op ? 79 : 73;
+        }
+        break;
+    case 5:                    // IMUL
+        if ( w )
+        {
+            int32_t   p = ( int32_t ) ( int16_t ) r[AX] * ( int16_t ) v;
+
+            r[AX] = p & 0xffff;
+            r[DX] = ( uint32_t ) p >> 16;
+            set_flag( F_CF | F_OF, p != ( int16_t ) p );
+            cycles += mem_op ? 147 : 141;
+        }
+        else
+        {
+            int16_t   p = ( int8_t ) r[AX] * ( int8_t ) v;
+
+            r[AX] = p;
+            set_flag( F_CF | F_OF, p != ( int8_t ) p );
+            cycles += mem_op ? 95 : 89;
+        }
+        break;
+    case 6:                    // DIV
+        if ( w )
+        {
+            uint32_t  n = ( uint32_t ) r[DX] << 16 | r[AX];
+
+            cycles += mem_op ? 159 : 153;
+            if ( v == 0 || n / v > 0xffff )
+            {
+                interrupt( 0 );
+                break;
+            }
+            r[AX] = n / v;
+            r[DX] = n % v;
+        }
+        else
+        {
+            cycles += mem_op ? 91 : 85;
+            if ( v == 0 || r[AX] / v > 0xff )
+            {
+                interrupt( 0 );
+                break;
+            }
+            r[AX] = ( r[AX] % v ) << 8 | r[AX] / v;
+        }
+        break;
+    default:                   // IDIV
+        if ( w )
+        {
+            int32_t   n = ( int32_t ) ( ( uint32_t ) r[DX] << 16 | r[AX] );
+            int32_t   d = ( int16_t ) v;
+
+            cycles += mem_op ? 180 : 174;
+            // INT32_MIN / -1 overflows on the host too, trap it first
+            if ( d == 0 || ( n == INT32_MIN && d == -1 ) ||
+                 n / d > 0x7fff || n / d < -0x7fff )
+            {
+                interrupt( 0 );
+                break;
+            }
+            r[AX] = n / d;
+            r[DX] = n % d;
+        }
+        else
+        {
+            int16_t   n = r[AX];
+            int16_t   d = ( int8_t ) v;
+
+            cycles += mem_op ? 112 : 106;
+            if ( d == 0 || ( n == INT16_MIN && d == -1 ) ||
+                 n / d > 0x7f || n / d < -0x7f )
+            {
+                interrupt( 0 );
+                break;
+            }
+            r[AX] = ( uint8_t ) ( n % d ) << 8 | ( uint8_t ) ( n / d );
+        }
+        break;
+    }
+}
+
+static void
+string_op( uint8_t opc )
+{
+    int       w = opc & 1;
+    int       delta = ( fl & F_DF ? -1 : 1 ) * ( w ? 2 : 1 );
+    uint16_t  src_seg = s[seg_ovr >= 0 ? seg_ovr : DS];
+    int       once, per;        // cycles without REP, per repetition
+
+    switch ( opc & 0xfe )
+    {
+    case 0xa4:
+        once = 18;
+        per = 17;
+        break;
+    case 0xa6:
+        once = 22;
+        per = 22;
+        break;
+    case 0xaa:
+        once = 11;
+        per = 10;
+        break;
+    case 0xac:
+        once = 12;
+        per = 13;
+        break;
+    default:
+        once = 15;
+        per = 15;
+        break;
+    }
+
+    if ( rep )
+        cycles += 9;
+    else
+        cycles += once;
+
+    while ( !rep || r[CX] != 0 )
+    {
+        uint16_t  a, b;
+
+        switch ( opc & 0xfe )
+        {
+        case 0xa4:             // MOVS
+            a = w ? rd16( src_seg, r[SI] ) : rd8( src_seg, r[SI] );
+            if ( w )
+                wr16( s[ES], r[DI], a );
+            else
+                wr8( s[ES], r[DI], a );
+            r[SI] += delta;
+            r[DI] += delta;
+            break;
+        case 0xa6:             // CMPS
+            a = w ? rd16( src_seg, r[SI] ) : rd8( src_seg, r[SI] );
+            b = w ? rd16( s[ES], r[DI] ) : rd8( s[ES], r[DI] );
+            alu( 7, a, b, w );
+            r[SI] += delta;
+            r[DI] += delta;
+            break;
+        case 0xaa:             // STOS
+            if ( w )
+                wr16( s[ES], r[DI], r[AX] );
+            else
+                wr8( s[ES], r[DI], r[AX] & 0xff );
+            r[DI] += delta;
+            break;
+        case 0xac:             // LODS
+            if ( w )
+                r[AX] = rd16( src_seg, r[SI] );
+            else
+                set_r8( 0, rd8( src_seg, r[SI] ) );
+            r[SI] += delta;
+            break;
+        default:               // SCAS
+            b = w ? rd16( s[ES], r[DI] ) : rd8( s[ES], r[DI] );
+            alu( 7, w ? r[AX] : r[AX] & 0xff, b, w );
+            r[DI] += delta;
+            break;
+        }
+        if ( !rep )
+            break;
+
+        cycles += per;
+        r[CX]--;
+        if ( ( ( opc & 0xfe ) == 0xa6 || ( opc & 0xfe ) == 0xae ) &&
+             ( ( rep == 0xf3 ) != ( ( fl & F_ZF ) != 0 ) ) )
+            break;              // REPE on a difference, REPNE on a match
+    }
+}
+
+static void
+step( void )
+{
+    struct ea_t e;
+    uint8_t   opc;
+    uint16_t  v, t, sp;
+    int       w;
+
+    if ( lin( s[CS], ip ) - ( uint32_t ) STUB_SEG * 16 < 0x100 )
+    {
+        bios_int( lin( s[CS], ip ) - ( uint32_t ) STUB_SEG * 16 );
+        iret(  );
+        tick_returned(  );
+        return;
+    }
+
+    insn_cs = s[CS];
+    insn_ip = ip;
+    insn_cycles = cycles;
+    seg_ovr = -1;
+    rep = 0;
+    insns++;
+
+    for ( ;; )
+    {
+        opc = fetch8(  );
+        if ( ( opc & 0xe7 ) == 0x26 )
+            seg_ovr = opc >> 3 & 3;
+        else if ( opc == 0xf2 || opc == 0xf3 )
+            rep = opc;
+        else if ( opc != 0xf0 )
+            break;
+        cycles += 2;
+    }
+    w = opc & 1;
+
+    if ( opc < 0x40 && ( opc & 7 ) < 6 )
+    {
+        int       op = opc >> 3;
+
+        switch ( opc & 7 )
+        {
+        case 0:
+        case 1:
+            decode_ea( &e );
+            v = alu( op, get_rm( &e, w ), get_reg( e.reg, w ), w );
+            if ( op != 7 )
+                set_rm( &e, w, v );
+            cost( &e, 3, op == 7 ? 9 : 16 );
+            break;
+        case 2:
+        case 3:
+            decode_ea( &e );
+            v = alu( op, get_reg( e.reg, w ), get_rm( &e, w ), w );
+            if ( op != 7 )
+                set_reg( e.reg, w, v );
+            cost( &e, 3, 9 );
+            break;
+        default:
+            t = w ? fetch16(  ) : fetch8(  );
+            v = alu( op, get_reg( AX, w ), t, w );
+            if ( op != 7 )
+                set_reg( AX, w, v );
+            cycles += 4;
+            break;
+        }
+        return;
+    }
+
+    switch ( opc )
+    {
+    case 0x06:
+    case 0x0e:
+    case 0x16:
+    case 0x1e:
+        push( s[opc >> 3] );
+        cycles += 10;
+        break;
+    case 0x07:
+    case 0x17:
+    case 0x1f:
+        s[opc >> 3] = pop(  );
+        cycles += 8;
+        break;
+    case 0x27:                 // DAA
+    case 0x2f:                 // DAS
+        {
+            uint8_t   al = r[AX] & 0xff;
+            int       cf = fl & F_CF;
+
+            if ( ( al & 0x0f ) > 9 || ( fl & F_AF ) )
+            {
+                al += opc == 0x27 ? 6 : -6;
+                fl |= F_AF;
+            }
+            if ( ( r[AX] & 0xff ) > 0x99 || cf )
+            {
+                al += opc == 0x27 ? 0x60 : -0x60;
+                fl |= F_CF;
+            }
+            set_r8( 0, al );
+            set_szp( al, 0 );
+            cycles += 4;
+        }
+        break;
+    case 0x37:                 // AAA
+    case 0x3f:                 // AAS
+        if ( ( r[AX] & 0x0f ) > 9 || ( fl & F_AF ) )
+        {
+            r[AX] += opc == 0x37 ? 0x106 : -0x106;
+            fl |= F_AF | F_CF;
+        }
+        else
+            fl &= ~( F_AF | F_CF );
+        r[AX] &= 0xff0f;
+        cycles += 4;
+        break;
+    case 0x40 ... 0x4f:
+        r[opc & 7] = inc_dec( r[opc & 7], opc & 8, 1 );
+        cycles += 2;
+        break;
+    case 0x50 ... 0x57:
+        if ( opc == 0x54 )      // the 8086 pushes the new SP
+        {
+            r[SP] -= 2;
+            wr16( s[SS], r[SP], r[SP] );
+        }
+        else
+            push( r[opc & 7] );
+        cycles += 11;
+        break;
+    case 0x58 ... 0x5f:
+        r[opc & 7] = pop(  );
+        cycles += 8;
+        break;
+    case 0x70 ... 0x7f:
+        t = ( int8_t ) fetch8(  );
+        if ( cond( opc & 0x0f ) )
+        {
+            ip += t;
+            cycles += 16;
+        }
+        else
+            cycles += 4;
+        break;
+    case 0x80 ... 0x83:
+        decode_ea( &e );
+        v = get_rm( &e, w );
+        t = opc == 0x81 ? fetch16(  ) :
+            opc == 0x83 ? ( uint16_t ) ( int8_t ) fetch8(  ) : fetch8(  );
+        t = alu( e.reg, v, t, w );
+        if ( e.reg != 7 )
+            set_rm( &e, w, t );
+        cost( &e, 4, e.reg == 7 ? 10 : 17 );
+        break;
+    case 0x84:
+    case 0x85:
+        decode_ea( &e );
+        alu( 4, get_rm( &e, w ), get_reg( e.reg, w ), w );
+        cost( &e, 3, 9 );
+        break;
+    case 0x86:
+    case 0x87:
+        decode_ea( &e );
+        v = get_rm( &e, w );
+        set_rm( &e, w, get_reg( e.reg, w ) );
+        set_reg( e.reg, w, v );
+        cost( &e, 4, 17 );
+        break;
+    case 0x88:
+    case 0x89:
+        decode_ea( &e );
+        set_rm( &e, w, get_reg( e.reg, w ) );
+        cost( &e, 2, 9 );
+        break;
+    case 0x8a:
+    case 0x8b:
+        decode_ea( &e );
+        set_reg( e.reg, w, get_rm( &e, w ) );
+        cost( &e, 2, 8 );
+        break;
+    case 0x8c:
+        decode_ea( &e );
+        set_rm( &e, 1, s[e.reg & 3] );
+        cost( &e, 2, 9 );
+        break;
+    case 0x8d:
+        decode_ea( &e );
+        r[e.reg] = e.off;
+        cycles += 2;
+        break;
+    case 0x8e:
+        decode_ea( &e );
+        s[e.reg & 3] = get_rm( &e, 1 );
+        cost( &e, 2, 8 );
+        break;
+    case 0x8f:
+        decode_ea( &e );
+        v = pop(  );
+        set_rm( &e, 1, v );
+        cost( &e, 8, 17 );
+        break;
+    case 0x90:
+        cycles += 3;
+        break;
+    case 0x91 ... 0x97:
+        v = r[AX];
+        r[AX] = r[opc & 7];
+        r[opc & 7] = v;
+        cycles += 3;
+        break;
+    case 0x98:
+        r[AX] = ( int8_t ) r[AX];
+        cycles += 2;
+        break;
+    case 0x99:
+        r[DX] = r[AX] & 0x8000 ? 0xffff : 0;
+        cycles += 5;
+        break;
+    case 0x9a:
+        v = fetch16(  );
+        t = fetch16(  );
+        sp = r[SP];
+        push( s[CS] );
+        push( ip );
+        on_call( t, v, sp );
+        s[CS] = t;
+        ip = v;
+        cycles += 28;
+        break;
+    case 0x9b:
+        cycles += 3;
+        break;
+    case 0x9c:
+        push( fl | 0xf002 );
+        cycles += 10;
+        break;
+    case 0x9d:
+        fl = pop(  ) | 0xf002;
+        cycles += 8;
+        break;
+    case 0x9e:
+        fl = ( fl & 0xff00 ) | ( r[AX] >> 8 & 0xd5 ) | 0x02;
+        cycles += 4;
+        break;
+    case 0x9f:
+        r[AX] = ( r[AX] & 0xff ) | ( ( fl & 0xd7 ) | 0x02 ) << 8;
+        cycles += 4;
+        break;
+    case 0xa0 ... 0xa3:
+        t = fetch16(  );
+        v = s[seg_ovr >= 0 ? seg_ovr : DS];
+        if ( opc < 0xa2 )
+            set_reg( AX, w, w ? rd16( v, t ) : rd8( v, t ) );
+        else if ( w )
+            wr16( v, t, r[AX] );
+        else
+            wr8( v, t, r[AX] & 0xff );
+        cycles += 10;
+        break;
+    case 0xa4 ... 0xa7:
+    case 0xaa ... 0xaf:
+        string_op( opc );
+        break;
+    case 0xa8:
+    case 0xa9:
+        alu( 4, get_reg( AX, w ), w ? fetch16(  ) : fetch8(  ), w );
+        cycles += 4;
+        break;
+    case 0xb0 ... 0xb7:
+        set_r8( opc & 7, fetch8(  ) );
+        cycles += 4;
+        break;
+    case 0xb8 ... 0xbf:
+        r[opc & 7] = fetch16(  );
+        cycles += 4;
+        break;
+    case 0xc2:
+    case 0xc3:
+        t = opc == 0xc2 ? fetch16(  ) : 0;
+        ip = pop(  );
+        r[SP] += t;
+        cycles += opc == 0xc2 ? 12 : 8;
+        on_return(  );
+        break;
+    case 0xc4:
+    case 0xc5:
+        decode_ea( &e );
+        r[e.reg] = rd16( e.seg, e.off );
+        s[opc == 0xc4 ? ES : DS] = rd16( e.seg, e.off + 2 );
+        cycles += 16;
+        break;
+    case 0xc6:
+    case 0xc7:
+        decode_ea( &e );
+        set_rm( &e, w, w ? fetch16(  ) : fetch8(  ) );
+        cost( &e, 4, 10 );
+        break;
+    case 0xca:
+    case 0xcb:
+        t = opc == 0xca ? fetch16(  ) : 0;
+        ip = pop(  );
+        s[CS] = pop(  );
+        r[SP] += t;
+        cycles += opc == 0xca ? 17 : 18;
+        on_return(  );
+        break;
+    case 0xcc:
+        interrupt( 3 );
+        cycles += 52;
+        break;
+    case 0xcd:
+        v = fetch8(  );
+        interrupt( v );
+        cycles += 51;
+        break;
+    case 0xce:
+        if ( fl & F_OF )
+        {
+            interrupt( 4 );
+            cycles += 53;
+        }
+        else
+            cycles += 4;
+        break;
+    case 0xcf:
+        iret(  );
+        fl |= 0xf002;
+        cycles += 24;
+        on_return(  );
+        tick_returned(  );
+        break;
+    case 0xd0 ... 0xd3:
+        decode_ea( &e );
+        t = opc < 0xd2 ? 1 : r[CX] & 0xff;
+        shift( &e, w, t );
+        if ( opc < 0xd2 )
+            cost( &e, 2, 15 );
+        else
+            cost( &e, 8 + 4 * t, 20 + 4 * t );
+        break;
+    case 0xd4:                 // AAM
+        t = fetch8(  );
+        if ( t == 0 )
+        {
+            interrupt( 0 );
+            break;
+        }
+        r[AX] = ( r[AX] & 0xff ) / t << 8 | ( r[AX] & 0xff ) % t;
+        set_szp( r[AX] & 0xff, 0 );
+        cycles += 83;
+        break;
+    case 0xd5:                 // AAD
+        t = fetch8(  );
+        r[AX] = ( ( r[AX] >> 8 ) * t + ( r[AX] & 0xff ) ) & 0xff;
+        set_szp( r[AX], 0 );
+        cycles += 60;
+        break;
+    case 0xd7:                 // XLAT
+        set_r8( 0, rd8( s[seg_ovr >= 0 ? seg_ovr : DS],
+                        r[BX] + ( r[AX] & 0xff ) ) );
+        cycles += 11;
+        break;
+    case 0xd8 ... 0xdf:        // ESC, no coprocessor
+        decode_ea( &e );
+        cost( &e, 2, 8 );
+        break;
+    case 0xe0 ... 0xe3:
+        t = ( int8_t ) fetch8(  );
+        if ( opc == 0xe3 )
+            v = r[CX] == 0;
+        else
+        {
+            r[CX]--;
+            v = r[CX] != 0 && ( opc == 0xe2 ||
+                                ( opc == 0xe1 ) == ( ( fl & F_ZF ) != 0 ) );
+        }
+        if ( v )
+            ip += t;
+        cycles += opc == 0xe2 ? ( v ? 17 : 5 ) :
+            opc == 0xe0 ? ( v ? 19 : 5 ) : ( v ? 18 : 6 );
+        break;
+    case 0xe4:
+    case 0xe5:
+    case 0xec:
+    case 0xed:
+        t = opc < 0xe8 ? fetch8(  ) : r[DX];
+        if ( w )
+            r[AX] = port_in( t ) | port_in( t + 1 ) << 8;
+        else
+            set_r8( 0, port_in( t ) );
+        cycles += opc < 0xe8 ? 10 : 8;
+        break;
+    case 0xe6:
+    case 0xe7:
+    case 0xee:
+    case 0xef:
+        t = opc < 0xe8 ? fetch8(  ) : r[DX];
+        port_out( t, r[AX] & 0xff );
+        if ( w )
+            port_out( t + 1, r[AX] >> 8 );
+        cycles += opc < 0xe8 ? 10 : 8;
+        break;
+    case 0xe8:
+        t = fetch16(  );
+        sp = r[SP];
+        push( ip );
+        on_call( s[CS], ip + t, sp );
+        ip += t;
+        cycles += 19;
+        break;
+    case 0xe9:
+        t = fetch16(  );
+        ip += t;
+        cycles += 15;
+        break;
+    case 0xea:
+        v = fetch16(  );
+        s[CS] = fetch16(  );
+        ip = v;
+        cycles += 15;
+        break;
+    case 0xeb:
+        t = ( int8_t ) fetch8(  );
+        ip += t;
+        cycles += 15;
+        break;
+    case 0xf4:
+        fprintf( stderr, "cyc86: HLT at %04X:%04X, not emulated\n",
+                 insn_cs, insn_ip );
+        exit_code = EXIT_FAILURE;
+        running = 0;
+        break;
+    case 0xf5:
+        fl ^= F_CF;
+        cycles += 2;
+        break;
+    case 0xf6:
+    case 0xf7:
+        decode_ea( &e );
+        grp3( &e, w );
+        break;
+    case 0xf8 ... 0xfd:
+        {
+            static uint16_t const f[] = { F_CF, F_CF, F_IF, F_IF, F_DF, F_DF };
+
+            set_flag( f[opc - 0xf8], opc & 1 );
+            cycles += 2;
+        }
+        break;
+    case 0xfe:
+    case 0xff:
+        decode_ea( &e );
+        if ( opc == 0xfe && e.reg > 1 )
+        {
+            invalid( opc );
+            break;
+        }
+        switch ( e.reg )
+        {
+        case 0:
+        case 1:
+            set_rm( &e, w, inc_dec( get_rm( &e, w ), e.reg, w ) );
+            cost( &e, 3, 15 );
+            break;
+        case 2:                // CALL near
+            v = get_rm( &e, 1 );
+            sp = r[SP];
+            push( ip );
+            on_call( s[CS], v, sp );
+            ip = v;
+            cost( &e, 16, 21 );
+            break;
+        case 3:                // CALL far
+            v = rd16( e.seg, e.off );
+            t = rd16( e.seg, e.off + 2 );
+            sp = r[SP];
+            push( s[CS] );
+            push( ip );
+            on_call( t, v, sp );
+            s[CS] = t;
+            ip = v;
+            cycles += 37;
+            break;
+        case 4:                // JMP near
+            ip = get_rm( &e, 1 );
+            cost( &e, 11, 18 );
+            break;
+        case 5:                // JMP far
+            ip = rd16( e.seg, e.off );
+            s[CS] = rd16( e.seg, e.off + 2 );
+            cycles += 24;
+            break;
+        case 6:
+            push( get_rm( &e, 1 ) );
+            cost( &e, 11, 16 );
+            break;
+        default:
+            invalid( opc );
+            break;
+        }
+        break;
+    default:                   // 80186 and later, undocumented
+        invalid( opc );
+        break;
+    }
+}
+
+/*
+ * Loading
+ */
+
+static long
+file_size( FILE *f )
+{
+    long      n;
+
+    if ( fseek( f, 0, SEEK_END ) != 0 || ( n = ftell( f ) ) < 0 ||
+         fseek( f, 0, SEEK_SET ) != 0 )
+        return -1;
+    return n;
+}
+
+static uint16_t
+get_u16( uint8_t const *p )
+{
+    return p[0] | p[1] << 8;
+}
+
+static int
+load_program( char const *filename, uint16_t *load_seg )
+{
+    FILE     *f = fopen( filename, "rb" );
+    long      size;
+    uint8_t  *buf;
+
+    if ( f == NULL )
+    {
+        perror( filename );
+        return -1;
+    }
+    size = file_size( f );
+    buf = malloc( size > 0 ? size : 1 );
+    if ( size <= 0 || buf == NULL || fread( buf, size, 1, f ) != 1 )
+    {
+        fprintf( stderr, "err: read %s\n", filename );
+        fclose( f );
+        return -1;
+    }
+    fclose( f );
+
+    *load_seg = PSP_SEG + 0x10;
+
+    if ( size >= 0x1c && buf[0] == 'M' && buf[1] == 'Z' )
+    {
+        long      image_off = get_u16( buf + 0x08 ) * 16L;
+        long      image_end = get_u16( buf + 0x04 ) * 512L -
+            ( get_u16( buf + 0x02 ) ? 512 - get_u16( buf + 0x02 ) : 0 );
+        unsigned int nrelocs = get_u16( buf + 0x06 );
+        long      relocs_off = get_u16( buf + 0x18 );
+
+        if ( image_end > size || image_off > image_end ||
+             relocs_off + nrelocs * 4L > size ||
+             image_end - image_off > ( MEM_TOP_SEG - *load_seg ) * 16L )
+        {
+            fprintf( stderr, "err: %s: bad EXE header\n", filename );
+            return -1;
+        }
+        memcpy( mem + *load_seg * 16L, buf + image_off,
+                image_end - image_off );
+
+        for ( unsigned int i = 0; i < nrelocs; i++ )
+        {
+            uint8_t const *rel = buf + relocs_off + i * 4;
+            uint16_t  seg = *load_seg + get_u16( rel + 2 );
+            uint16_t  off = get_u16( rel );
+            uint16_t  v = rd8( seg, off ) | rd8( seg, off + 1 ) << 8;
+
+            v += *load_seg;
+            wr8( seg, off, v & 0xff );
+            wr8( seg, off + 1, v >> 8 );
+        }
+
+        s[SS] = *load_seg + get_u16( buf + 0x0e );
+        r[SP] = get_u16( buf + 0x10 );
+        s[CS] = *load_seg + get_u16( buf + 0x16 );
+        ip = get_u16( buf + 0x14 );
+    }
+    else                        // .COM
+    {
+        if ( size > 0xff00 )
+        {
+            fprintf( stderr, "err: %s: too big for a .COM\n", filename );
+            return -1;
+        }
+        memcpy( mem + PSP_SEG * 16L + 0x100, buf, size );
+        s[SS] = s[CS] = PSP_SEG;
+        r[SP] = 0xfffe;         // a zero word, RET goes to Int 20h
+        ip = 0x100;             // the image at PSP:0100 = load_seg:0000
+    }
+    free( buf );
+    s[DS] = s[ES] = PSP_SEG;
+    return 0;
+}
+
+static void
+setup_machine( char const *program, char const *args )
+{
+    static char const env[] = "COMSPEC=C:\\COMMAND.COM";
+    uint32_t  a;
+    size_t    n;
+
+    for ( unsigned int i = 0; i < 256; i++ )
+    {
+        wr8( 0, i * 4, i );
+        wr8( 0, i * 4 + 1, 0 );
+        wr8( 0, i * 4 + 2, STUB_SEG & 0xff );
+        wr8( 0, i * 4 + 3, STUB_SEG >> 8 );
+    }
+    memcpy( mem + BIOS_VER_SEG * 16L + BIOS_VER_OFFS, "1.052", 5 );
+
+    // environment, then the program path
+    a = ENV_SEG * 16L;
+    memcpy( mem + a, env, sizeof( env ) );
+    a += sizeof( env ) + 1;
+    mem[a++] = 1;
+    mem[a++] = 0;
+    snprintf( ( char * ) mem + a, 0x80, "C:\\%s", program );
+
+    // PSP: Int 20h, memory top, environment, command tail
+    a = PSP_SEG * 16L;
+    mem[a] = 0xcd;
+    mem[a + 1] = 0x20;
+    mem[a + 2] = MEM_TOP_SEG & 0xff;
+    mem[a + 3] = MEM_TOP_SEG >> 8;
+    mem[a + 0x2c] = ENV_SEG & 0xff;
+    mem[a + 0x2d] = ENV_SEG >> 8;
+    n = snprintf( ( char * ) mem + a + 0x81, 0x7e, "%s%s\r",
+                  *args ? " " : "", args );
+    mem[a + 0x80] = n - 1;
+
+    fl = 0xf202;
+    for ( unsigned int h = 0; h < DOS_HANDLES; h++ )
+        dos_fds[h] = -1;
+}
+
+// TLINK map, "Publics by Value": "SSSS:OOOO [Abs|Idle] name"
+static int
+load_map( char const *filename, uint16_t load_seg )
+{
+    FILE     *f = fopen( filename, "r" );
+    char      line[256];
+
+    if ( f == NULL )
+    {
+        perror( filename );
+        return -1;
+    }
+
+    while ( fgets( line, sizeof( line ), f ) )
+    {
+        unsigned int seg, off;
+        char      name[200], name2[200];
+        char     *sym = name;
+        int       n = sscanf( line, " %4x:%4x %199s %199s", &seg, &off,
+                              name, name2 );
+
+        if ( n < 3 || strcmp( name, "Abs" ) == 0 )
+            continue;
+        if ( n == 4 && strcmp( name, "Idle" ) == 0 )
+            sym = name2;
+
+        for ( unsigned int i = 0; i < nroutines; i++ )
+            if ( routines[i].entry == 0 &&
+                 strncmp( sym, routines[i].map_prefix,
+                          strlen( routines[i].map_prefix ) ) == 0 )
+                routines[i].entry = lin( load_seg + seg, off );
+    }
+    fclose( f );
+    return 0;
+}
+
+/*
+ * Results
+ */
+
+static void
+print_results( void )
+{
+    printf( "%-26s %10s %10s %10s %10s\n",
+            "ROUTINE", "CALLS", "MIN CYC", "AVG CYC", "MAX CYC" );
+    for ( unsigned int i = 0; i < nroutines; i++ )
+    {
+        struct routine_t const *rt = &routines[i];
+
+        if ( rt->entry == 0 )
+            continue;
+        printf( "%-26s %10lu %10llu %10llu %10llu\n", rt->name, rt->calls,
+                ( unsigned long long ) rt->min,
+                ( unsigned long long ) ( rt->calls ?
+                                         rt->total / rt->calls : 0 ),
+                ( unsigned long long ) rt->max );
+    }
+}
+
+// avg cycles above the baseline's by more than threshold_pct
+static int
+check_regressions( char const *filename, double threshold_pct )
+{
+    FILE     *f = fopen( filename, "r" );
+    char      line[256];
+    int       regressions = 0;
+
+    if ( f == NULL )
+    {
+        perror( filename );
+        return -1;
+    }
+
+    while ( fgets( line, sizeof( line ), f ) )
+    {
+        char      name[64];
+        unsigned long calls;
+        unsigned long long min, avg, max;
+
+        if ( sscanf( line, "%63s %lu %llu %llu %llu", name, &calls, &min,
+                     &avg, &max ) != 5 )
+            continue;
+
+        for ( unsigned int i = 0; i < nroutines; i++ )
+        {
+            struct routine_t const *rt = &routines[i];
+            unsigned long long now;
+
+            if ( strcmp( rt->name, name ) != 0 || rt->calls == 0 )
+                continue;
+            now = rt->total / rt->calls;
+            if ( now > avg * ( 1 + threshold_pct / 100 ) )
+            {
+                fprintf( stderr, "REGRESSION %s: %llu cycles per call, "
+                         "baseline %llu (%+.1f%%)\n", name, now, avg,
+                         avg ? ( now - ( double ) avg ) * 100 / avg : 100 );
+                regressions++;
+            }
+        }
+    }
+    fclose( f );
+    return regressions;
+}
+
+void
+print_usage( char *prog_name )
+{
+    printf( "Usage: %s [-m <map_file>] [-r <name>=<map_prefix>] "
+            "[-b <baseline> [-t <pct>]] [-n <max_insns>]\n"
+            "          <exe_file> [-- <program args>]\n", prog_name );
+}
+
+int
+main( int argc, char **argv )
+{
+    char const *map_filename = NULL;
+    char const *baseline_filename = NULL;
+    double    threshold_pct = 0;
+    uint64_t  max_insns = DEFAULT_MAX_INSNS;
+    char      map_default[256];
+    char      args[128] = "bench";
+    uint16_t  load_seg;
+    int       opt;
+
+    while ( ( opt = getopt( argc, argv, "m:r:b:t:n:" ) ) != -1 )
+    {
+        if ( opt == 'm' )
+            map_filename = optarg;
+        else if ( opt == 'r' && strchr( optarg, '=' ) &&
+                  nroutines < ROUTINES_MAX )
+        {
+            char     *eq = strchr( optarg, '=' );
+
+            *eq = '\0';
+            routines[nroutines].name = optarg;
+            routines[nroutines].map_prefix = eq + 1;
+            nroutines++;
+        }
+        else if ( opt == 'b' )
+            baseline_filename = optarg;
+        else if ( opt == 't' )
+            threshold_pct = atof( optarg );
+        else if ( opt == 'n' )
+            max_insns = strtoull( optarg, NULL, 10 );
+        else
+        {
+            print_usage( argv[0] );
+            return EXIT_FAILURE;
+        }
+    }
+    if ( optind >= argc || threshold_pct < 0 )
+    {
+        print_usage( argv[0] );
+        return EXIT_FAILURE;
+    }
+
+    char const *exe_filename = argv[optind++];
+
+    if ( optind < argc )        // after "--"
+    {
+        args[0] = '\0';
+        for ( ; optind < argc; optind++ )
+        {
+            strncat( args, argv[optind], sizeof( args ) - strlen( args ) - 2 );
+            if ( optind + 1 < argc )
+                strcat( args, " " );
+        }
+    }
+
+    if ( map_filename == NULL )
+    {
+        char     *dot;
+
+        snprintf( map_default, sizeof( map_default ), "%s", exe_filename );
+        dot = strrchr( map_default, '.' );
+        if ( dot == NULL || strchr( dot, '/' ) )
+            dot = map_default + strlen( map_default );
+        snprintf( dot, map_default + sizeof( map_default ) - dot, "%s",
+                  dot[0] && dot[1] >= 'a' ? ".map" : ".MAP" );
+        map_filename = map_default;
+    }
+
+    char const *base = strrchr( exe_filename, '/' );
+
+    setup_machine( base ? base + 1 : exe_filename, args );
+    if ( load_program( exe_filename, &load_seg ) != 0 ||
+         load_map( map_filename, load_seg ) != 0 )
+        return EXIT_FAILURE;
+
+    for ( unsigned int i = 0; i < nroutines; i++ )
+        if ( routines[i].entry == 0 )
+            fprintf( stderr, "cyc86: %s (%s*) not in the map\n",
+                     routines[i].name, routines[i].map_prefix );
+
+    while ( running && insns < max_insns )
+    {
+        if ( cycles >= next_tick_cycles && ( fl & F_IF ) && !in_tick )
+            tick(  );
+        step(  );
+    }
+
+    fflush( stdout );
+    fprintf( stderr, "cyc86: %llu instructions, %llu cycles "
+             "(%.2f s at %.4f MHz), exit code %d%s\n",
+             ( unsigned long long ) insns, ( unsigned long long ) cycles,
+             emulated_sec(  ), CPU_HZ / 1e6, exit_code,
+             running ? ", instruction limit reached" : "" );
+    if ( running )
+        exit_code = EXIT_FAILURE;
+
+    print_results(  );
+
+    if ( baseline_filename )
+    {
+        int       regressions =
+            check_regressions( baseline_filename, threshold_pct );
+
+        if ( regressions != 0 )
+            return regressions < 0 ? EXIT_FAILURE : 2;
+    }
+    return exit_code ? EXIT_FAILURE : EXIT_SUCCESS;
+}
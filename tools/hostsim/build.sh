@@ -0,0 +1,73 @@
+#!/bin/sh
+#
+# Copyright (c) 2023 Vladimir Chren
+# All rights reserved.
+#
+# SPDX-License-Identifier: MIT
+#
+# Builds the hosted simulation into tools/hostsim/out/hostsim,
+# extra arguments go to the program sources, e.g. -DBIOSTRACE
+#
+#   tools/hostsim/build.sh [-D<FLAG> ...]
+#
+# The program sources are copied to out/src first: Borland's 'T & const'
+# references become plain references, <sys\stat.h> gets a forward slash
+# and the font data in fnt_dat.asm is turned into C.
+
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+src=$here/../../src
+out=$here/out
+
+rm -rf "$out"
+mkdir -p "$out/src" "$out/obj"
+
+for f in "$src"/*.cpp "$src"/*.h
+do
+    tr -d '\r' < "$f" |
+        sed -e 's/&\([[:space:]]*\)const\b/\&\1/g' \
+            -e 's/<sys\\stat\.h>/<sys\/stat.h>/' \
+            > "$out/src/$(basename "$f")"
+done
+
+tr -d '\r' < "$src/fnt_dat.asm" | awk '
+    /^_[a-z_]+ LABEL/ {
+        if (name) print "};"
+        name = substr($1, 2)
+        print "unsigned char const " name "[] __attribute__((aligned(4))) = {"
+        next
+    }
+    /^[ \t]*DB/ {
+        n = split($2, b, ",")
+        line = ""
+        for (i = 1; i <= n; i++)
+        {
+            v = 0
+            for (j = 1; j < length(b[i]); j++)  # binary, trailing "b"
+                v = v * 2 + substr(b[i], j, 1)
+            line = line sprintf(" 0x%02x,", v)
+        }
+        print line
+    }
+    END { if (name) print "};" }
+    ' > "$out/src/fnt_dat.c"
+
+# warnings on, but for the Borland pragmas (#pragma warn, argsused)
+CXXFLAGS="-std=gnu++98 -O2 -Wall -Wno-unknown-pragmas -DHOSTSIM"
+PROGFLAGS="-include $here/prelude.h -I$here/include -I$here -I$out/src"
+
+for f in "$out"/src/*.cpp
+do
+    o=$out/obj/$(basename "$f" .cpp).o
+    case $f in
+        */pfwallcl.cpp) g++ $CXXFLAGS $PROGFLAGS -Dmain=pfwallcl_main "$@" -c -o "$o" "$f" ;;
+        *) g++ $CXXFLAGS $PROGFLAGS "$@" -c -o "$o" "$f" ;;
+    esac
+done
+
+gcc -O2 -Wall -c -o "$out/obj/fnt_dat.o" "$out/src/fnt_dat.c"
+g++ -O2 -Wall -I$here/include -c -o "$out/obj/hostsim.o" "$here/hostsim.cpp"
+g++ -o "$out/hostsim" "$out"/obj/*.o
+
+echo "$out/hostsim"
@@ -0,0 +1,951 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Hosted simulation of pfwallcl, runs the program's main() (built with
+ * HOSTSIM, see build.sh) against a simulated Portfolio on a virtual clock:
+ *
+ * - Int 1Ch every 1 or 128 seconds as set with Int 61h Fn 1Eh,
+ *   Int 4Ah when the RTC reaches the alarm set with Int 1Ah Fn 06h
+ * - hlt sleeps until the next interrupt (tick, alarm or key), every
+ *   main loop pass (kbhit()) costs a fixed quantum of awake time
+ * - power off (Int 61h Fn 2Dh) sleeps until the RTC alarm or a key
+ * - the LCD controller (ports 8010h/8011h) fills a display memory,
+ *   a frame is counted whenever the cursor jumps
+ * - keys and RTC settings are replayed from a trace file
+ *
+ * Trace file, a record per line, times elapsed since the start:
+ *
+ *   # h:mm:ss  record
+ *   0:00:00    rtc 07:59:30    set the RTC time of day
+ *   0:12:00    key a           a key, or 'esc' / 'space'
+ *
+ * Run from a directory with PFWALLCL.INI:
+ *   ./hostsim [-t <trace>] [-s <hh:mm:ss>] [-D <yyyy-mm-dd>] [-d <hours>]
+ *             [-q <ms>] [-r <seed>] [-p <lcd.pbm>] [-- <program args>]
+ *
+ * Once the simulated time is over, the keyboard returns Esc until
+ * the program exits, then the counters are printed.
+ */
+
+#include "dos.h"
+#include "conio.h"
+#include "io.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define US_PER_SEC 1000000ULL
+#define US_PER_MS 1000ULL
+#define SECONDS_PER_DAY 86400ULL
+#define DAYS_1970_TO_1980 3652
+#define PIT_HZ 1193182ULL
+#define NEVER UINT64_MAX
+
+#define ESC_CHAR '\33'
+#define SPACE_CHAR ' '
+
+#define TICK_SEC_NORMAL 128
+#define TICK_SEC_FAST 1
+
+#define KBD_BUF_SIZE 16
+#define FAR_PTRS_MAX 16
+#define BIOS_FNS_MAX 32
+
+#define LCD_WIDTH 240
+#define LCD_HEIGHT 64
+#define LCD_ROW_B ( LCD_WIDTH / 8 )
+#define LCD_MEM_B 2048
+
+#define UMEM_FIRST 0xa0000UL   // segments A000h..FFFFh
+#define UMEM_SIZE 0x60000UL
+#define VRAM_FIRST 0xb0000UL   // B000h..BFFFh mirror the 8 KB video RAM
+#define VRAM_END 0xc0000UL
+#define VRAM_MIRROR 0x2000UL
+#define BIOS_VER_SEG 0xe000
+#define BIOS_VER_OFFS 0x0100
+
+int pfwallcl_main( int, char *const * );
+
+enum trace_kind_t
+{
+    TRACE_KEY,
+    TRACE_RTC
+};
+
+struct trace_rec_t
+{
+    uint64_t  at_us;
+    trace_kind_t kind;
+    unsigned int value;         // key code, or RTC time of day (seconds)
+};
+
+struct regs_t                   // registers in and out of a BIOS call
+{
+    uint16_t  ax, bx, cx, dx, ds, es, cflag;
+};
+
+struct bios_fn_t
+{
+    uint8_t   intno;
+    uint8_t   fn;
+    unsigned long calls;
+};
+
+// options
+static uint64_t end_us = 24 * 3600 * US_PER_SEC;
+static uint64_t quantum_us = 20 * US_PER_MS;
+static unsigned int seed = 1;
+static char const *pbm_filename = NULL;
+
+// virtual clock
+static uint64_t now_us = 0;
+static uint64_t rtc_base_sec;   // RTC seconds since 1980-01-01 at now_us 0
+
+// machine
+static hostsim_isr_fp_t isr[256];
+static unsigned int clockspeed = 0;     // Int 61h Fn 1Eh, 0 normal, 1 fast
+static uint64_t next_tick_us;
+static unsigned int alarm_set = 0;
+static unsigned int alarm_daysec;
+static uint64_t alarm_due_us = NEVER;
+
+static trace_rec_t *trace = NULL;
+static unsigned int trace_len = 0;
+static unsigned int trace_pos = 0;
+
+static int kbd_buf[KBD_BUF_SIZE];
+static unsigned int kbd_len = 0;
+
+static uint8_t umem[UMEM_SIZE];
+static void const *far_ptrs[FAR_PTRS_MAX];
+static unsigned int far_ptrs_len = 0;
+
+static uint8_t lcd_mem[LCD_MEM_B];
+static uint8_t lcd_reg;
+static uint8_t lcd_addr_lo;
+static unsigned int lcd_cursor = UINT16_MAX;
+static unsigned int lcd_row = UINT16_MAX;       // address the last row started at
+static uint16_t pit_latch;
+static unsigned int pit_read_msb = 0;
+
+// counters
+static struct
+{
+    unsigned long halts;
+    unsigned long wakeups;
+    unsigned long passes;
+    unsigned long frames;
+    unsigned long frames_partial;
+    unsigned long lcd_bytes;
+    unsigned long tones;
+    unsigned long ticks;
+    unsigned long alarms;
+    unsigned long keys;
+    unsigned long keys_dropped;
+    unsigned long poweroffs;
+    unsigned long bios_calls;
+    uint64_t  awake_us;
+    uint64_t  halted_us;
+    uint64_t  off_us;
+} cnt;
+
+static bios_fn_t bios_fns[BIOS_FNS_MAX];
+static unsigned int bios_fns_len = 0;
+
+static uint64_t
+rtc_sec( void )
+{
+    return rtc_base_sec + now_us / US_PER_SEC;
+}
+
+static uint8_t
+bcd( unsigned int n )
+{
+    return ( n / 10 ) << 4 | n % 10;
+}
+
+static unsigned int
+unbcd( uint8_t b )
+{
+    return ( b >> 4 ) * 10 + ( b & 0x0f );
+}
+
+// days since 1970-01-01 from civil, H. Hinnant's algorithm
+static long
+days_from_civil( long y, unsigned int m, unsigned int d )
+{
+    y -= m <= 2;
+    long      era = ( y >= 0 ? y : y - 399 ) / 400;
+    long      yoe = y - era * 400;
+    long      doy = ( 153 * ( m + ( m > 2 ? -3 : 9 ) ) + 2 ) / 5 + d - 1;
+    long      doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + doe - 719468;
+}
+
+static void
+civil_from_days( long z, int *y, unsigned int *m, unsigned int *d )
+{
+    z += 719468;
+    long      era = ( z >= 0 ? z : z - 146096 ) / 146097;
+    long      doe = z - era * 146097;
+    long      yoe = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;
+    long      doy = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );
+    long      mp = ( 5 * doy + 2 ) / 153;
+
+    *d = doy - ( 153 * mp + 2 ) / 5 + 1;
+    *m = mp < 10 ? mp + 3 : mp - 9;
+    *y = yoe + era * 400 + ( *m <= 2 );
+}
+
+static void
+rtc_date( int *y, unsigned int *m, unsigned int *d )
+{
+    civil_from_days( rtc_sec(  ) / SECONDS_PER_DAY + DAYS_1970_TO_1980,
+                     y, m, d );
+}
+
+static char *
+fmt_hms( uint64_t us, char *buf )
+{
+    uint64_t  sec = us / US_PER_SEC;
+
+    sprintf( buf, "%lu:%02u:%02u", ( unsigned long ) ( sec / 3600 ),
+             ( unsigned int ) ( sec / 60 % 60 ), ( unsigned int ) ( sec % 60 ) );
+    return buf;
+}
+
+static int
+parse_hms( char const *s, unsigned long *sec )
+{
+    unsigned long h;
+    unsigned int m, ss;
+    char      c;
+
+    if ( sscanf( s, "%lu:%u:%u%c", &h, &m, &ss, &c ) != 3 || m > 59 || ss > 59 )
+        return -1;
+
+    *sec = h * 3600 + m * 60 + ss;
+    return 0;
+}
+
+/*
+ * Devices
+ */
+
+static uint64_t
+tick_period_us( void )
+{
+    return ( clockspeed ? TICK_SEC_FAST : TICK_SEC_NORMAL ) * US_PER_SEC;
+}
+
+static void
+arm_alarm( void )
+{
+    if ( !alarm_set )
+    {
+        alarm_due_us = NEVER;
+        return;
+    }
+
+    // the alarm second just reached fires on the next day
+    uint64_t  to_sec = ( alarm_daysec + SECONDS_PER_DAY -
+                         rtc_sec(  ) % SECONDS_PER_DAY ) % SECONDS_PER_DAY;
+
+    if ( to_sec == 0 )
+        to_sec = SECONDS_PER_DAY;
+
+    alarm_due_us = ( now_us / US_PER_SEC + to_sec ) * US_PER_SEC;
+}
+
+static uint64_t
+next_trace_us( void )
+{
+    return trace_pos < trace_len ? trace[trace_pos].at_us : NEVER;
+}
+
+// trace records due, returns the number of keys
+static unsigned int
+replay_trace( void )
+{
+    unsigned int keys = 0;
+
+    while ( trace_pos < trace_len && trace[trace_pos].at_us <= now_us )
+    {
+        trace_rec_t const *rec = &trace[trace_pos++];
+
+        if ( rec->kind == TRACE_KEY )
+        {
+            cnt.keys++;
+            keys++;
+            if ( kbd_len < KBD_BUF_SIZE )
+                kbd_buf[kbd_len++] = rec->value;
+            else
+                cnt.keys_dropped++;
+        }
+        else
+        {
+            uint64_t  day = rtc_sec(  ) / SECONDS_PER_DAY;
+
+            rtc_base_sec = day * SECONDS_PER_DAY + rec->value -
+                now_us / US_PER_SEC;
+            arm_alarm(  );
+        }
+    }
+
+    return keys;
+}
+
+// interrupts due, returns their number
+static unsigned int
+deliver( void )
+{
+    unsigned int irqs = replay_trace(  );       // Int 09h
+
+    while ( now_us >= next_tick_us )
+    {
+        next_tick_us += tick_period_us(  );
+        cnt.ticks++;
+        irqs++;
+        if ( isr[0x1c] )
+            isr[0x1c] (  );
+    }
+
+    if ( now_us >= alarm_due_us )
+    {
+        alarm_due_us += SECONDS_PER_DAY * US_PER_SEC;
+        cnt.alarms++;
+        irqs++;
+        if ( isr[0x4a] )
+            isr[0x4a] (  );
+    }
+
+    return irqs;
+}
+
+static uint64_t
+next_irq_us( void )
+{
+    uint64_t  t = next_tick_us;
+
+    if ( alarm_due_us < t )
+        t = alarm_due_us;
+    if ( next_trace_us(  ) < t )
+        t = next_trace_us(  );
+    if ( end_us < t )
+        t = end_us;
+    return t;
+}
+
+static void
+poweroff( void )
+{
+    cnt.poweroffs++;
+
+    // the RTC alarm or a key turns it on again
+    for ( ;; )
+    {
+        uint64_t  t = alarm_due_us;
+
+        if ( next_trace_us(  ) < t )
+            t = next_trace_us(  );
+        if ( end_us < t )
+            t = end_us;
+
+        cnt.off_us += t - now_us;
+        now_us = t;
+
+        if ( replay_trace(  ) || now_us >= alarm_due_us || now_us >= end_us )
+            break;
+    }
+
+    next_tick_us = now_us + tick_period_us(  );
+    deliver(  );
+}
+
+static void
+bios( int intno, regs_t & r )
+{
+    uint8_t   ah = r.ax >> 8;
+    uint8_t   al = r.ax & 0xff;
+    unsigned int i;
+
+    cnt.bios_calls++;
+    for ( i = 0; i < bios_fns_len; i++ )
+        if ( bios_fns[i].intno == intno && bios_fns[i].fn == ah )
+            break;
+    if ( i == bios_fns_len && bios_fns_len < BIOS_FNS_MAX )
+    {
+        bios_fns[bios_fns_len].intno = intno;
+        bios_fns[bios_fns_len++].fn = ah;
+    }
+    if ( i < bios_fns_len )
+        bios_fns[i].calls++;
+
+    r.cflag = 0;
+
+    if ( intno == 0x1a && ah == 0x02 )  // read RTC time
+    {
+        uint64_t  daysec = rtc_sec(  ) % SECONDS_PER_DAY;
+
+        r.cx = bcd( daysec / 3600 ) << 8 | bcd( daysec / 60 % 60 );
+        r.dx = bcd( daysec % 60 ) << 8;
+    }
+    else if ( intno == 0x1a && ah == 0x06 )     // set RTC alarm
+    {
+        alarm_daysec = unbcd( r.cx >> 8 ) * 3600 +
+            unbcd( r.cx & 0xff ) * 60 + unbcd( r.dx >> 8 );
+        alarm_set = 1;
+        arm_alarm(  );
+    }
+    else if ( intno == 0x1a && ah == 0x07 )     // reset RTC alarm
+    {
+        alarm_set = 0;
+        arm_alarm(  );
+    }
+    else if ( intno == 0x21 && ah == 0x09 )     // print string
+    {
+        if ( r.ds >= 1 && r.ds <= far_ptrs_len )
+        {
+            char const *s = ( char const * ) far_ptrs[r.ds - 1];
+
+            fwrite( s, 1, strcspn( s, "$" ), stdout );
+        }
+    }
+    else if ( intno == 0x21 && ah == 0x35 )     // get interrupt vector
+    {
+        r.es = al == 0x61 ? 0xf000 : 0;
+        r.bx = 0;
+    }
+    else if ( intno == 0x61 && ah == 0x1e )     // get / set clock tick speed
+    {
+        if ( al == 0 )
+            r.bx = clockspeed;
+        else if ( ( r.bx & 1 ) != clockspeed )
+        {
+            clockspeed = r.bx & 1;
+            next_tick_us = now_us + tick_period_us(  );
+        }
+    }
+    else if ( intno == 0x61 && ah == 0x2c )     // BIOS version
+        r.bx = BIOS_VER_OFFS;
+    else if ( intno == 0x61 && ah == 0x2d )     // turn system off
+        poweroff(  );
+}
+
+/*
+ * Borland runtime
+ */
+
+int
+int86( int intno, union REGS *in, union REGS *out )
+{
+    regs_t    r = { in->x.ax, in->x.bx, in->x.cx, in->x.dx, 0, 0, 0 };
+
+    bios( intno, r );
+    out->x.ax = r.ax;
+    out->x.bx = r.bx;
+    out->x.cx = r.cx;
+    out->x.dx = r.dx;
+    out->x.cflag = r.cflag;
+    return r.ax;
+}
+
+void
+intr( int intno, struct REGPACK *regpack )
+{
+    regs_t    r = { regpack->r_ax, regpack->r_bx, regpack->r_cx,
+        regpack->r_dx, regpack->r_ds, regpack->r_es, 0
+    };
+
+    bios( intno, r );
+    regpack->r_ax = r.ax;
+    regpack->r_bx = r.bx;
+    regpack->r_cx = r.cx;
+    regpack->r_dx = r.dx;
+    regpack->r_ds = r.ds;
+    regpack->r_es = r.es;
+    regpack->r_flags = r.cflag;
+}
+
+hostsim_isr_fp_t
+getvect( int intno )
+{
+    return isr[intno & 0xff];
+}
+
+void
+setvect( int intno, hostsim_isr_fp_t fp )
+{
+    isr[intno & 0xff] = fp;
+}
+
+void
+getdate( struct date *datep )
+{
+    int       y;
+    unsigned int m, d;
+
+    rtc_date( &y, &m, &d );
+    datep->da_year = y;
+    datep->da_mon = m;
+    datep->da_day = d;
+}
+
+void
+gettime( struct time *timep )
+{
+    uint64_t  daysec = rtc_sec(  ) % SECONDS_PER_DAY;
+
+    timep->ti_hour = daysec / 3600;
+    timep->ti_min = daysec / 60 % 60;
+    timep->ti_sec = daysec % 60;
+    timep->ti_hund = now_us / ( US_PER_SEC / 100 ) % 100;
+}
+
+void
+_dos_getdate( struct dosdate_t *datep )
+{
+    int       y;
+    unsigned int m, d;
+
+    rtc_date( &y, &m, &d );
+    datep->year = y;
+    datep->month = m;
+    datep->day = d;
+    datep->dayofweek = ( rtc_sec(  ) / SECONDS_PER_DAY + 2 ) % 7; // 1980-01-01 a Tuesday
+}
+
+void
+delay( unsigned int ms )
+{
+    cnt.awake_us += ms * US_PER_MS;
+    now_us += ms * US_PER_MS;
+    deliver(  );
+}
+
+void
+randomize( void )
+{
+    srand( seed );
+}
+
+unsigned char
+inportb( int port )
+{
+    if ( port == 0x40 )         // PIT counter 0, latched LSB then MSB
+    {
+        pit_read_msb ^= 1;
+        return pit_read_msb ? pit_latch & 0xff : pit_latch >> 8;
+    }
+    return 0xff;
+}
+
+void
+outportb( int port, unsigned char value )
+{
+    if ( port == 0x43 && value == 0x00 )        // latch counter 0
+    {
+        pit_latch = 0xffff - ( now_us * PIT_HZ / US_PER_SEC & 0xffff );
+        pit_read_msb = 0;
+    }
+    else if ( port == 0x8011 )  // LCD controller, register select
+        lcd_reg = value;
+    else if ( port == 0x8010 && lcd_reg == 0x0a )       // cursor address, low
+        lcd_addr_lo = value;
+    else if ( port == 0x8010 && lcd_reg == 0x0b )       // cursor address, high
+    {
+        unsigned int addr = lcd_addr_lo | value << 8;
+
+        // not the next row of a frame, whole rows or a column span
+        if ( addr != lcd_row + LCD_ROW_B )
+        {
+            cnt.frames++;
+            if ( addr != 0 )
+                cnt.frames_partial++;
+        }
+        lcd_cursor = addr;
+        lcd_row = addr;
+    }
+    else if ( port == 0x8010 && lcd_reg == 0x0c )       // write display data
+    {
+        lcd_mem[lcd_cursor++ % LCD_MEM_B] = value;
+        cnt.lcd_bytes++;
+    }
+    else if ( port == 0x8020 && value != 0 )    // tone generator
+        cnt.tones++;
+}
+
+void *
+hostsim_mk_fp( unsigned int seg, unsigned int offs )
+{
+    unsigned long linear = ( unsigned long ) seg * 16 + offs;
+
+    if ( linear >= VRAM_FIRST && linear < VRAM_END )
+        linear = VRAM_FIRST + ( linear - VRAM_FIRST ) % VRAM_MIRROR;
+
+    if ( linear < UMEM_FIRST || linear >= UMEM_FIRST + UMEM_SIZE )
+    {
+        fprintf( stderr, "hostsim: no memory at %04X:%04X\n", seg, offs );
+        exit( EXIT_FAILURE );
+    }
+    return umem + ( linear - UMEM_FIRST );
+}
+
+// far pointers handed to the BIOS, the segment is an index to a table
+unsigned short
+hostsim_fp_seg( void const *p )
+{
+    unsigned int i;
+
+    for ( i = 0; i < far_ptrs_len; i++ )
+        if ( far_ptrs[i] == p )
+            return i + 1;
+
+    if ( far_ptrs_len == FAR_PTRS_MAX )
+    {
+        fprintf( stderr, "hostsim: too many far pointers\n" );
+        exit( EXIT_FAILURE );
+    }
+    far_ptrs[far_ptrs_len++] = p;
+    return far_ptrs_len;
+}
+
+void
+hostsim_halt( void )
+{
+    if ( now_us >= end_us )
+        return;
+
+    cnt.halts++;
+
+    // a trace record setting the RTC is not an interrupt, sleep on
+    do
+    {
+        uint64_t  t = next_irq_us(  );
+
+        cnt.halted_us += t - now_us;
+        now_us = t;
+    }
+    while ( deliver(  ) == 0 && now_us < end_us );
+
+    cnt.wakeups++;
+}
+
+int
+kbhit( void )
+{
+    cnt.passes++;
+    cnt.awake_us += quantum_us;
+    now_us += quantum_us;
+    deliver(  );
+
+    return kbd_len > 0 || now_us >= end_us;
+}
+
+int
+getch( void )
+{
+    while ( kbd_len == 0 )
+    {
+        if ( now_us >= end_us )
+            return ESC_CHAR;
+        hostsim_halt(  );
+    }
+
+    int       c = kbd_buf[0];
+
+    memmove( kbd_buf, kbd_buf + 1, --kbd_len * sizeof kbd_buf[0] );
+    return c;
+}
+
+unsigned int
+_dos_open( char const *path, unsigned int flags, int *fd )
+{
+    *fd = open( path, flags & 3 );
+    return *fd < 0 ? 2 : 0;     // file not found
+}
+
+unsigned int
+_dos_creat( char const *path, unsigned int attrib, int *fd )
+{
+    ( void ) attrib;
+    *fd = open( path, O_RDWR | O_CREAT | O_TRUNC, 0644 );
+    return *fd < 0 ? 5 : 0;     // access denied
+}
+
+unsigned int
+_dos_read( int fd, void *buf, unsigned int len, unsigned int *nread )
+{
+    ssize_t   n = read( fd, buf, len );
+
+    *nread = n < 0 ? 0 : n;
+    return n < 0 ? 5 : 0;
+}
+
+unsigned int
+_dos_write( int fd, void const *buf, unsigned int len, unsigned int *written )
+{
+    ssize_t   n = write( fd, buf, len );
+
+    *written = n < 0 ? 0 : n;
+    return n < 0 ? 5 : 0;
+}
+
+unsigned int
+_dos_close( int fd )
+{
+    return close( fd ) == 0 ? 0 : 6;    // invalid handle
+}
+
+unsigned int
+_dos_getftime( int fd, unsigned int *dosdate, unsigned int *dostime )
+{
+    struct stat st;
+    struct tm *tm;
+
+    if ( fstat( fd, &st ) != 0 || ( tm = localtime( &st.st_mtime ) ) == NULL )
+        return 6;
+
+    *dosdate = ( tm->tm_year - 80 ) << 9 | ( tm->tm_mon + 1 ) << 5 | tm->tm_mday;
+    *dostime = tm->tm_hour << 11 | tm->tm_min << 5 | tm->tm_sec / 2;
+    return 0;
+}
+
+int
+filelength( int fd )
+{
+    struct stat st;
+
+    return fstat( fd, &st ) == 0 ? ( int ) st.st_size : -1;
+}
+
+/*
+ * Setup & report
+ */
+
+static void
+load_trace( char const *filename )
+{
+    FILE     *f = fopen( filename, "r" );
+    char      line[128];
+    unsigned int lineno = 0;
+    unsigned int cap = 0;
+
+    if ( !f )
+    {
+        perror( filename );
+        exit( EXIT_FAILURE );
+    }
+
+    while ( fgets( line, sizeof line, f ) )
+    {
+        char      at[16], kind[8], value[16];
+        unsigned long at_sec, sec;
+        trace_rec_t rec;
+
+        lineno++;
+        *strchrnul( line, '#' ) = '\0';
+
+        int       n = sscanf( line, "%15s %7s %15s", at, kind, value );
+
+        if ( n <= 0 )
+            continue;
+        if ( n != 3 || parse_hms( at, &at_sec ) != 0 )
+            goto bad_line;
+
+        rec.at_us = at_sec * US_PER_SEC;
+
+        if ( strcmp( kind, "key" ) == 0 )
+        {
+            rec.kind = TRACE_KEY;
+            if ( strcmp( value, "esc" ) == 0 )
+                rec.value = ESC_CHAR;
+            else if ( strcmp( value, "space" ) == 0 )
+                rec.value = SPACE_CHAR;
+            else if ( strlen( value ) == 1 )
+                rec.value = ( unsigned char ) value[0];
+            else
+                goto bad_line;
+        }
+        else if ( strcmp( kind, "rtc" ) == 0 )
+        {
+            if ( parse_hms( value, &sec ) != 0 || sec >= SECONDS_PER_DAY )
+                goto bad_line;
+            rec.kind = TRACE_RTC;
+            rec.value = sec;
+        }
+        else
+            goto bad_line;
+
+        if ( trace_len > 0 && rec.at_us < trace[trace_len - 1].at_us )
+            goto bad_line;      // out of order
+
+        if ( trace_len == cap )
+        {
+            cap = cap ? cap * 2 : 64;
+            trace = ( trace_rec_t * ) realloc( trace, cap * sizeof *trace );
+        }
+        trace[trace_len++] = rec;
+        continue;
+
+      bad_line:
+        fprintf( stderr, "%s:%u: bad trace record\n", filename, lineno );
+        exit( EXIT_FAILURE );
+    }
+
+    fclose( f );
+}
+
+static void
+write_pbm( char const *filename )
+{
+    FILE     *f = fopen( filename, "wb" );
+
+    if ( !f )
+    {
+        perror( filename );
+        return;
+    }
+
+    fprintf( f, "P4\n%d %d\n", LCD_WIDTH, LCD_HEIGHT );
+    for ( unsigned int i = 0; i < LCD_HEIGHT * LCD_ROW_B; i++ )
+    {
+        uint8_t   b = lcd_mem[i];
+        uint8_t   r = 0;
+
+        for ( unsigned int bit = 0; bit < 8; bit++ )    // LCD data is LSB first
+            r |= ( b >> bit & 1 ) << ( 7 - bit );
+        fputc( r, f );
+    }
+    fclose( f );
+}
+
+static int
+cmp_bios_fn( void const *a, void const *b )
+{
+    bios_fn_t const *x = ( bios_fn_t const * ) a;
+    bios_fn_t const *y = ( bios_fn_t const * ) b;
+
+    if ( x->intno != y->intno )
+        return x->intno - y->intno;
+    return x->fn - y->fn;
+}
+
+static void
+report( int exit_code, double wall_sec )
+{
+    char      b1[16], b2[16], b3[16];
+
+    printf( "hostsim: %s simulated in %.2f s",
+            fmt_hms( now_us, b1 ), wall_sec );
+    if ( wall_sec > 0 )
+        printf( ", %.0fx real time", now_us / ( wall_sec * US_PER_SEC ) );
+    printf( "\n" );
+
+    printf( "  exit code           %10d\n", exit_code );
+    printf( "  wakeups (hlt)       %10lu   halted %s\n",
+            cnt.wakeups, fmt_hms( cnt.halted_us, b1 ) );
+    printf( "  main loop passes    %10lu   awake %s\n",
+            cnt.passes, fmt_hms( cnt.awake_us, b2 ) );
+    printf( "  frames presented    %10lu   partial %lu, %lu LCD bytes\n",
+            cnt.frames, cnt.frames_partial, cnt.lcd_bytes );
+    printf( "  ticks (Int 1Ch)     %10lu\n", cnt.ticks );
+    printf( "  RTC alarms (Int 4Ah)%10lu\n", cnt.alarms );
+    printf( "  keys                %10lu   dropped %lu\n",
+            cnt.keys, cnt.keys_dropped );
+    printf( "  tones               %10lu\n", cnt.tones );
+    printf( "  power offs          %10lu   off %s\n",
+            cnt.poweroffs, fmt_hms( cnt.off_us, b3 ) );
+    printf( "  BIOS calls          %10lu\n", cnt.bios_calls );
+
+    qsort( bios_fns, bios_fns_len, sizeof bios_fns[0], cmp_bios_fn );
+    for ( unsigned int i = 0; i < bios_fns_len; i++ )
+        printf( "    Int %02Xh Fn %02Xh      %10lu\n",
+                bios_fns[i].intno, bios_fns[i].fn, bios_fns[i].calls );
+}
+
+static void
+usage( char const *argv0 )
+{
+    fprintf( stderr,
+             "usage: %s [-t <trace>] [-s <hh:mm:ss>] [-D <yyyy-mm-dd>] [-d <hours>]\n"
+             "          [-q <ms>] [-r <seed>] [-p <lcd.pbm>] [-- <program args>]\n",
+             argv0 );
+    exit( EXIT_FAILURE );
+}
+
+int
+main( int argc, char **argv )
+{
+    unsigned long start_sec = 0;
+    int       y = 2023;
+    unsigned int m = 1, d = 2;
+    int       opt;
+
+    while ( ( opt = getopt( argc, argv, "t:s:D:d:q:r:p:" ) ) != -1 )
+    {
+        switch ( opt )
+        {
+        case 't':
+            load_trace( optarg );
+            break;
+        case 's':
+            if ( parse_hms( optarg, &start_sec ) != 0
+                 || start_sec >= SECONDS_PER_DAY )
+                usage( argv[0] );
+            break;
+        case 'D':
+            if ( sscanf( optarg, "%d-%u-%u", &y, &m, &d ) != 3 || y < 1980 )
+                usage( argv[0] );
+            break;
+        case 'd':
+            end_us = ( uint64_t ) ( atof( optarg ) * 3600 * US_PER_SEC );
+            break;
+        case 'q':
+            quantum_us = ( uint64_t ) ( atof( optarg ) * US_PER_MS );
+            break;
+        case 'r':
+            seed = strtoul( optarg, NULL, 0 );
+            break;
+        case 'p':
+            pbm_filename = optarg;
+            break;
+        default:
+            usage( argv[0] );
+        }
+    }
+
+    rtc_base_sec = ( days_from_civil( y, m, d ) - DAYS_1970_TO_1980 ) *
+        SECONDS_PER_DAY + start_sec;
+    next_tick_us = tick_period_us(  );
+    memcpy( hostsim_mk_fp( BIOS_VER_SEG, BIOS_VER_OFFS ), "1.052", 5 );
+
+    // the program's own arguments after '--'
+    argv[optind - 1] = ( char * ) "PFWALLCL.EXE";
+
+    struct timespec t0, t1;
+
+    clock_gettime( CLOCK_MONOTONIC, &t0 );
+    int       exit_code = pfwallcl_main( argc - optind + 1, argv + optind - 1 );
+    clock_gettime( CLOCK_MONOTONIC, &t1 );
+
+    fflush( stdout );
+    report( exit_code, t1.tv_sec - t0.tv_sec + ( t1.tv_nsec - t0.tv_nsec ) / 1e9 );
+
+    if ( pbm_filename )
+        write_pbm( pbm_filename );
+
+    return exit_code;
+}
@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Hosted simulation, program side hooks (built with HOSTSIM)
+ */
+
+#ifndef _HOSTSIM_H
+#define _HOSTSIM_H 1
+
+// hlt, sleeps on the virtual clock until the next interrupt
+void hostsim_halt( void );
+
+#endif
@@ -0,0 +1,19 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Borland <conio.h> subset of the hosted simulation, the keyboard
+ * is replayed from the trace
+ */
+
+#ifndef _HOSTSIM_CONIO_H
+#define _HOSTSIM_CONIO_H 1
+
+int kbhit( void );
+int getch( void );
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Borland <dos.h> subset of the hosted simulation, backed by the
+ * simulated machine in hostsim.cpp. Registers are 16 bits wide,
+ * no 'long' here, it is 32 bits wide in the program only.
+ */
+
+#ifndef _HOSTSIM_DOS_H
+#define _HOSTSIM_DOS_H 1
+
+struct WORDREGS
+{
+    unsigned short ax, bx, cx, dx, si, di, cflag, flags;
+};
+
+struct BYTEREGS
+{
+    unsigned char al, ah, bl, bh, cl, ch, dl, dh;
+};
+
+union REGS
+{
+    struct WORDREGS x;
+    struct BYTEREGS h;
+};
+
+struct REGPACK
+{
+    unsigned short r_ax, r_bx, r_cx, r_dx, r_bp, r_si, r_di, r_ds, r_es,
+        r_flags;
+};
+
+struct date
+{
+    int da_year;
+    char da_day;
+    char da_mon;
+};
+
+struct time
+{
+    unsigned char ti_min, ti_hour, ti_hund, ti_sec;
+};
+
+struct dosdate_t
+{
+    unsigned char day, month;
+    unsigned int year;
+    unsigned char dayofweek;
+};
+
+typedef void ( *hostsim_isr_fp_t ) ( ... );
+
+int int86( int, union REGS *, union REGS * );
+void intr( int, struct REGPACK * );
+hostsim_isr_fp_t getvect( int );
+void setvect( int, hostsim_isr_fp_t );
+
+void getdate( struct date * );
+void gettime( struct time * );
+void _dos_getdate( struct dosdate_t * );
+void delay( unsigned int );
+
+unsigned char inportb( int );
+void outportb( int, unsigned char );
+
+// real mode memory, segments A000h..FFFFh only
+void *hostsim_mk_fp( unsigned int, unsigned int );
+unsigned short hostsim_fp_seg( void const * );
+
+#define MK_FP( seg, offs ) hostsim_mk_fp( ( seg ), ( offs ) )
+#define FP_SEG( p ) hostsim_fp_seg( p )
+#define FP_OFF( p ) 0
+
+#define _A_NORMAL 0
+
+unsigned int _dos_open( char const *, unsigned int, int * );
+unsigned int _dos_creat( char const *, unsigned int, int * );
+unsigned int _dos_read( int, void *, unsigned int, unsigned int * );
+unsigned int _dos_write( int, void const *, unsigned int, unsigned int * );
+unsigned int _dos_close( int );
+unsigned int _dos_getftime( int, unsigned int *, unsigned int * );
+
+#endif
@@ -0,0 +1,19 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Borland <io.h> subset of the hosted simulation, files are host files
+ */
+
+#ifndef _HOSTSIM_IO_H
+#define _HOSTSIM_IO_H 1
+
+#include <unistd.h>
+
+int filelength( int );
+
+#endif
@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Borland <mem.h> subset of the hosted simulation, all pointers are near
+ */
+
+#ifndef _HOSTSIM_MEM_H
+#define _HOSTSIM_MEM_H 1
+
+#include <string.h>
+
+#define _fmemcpy memcpy
+#define _fmemset memset
+#define _fmemcmp memcmp
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Forced include of every program source in the hosted simulation.
+ *
+ * The program assumes Borland's 16-bit int and 32-bit long, the host
+ * has 32-bit int and 64-bit long. Structures laid over memory use word_t
+ * (common.h), the fixed point and time arithmetic needs 'long' to be
+ * 32 bits: it is redefined to int, after every system header the program
+ * uses has been seen.
+ */
+
+#ifndef _HOSTSIM_PRELUDE_H
+#define _HOSTSIM_PRELUDE_H 1
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+#include <assert.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define far
+#define near
+#define huge
+#define interrupt
+#define _Cdecl
+
+#define long int
+
+#define O_BINARY 0
+
+void randomize( void );
+
+inline int
+strcmpi( char const *s1, char const *s2 )
+{
+    return strcasecmp( s1, s2 );
+}
+
+inline int
+strnicmp( char const *s1, char const *s2, size_t n )
+{
+    return strncasecmp( s1, s2, n );
+}
+
+inline char *
+ultoa( unsigned long value, char *s, int radix )
+{
+    char      digits[32];
+    int       n = 0;
+    int       i = 0;
+
+    do
+    {
+        digits[n++] = "0123456789abcdefghijklmnopqrstuvwxyz"[value % radix];
+        value /= radix;
+    }
+    while ( value );
+
+    while ( n )
+        s[i++] = digits[--n];
+    s[i] = '\0';
+
+    return s;
+}
+
+#endif
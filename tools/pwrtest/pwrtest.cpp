@@ -0,0 +1,562 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Host-side sweep test of the power on / off schedule (src/pwrsched.cpp).
+ *
+ * Daily sweep: every minute of the day is simulated for each combination
+ * of power on, power off and kbhit delay settings on the grid.
+ * Weekly sweep: random weekday windows and date exceptions, every minute
+ * of a week or more is simulated.
+ * Results are compared against a reference model built from
+ * a minute-by-minute timeline. The sweeps are split across threads.
+ *
+ * Build & run:
+ *   g++ -O2 -pthread -I../../src -o pwrtest pwrtest.cpp ../../src/pwrsched.cpp
+ *   ./pwrtest [-s <pon_poff_step>] [-k <kbhit_step>] [-n <weekly_configs>]
+ *             [-j <threads>]
+ *
+ * -s 1 -k 1 sweeps the daily settings at 1 minute resolution (long running).
+ */
+
+#include "pwrsched.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define DEFAULT_STEP 15
+#define DEFAULT_KBHIT_STEP 30
+#define DEFAULT_WEEKLY_CONFIGS 1000
+#define NEAR_MINUTES 16         // dense grid near pon, poff and zero delay
+#define MAX_REPORTED 10
+
+#define HORIZON_MINUTES ( PWRSCHED_HORIZON_DAYS * MINUTES_PER_DAY )
+#define WEEKLY_NOW_DAYS 8       // simulated days of a weekly config
+#define WEEKLY_SPAN_DAYS ( WEEKLY_NOW_DAYS + PWRSCHED_HORIZON_DAYS + 2 )
+#define WEEKLY_SPAN_MINUTES ( WEEKLY_SPAN_DAYS * MINUTES_PER_DAY )
+
+static const int weekly_kbhit_delays[] =
+    { PWRSCHED_UNSET, 0, 3, 5, 30, 240, MINUTES_PER_DAY };
+
+#define NWEEKLY_KBHIT_DELAYS \
+    ( int ) ( sizeof( weekly_kbhit_delays ) / sizeof( weekly_kbhit_delays[0] ) )
+
+struct sweep_t
+{
+    int      *settings;         // PWRSCHED_UNSET first
+    int       nsettings;
+    int      *deltas;           // poff relative to pon
+    int       ndeltas;
+    int      *kbhit_delays;
+    int       nkbhit_delays;
+    int       nweekly;
+    int       next_job;         // work distribution, under lock
+    unsigned long long nchecked;
+    unsigned long long nfailed;
+    pthread_mutex_t lock;
+};
+
+// reference timeline state at a simulated minute
+struct point_t
+{
+    int       on_now;
+    int       to_on;            // -1 none within the horizon
+    int       to_off;
+};
+
+/*
+ * Reference rules, as documented:
+ * - In the on period, power off at the power off time.
+ * - If the kbhit delay runs past the power off time, the on period is
+ *   being left, power off at the power off time.
+ * - If the kbhit delay reaches the power on time, the on period is being
+ *   entered, power off at the power off time, or kbhit delay after
+ *   the power on time when there is none.
+ * - Otherwise power off after the kbhit delay.
+ * Power off time is never sooner than the minimal kbhit delay, if there's
+ * none within the horizon, at the horizon.
+ */
+static unsigned int
+reference_delay( const struct point_t *p, int kbhit )
+{
+    int       delay = kbhit == PWRSCHED_UNSET ?
+        DEFAULT_POFF_DELAY_ONKBHIT_MINUTES : kbhit;
+    int       at_poff = p->to_off < 0 ? HORIZON_MINUTES :
+        MAX( p->to_off, MIN_POFF_DELAY_ONKBHIT_MINUTES );
+
+    if ( p->on_now )
+        return at_poff;
+
+    if ( p->to_off > 0 && p->to_off < delay )
+        return at_poff;
+
+    if ( p->to_on >= 0 && p->to_on < delay )
+        return p->to_off >= 0 ? at_poff : p->to_on + delay;
+
+    return delay;
+}
+
+static void
+report_failure( struct sweep_t *sweep, unsigned long long nfailed,
+                const char *what, int day, int now,
+                unsigned int expected, unsigned int got )
+{
+    pthread_mutex_lock( &sweep->lock );
+    if ( sweep->nfailed + nfailed < MAX_REPORTED )
+        printf( "FAIL: %s day %d now %d: expected %u, got %u\n",
+                what, day, now, expected, got );
+    pthread_mutex_unlock( &sweep->lock );
+}
+
+/*
+ * Daily sweep
+ */
+
+// distance to the next daily occurence, walking two days backwards
+static void
+next_occurence( int *to, int at )
+{
+    for ( int m = 0; m < MINUTES_PER_DAY; m++ )
+        to[m] = -1;
+
+    if ( at == PWRSCHED_UNSET )
+        return;
+
+    int       distance = -1;
+
+    for ( int t = 2 * MINUTES_PER_DAY - 1; t >= 0; t-- )
+    {
+        if ( t % MINUTES_PER_DAY == at )
+            distance = 0;
+        else if ( distance >= 0 )
+            distance++;
+
+        if ( t < MINUTES_PER_DAY )
+            to[t] = distance;
+    }
+}
+
+static void
+check_daily( struct sweep_t *sweep, int pon, int poff,
+             unsigned long long *nchecked, unsigned long long *nfailed )
+{
+    static const int day = 0;
+    unsigned char on[MINUTES_PER_DAY];
+    int       to_pon[MINUTES_PER_DAY];
+    int       to_poff[MINUTES_PER_DAY];
+    PwrSched  pwrsched;
+
+    pwrsched.set_daily( pon, poff );
+    pwrsched.compile(  );
+
+    // powered on from pon until poff, not across
+    memset( on, 0, sizeof( on ) );
+    if ( pon != PWRSCHED_UNSET && poff != PWRSCHED_UNSET )
+        for ( int m = pon; m != poff; m = ( m + 1 ) % MINUTES_PER_DAY )
+            on[m] = 1;
+
+    next_occurence( to_pon, pon );
+    next_occurence( to_poff, poff );
+
+    for ( int now = 0; now < MINUTES_PER_DAY; now++ )
+    {
+        struct point_t p = { on[now], to_pon[now], to_poff[now] };
+        PwrSched::lookup_t lookup;
+
+        pwrsched.lookup( day, now, &lookup );
+
+        for ( int k = 0; k < sweep->nkbhit_delays; k++ )
+        {
+            int       kbhit = sweep->kbhit_delays[k];
+            unsigned int expected = reference_delay( &p, kbhit );
+            unsigned int got = PwrSched::poweroff_delay_min( &lookup, kbhit );
+
+            ( *nchecked )++;
+
+            if ( got == expected )
+                continue;
+
+            char      what[64];
+
+            snprintf( what, sizeof( what ), "pon %d poff %d kbhit %d",
+                      pon, poff, kbhit );
+            report_failure( sweep, *nfailed, what, day, now, expected, got );
+            ( *nfailed )++;
+        }
+    }
+}
+
+static void
+sweep_daily( struct sweep_t *sweep, int i,
+             unsigned long long *nchecked, unsigned long long *nfailed )
+{
+    int       pon = sweep->settings[i];
+
+    // poff unset, then at the deltas from pon (or on the grid)
+    for ( int j = -1; j < sweep->ndeltas; j++ )
+    {
+        int       poff;
+
+        if ( j < 0 )
+            poff = PWRSCHED_UNSET;
+        else if ( pon == PWRSCHED_UNSET )
+        {
+            if ( j >= sweep->nsettings - 1 )
+                break;
+            poff = sweep->settings[j + 1];
+        }
+        else
+            poff = ( pon + sweep->deltas[j] ) % MINUTES_PER_DAY;
+
+        check_daily( sweep, pon, poff, nchecked, nfailed );
+    }
+}
+
+/*
+ * Weekly sweep
+ */
+
+static unsigned int
+next_random( unsigned int *state )
+{
+    *state = *state * 1103515245u + 12345u;
+    return *state >> 16 & 0x7fff;
+}
+
+struct weekly_t
+{
+    int       nwindows;
+    int       day_mask[6];
+    int       on[6];
+    int       off[6];
+    int       nexceptions;
+    int       exception_day[4];
+    int       nexception_windows;
+    int       exception_of[6];
+    int       exception_on[6];
+    int       exception_off[6];
+};
+
+static int
+find_exception( const struct weekly_t *w, int day )
+{
+    for ( int e = 0; e < w->nexceptions; e++ )
+        if ( w->exception_day[e] == day )
+            return e;
+
+    return -1;
+}
+
+static void
+paint( unsigned char *on, int from, int to )
+{
+    for ( int t = MAX( from, 0 ); t < MIN( to, WEEKLY_SPAN_MINUTES ); t++ )
+        on[t] = 1;
+}
+
+static void
+check_weekly( struct sweep_t *sweep, unsigned int seed,
+              unsigned long long *nchecked, unsigned long long *nfailed )
+{
+    unsigned int rnd = seed;
+    struct weekly_t w;
+    PwrSched  pwrsched;
+    int       first_day = 1 + next_random( &rnd ) % 20000;
+
+    memset( &w, 0, sizeof( w ) );
+
+    w.nwindows = next_random( &rnd ) % 6;
+    for ( int i = 0; i < w.nwindows; i++ )
+    {
+        w.day_mask[i] = 1 + next_random( &rnd ) % PWRSCHED_ALL_DAYS;
+        w.on[i] = next_random( &rnd ) % MINUTES_PER_DAY;
+        do
+            w.off[i] = next_random( &rnd ) % MINUTES_PER_DAY;
+        while ( w.off[i] == w.on[i] );
+        pwrsched.add_week_window( w.day_mask[i], w.on[i], w.off[i] );
+    }
+
+    // exceptions, some on consecutive days
+    w.nexceptions = next_random( &rnd ) % 4;
+    for ( int e = 0; e < w.nexceptions; e++ )
+    {
+        int       day;
+
+        do
+            day = first_day + next_random( &rnd ) % WEEKLY_NOW_DAYS;
+        while ( find_exception( &w, day ) >= 0 );
+
+        w.exception_day[e] = day;
+        pwrsched.add_exception( day );
+
+        for ( int n = next_random( &rnd ) % 3;
+              n > 0 && w.nexception_windows < 6; n-- )
+        {
+            int       i = w.nexception_windows++;
+            int       a = next_random( &rnd ) % MINUTES_PER_DAY;
+            int       b = next_random( &rnd ) % MINUTES_PER_DAY;
+
+            if ( a == b )
+                b = ( a + 1 ) % MINUTES_PER_DAY;
+
+            w.exception_of[i] = e;
+            w.exception_on[i] = MIN( a, b );
+            w.exception_off[i] = MAX( a, b );
+            pwrsched.add_exception_window( day, w.exception_on[i],
+                                           w.exception_off[i] );
+        }
+    }
+
+    if ( pwrsched.compile(  ) == RET_FAILURE )
+    {
+        report_failure( sweep, *nfailed, "compile", first_day, 0, 0, 0 );
+        ( *nfailed )++;
+        return;
+    }
+
+    // timeline from the day before the first one, paint each day's windows
+    static __thread unsigned char on[WEEKLY_SPAN_MINUTES];
+    int       span_first_day = first_day - 1;
+
+    memset( on, 0, sizeof( on ) );
+
+    for ( int d = 0; d < WEEKLY_SPAN_DAYS; d++ )
+    {
+        int       day = span_first_day + d;
+        int       e = find_exception( &w, day );
+        int       base = d * MINUTES_PER_DAY;
+
+        if ( e >= 0 )
+        {
+            for ( int i = 0; i < w.nexception_windows; i++ )
+                if ( w.exception_of[i] == e )
+                    paint( on, base + w.exception_on[i],
+                           base + w.exception_off[i] );
+            continue;
+        }
+
+        for ( int i = 0; i < w.nwindows; i++ )
+            if ( w.day_mask[i] & 1 << PwrSched::weekday( day ) )
+                paint( on, base + w.on[i],
+                       base + w.off[i] + ( w.off[i] <= w.on[i] ?
+                                           MINUTES_PER_DAY : 0 ) );
+    }
+
+    // walking backwards, distance to the next edge
+    static __thread int to_on[WEEKLY_SPAN_MINUTES];
+    static __thread int to_off[WEEKLY_SPAN_MINUTES];
+    int       next_on = -1, next_off = -1;
+
+    for ( int t = WEEKLY_SPAN_MINUTES - 1; t >= 1; t-- )
+    {
+        if ( on[t] && !on[t - 1] )
+            next_on = t;
+        if ( !on[t] && on[t - 1] )
+            next_off = t;
+
+        to_on[t] = next_on >= 0 && next_on - t < HORIZON_MINUTES ?
+            next_on - t : -1;
+        to_off[t] = next_off >= 0 && next_off - t < HORIZON_MINUTES ?
+            next_off - t : -1;
+    }
+
+    for ( int t = MINUTES_PER_DAY;
+          t < ( 1 + WEEKLY_NOW_DAYS ) * MINUTES_PER_DAY; t++ )
+    {
+        struct point_t p = { on[t], to_on[t], to_off[t] };
+        PwrSched::lookup_t got;
+        int       day = span_first_day + t / MINUTES_PER_DAY;
+        int       now = t % MINUTES_PER_DAY;
+        char      what[64];
+
+        pwrsched.lookup( day, now, &got );
+        ( *nchecked )++;
+
+        if ( ( got.on_now != 0 ) != ( p.on_now != 0 )
+             || got.to_on != p.to_on || got.to_off != p.to_off )
+        {
+            snprintf( what, sizeof( what ),
+                      "seed %u lookup on/to_on/to_off %d/%d/%d", seed,
+                      got.on_now, got.to_on, got.to_off );
+            report_failure( sweep, *nfailed, what, day, now,
+                            p.on_now * 100000 + p.to_on, p.to_off );
+            ( *nfailed )++;
+            continue;
+        }
+
+        for ( int k = 0; k < NWEEKLY_KBHIT_DELAYS; k++ )
+        {
+            int       kbhit = weekly_kbhit_delays[k];
+            unsigned int expected = reference_delay( &p, kbhit );
+            unsigned int delay = PwrSched::poweroff_delay_min( &got, kbhit );
+
+            ( *nchecked )++;
+
+            if ( delay == expected )
+                continue;
+
+            snprintf( what, sizeof( what ), "seed %u kbhit %d", seed, kbhit );
+            report_failure( sweep, *nfailed, what, day, now, expected, delay );
+            ( *nfailed )++;
+        }
+    }
+}
+
+static void *
+sweep_thread( void *arg )
+{
+    struct sweep_t *sweep = ( struct sweep_t * ) arg;
+    unsigned long long nchecked = 0, nfailed = 0;
+
+    for ( ;; )
+    {
+        pthread_mutex_lock( &sweep->lock );
+        int       job = sweep->next_job++;
+        pthread_mutex_unlock( &sweep->lock );
+
+        if ( job < sweep->nsettings )
+            sweep_daily( sweep, job, &nchecked, &nfailed );
+        else if ( job < sweep->nsettings + sweep->nweekly )
+            check_weekly( sweep, job - sweep->nsettings + 1, &nchecked,
+                          &nfailed );
+        else
+            break;
+    }
+
+    pthread_mutex_lock( &sweep->lock );
+    sweep->nchecked += nchecked;
+    sweep->nfailed += nfailed;
+    pthread_mutex_unlock( &sweep->lock );
+
+    return NULL;
+}
+
+// 0..NEAR_MINUTES, then the multiples of step up to limit
+static int
+make_grid( int *grid, int step, int limit )
+{
+    int       n = 0;
+
+    for ( int m = 0; m <= limit; m++ )
+        if ( m <= NEAR_MINUTES || m % step == 0 )
+            grid[n++] = m;
+
+    return n;
+}
+
+void
+print_usage( char *prog_name )
+{
+    printf( "Usage: %s [-s <pon_poff_step>] [-k <kbhit_step>] "
+            "[-n <weekly_configs>] [-j <threads>]\n", prog_name );
+}
+
+int
+main( int argc, char **argv )
+{
+    int       step = DEFAULT_STEP;
+    int       kbhit_step = DEFAULT_KBHIT_STEP;
+    int       nweekly = DEFAULT_WEEKLY_CONFIGS;
+    long      nthreads = sysconf( _SC_NPROCESSORS_ONLN );
+    int       opt;
+
+    while ( ( opt = getopt( argc, argv, "s:k:n:j:" ) ) != -1 )
+    {
+        if ( opt == 's' )
+            step = atoi( optarg );
+        else if ( opt == 'k' )
+            kbhit_step = atoi( optarg );
+        else if ( opt == 'n' )
+            nweekly = atoi( optarg );
+        else if ( opt == 'j' )
+            nthreads = atol( optarg );
+        else
+        {
+            print_usage( argv[0] );
+            return EXIT_FAILURE;
+        }
+    }
+
+    if ( step <= 0 || kbhit_step <= 0 || nweekly < 0 )
+    {
+        print_usage( argv[0] );
+        return EXIT_FAILURE;
+    }
+
+    if ( nthreads < 1 )
+        nthreads = 1;
+
+    struct sweep_t sweep;
+    int       grid[MINUTES_PER_DAY + 1];
+    int       ngrid;
+
+    memset( &sweep, 0, sizeof( sweep ) );
+    pthread_mutex_init( &sweep.lock, NULL );
+    sweep.nweekly = nweekly;
+
+    sweep.settings = ( int * ) malloc( ( MINUTES_PER_DAY + 1 ) * sizeof( int ) );
+    sweep.deltas = ( int * ) malloc( MINUTES_PER_DAY * sizeof( int ) );
+    sweep.kbhit_delays =
+        ( int * ) malloc( ( MINUTES_PER_DAY + 2 ) * sizeof( int ) );
+
+    if ( !sweep.settings || !sweep.deltas || !sweep.kbhit_delays )
+    {
+        perror( "malloc" );
+        return EXIT_FAILURE;
+    }
+
+    // pon: unset and on the step grid
+    sweep.settings[sweep.nsettings++] = PWRSCHED_UNSET;
+    for ( int m = 0; m < MINUTES_PER_DAY; m += step )
+        sweep.settings[sweep.nsettings++] = m;
+
+    // poff: near pon and on the step grid relative to it
+    sweep.ndeltas = make_grid( sweep.deltas, step, MINUTES_PER_DAY - 1 );
+
+    // kbhit delay: unset, short ones and on the kbhit grid, 24:00 incl.
+    ngrid = make_grid( grid, kbhit_step, MINUTES_PER_DAY );
+    sweep.kbhit_delays[sweep.nkbhit_delays++] = PWRSCHED_UNSET;
+    memcpy( sweep.kbhit_delays + 1, grid, ngrid * sizeof( int ) );
+    sweep.nkbhit_delays += ngrid;
+
+    printf( "Sweeping %d pon x %d poff x %d kbhit delay daily settings, "
+            "%d weekly configs, %ld thread(s)...\n",
+            sweep.nsettings, sweep.ndeltas + 1, sweep.nkbhit_delays,
+            sweep.nweekly, nthreads );
+
+    pthread_t *threads =
+        ( pthread_t * ) malloc( nthreads * sizeof( pthread_t ) );
+
+    if ( threads == NULL )
+    {
+        perror( "malloc" );
+        return EXIT_FAILURE;
+    }
+
+    for ( long t = 0; t < nthreads; t++ )
+        if ( pthread_create( &threads[t], NULL, sweep_thread, &sweep ) )
+        {
+            perror( "pthread_create" );
+            return EXIT_FAILURE;
+        }
+
+    for ( long t = 0; t < nthreads; t++ )
+        pthread_join( threads[t], NULL );
+
+    printf( "%llu checked, %llu failed -> %s.\n",
+            sweep.nchecked, sweep.nfailed, sweep.nfailed ? "FAIL" : "OK" );
+
+    free( threads );
+    free( sweep.kbhit_delays );
+    free( sweep.deltas );
+    free( sweep.settings );
+
+    return sweep.nfailed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2023 Vladimir Chren
+ * All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/*
+ * Summarise pfwallcl wakeup telemetry log (PFWALLCL.TLM),
+ * see src/tlmlog.h for the file layout.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TLM_FILE_MAGIC 0x4C54
+#define TLM_FILE_VERSION 1
+#define TLM_RECORD_SIZE 12
+#define TLM_HEADER_SIZE 4
+
+#define SRC_TICK 0x01
+#define SRC_RTC_ALARM 0x02
+#define SRC_KEY 0x04
+#define SRC_RUN 0x80
+
+#define WORK_TONE 0x40
+
+#define DEFAULT_PIT_HZ 1193182.0
+#define SECONDS_PER_DAY 86400L
+#define HOURS_PER_DAY 24
+
+struct record_t
+{
+    uint8_t   source;
+    uint8_t   work;
+    uint16_t  events;
+    uint32_t  timestamp_sec;
+    uint32_t  awake_pit;
+};
+
+struct hour_sum_t
+{
+    unsigned long wakeups;
+    unsigned long src_tick;
+    unsigned long src_rtc_alarm;
+    unsigned long src_key;
+    double    awake_sec;
+    double    span_sec;         // of the log, falling in this hour of day
+};
+
+static uint16_t
+get_u16( const uint8_t *p )
+{
+    return p[0] | p[1] << 8;
+}
+
+static uint32_t
+get_u32( const uint8_t *p )
+{
+    return ( uint32_t ) get_u16( p ) | ( uint32_t ) get_u16( p + 2 ) << 16;
+}
+
+// days since 1980-01-01 of a DOS packed date
+static long
+dosdate_to_days( uint32_t dosdate )
+{
+    long      y = 1980 + ( dosdate >> 9 & 0x7f );
+    long      m = dosdate >> 5 & 0x0f;
+    long      d = dosdate & 0x1f;
+
+    // days from civil, H. Hinnant's algorithm
+    y -= m <= 2;
+    long      era = y / 400;
+    long      yoe = y - era * 400;
+    long      doy = ( 153 * ( m + ( m > 2 ? -3 : 9 ) ) + 2 ) / 5 + d - 1;
+    long      doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + doe - 723120;        // 723120: 1980-01-01
+}
+
+void
+print_usage( char *prog_name )
+{
+    printf( "Usage: %s [-f <pit_hz>] <tlm_file>\n", prog_name );
+}
+
+int
+main( int argc, char **argv )
+{
+    double    pit_hz = DEFAULT_PIT_HZ;
+    int       opt;
+
+    while ( ( opt = getopt( argc, argv, "f:" ) ) != -1 )
+    {
+        if ( opt == 'f' )
+            pit_hz = atof( optarg );
+        else
+        {
+            print_usage( argv[0] );
+            return EXIT_FAILURE;
+        }
+    }
+
+    if ( optind >= argc || pit_hz <= 0 )
+    {
+        print_usage( argv[0] );
+        return EXIT_FAILURE;
+    }
+
+    FILE     *inpf = fopen( argv[optind], "rb" );
+    if ( inpf == NULL )
+    {
+        perror( "open input file" );
+        return EXIT_FAILURE;
+    }
+
+    uint8_t   header[TLM_HEADER_SIZE];
+
+    if ( fread( header, sizeof( header ), 1, inpf ) != 1 )
+    {
+        fprintf( stderr, "err: read file header\n" );
+        return EXIT_FAILURE;
+    }
+
+    if ( get_u16( header ) != TLM_FILE_MAGIC ||
+         header[2] != TLM_FILE_VERSION || header[3] != TLM_RECORD_SIZE )
+    {
+        fprintf( stderr, "err: not a telemetry log, or unknown version\n" );
+        return EXIT_FAILURE;
+    }
+
+    // Read in all the records, absolute time in hours since 1980
+    size_t    nrecords = 0, records_cap = 0;
+    struct record_t *records = NULL;
+    long     *abs_sec = NULL;
+    long      run_day = 0;
+    unsigned long nruns = 0;
+    uint8_t   buf[TLM_RECORD_SIZE];
+
+    while ( fread( buf, sizeof( buf ), 1, inpf ) == 1 )
+    {
+        if ( nrecords == records_cap )
+        {
+            records_cap = records_cap ? records_cap * 2 : 1024;
+            records = realloc( records, records_cap * sizeof( *records ) );
+            abs_sec = realloc( abs_sec, records_cap * sizeof( *abs_sec ) );
+            if ( records == NULL || abs_sec == NULL )
+            {
+                perror( "realloc" );
+                return EXIT_FAILURE;
+            }
+        }
+
+        struct record_t *r = &records[nrecords];
+
+        r->source = buf[0];
+        r->work = buf[1];
+        r->events = get_u16( buf + 2 );
+        r->timestamp_sec = get_u32( buf + 4 );
+        r->awake_pit = get_u32( buf + 8 );
+
+        if ( r->source & SRC_RUN )
+        {
+            // scheduler epoch is midnight of the run's first day
+            run_day = dosdate_to_days( r->awake_pit );
+            nruns++;
+            continue;
+        }
+
+        abs_sec[nrecords] = run_day * SECONDS_PER_DAY + r->timestamp_sec;
+        nrecords++;
+    }
+
+    fclose( inpf );
+
+    if ( nrecords == 0 )
+    {
+        printf( "No wake records.\n" );
+        return EXIT_SUCCESS;
+    }
+
+    /*
+     * Rates are per hour of the log's span, first to last wake, quiet
+     * hours and the time powered off included: hours with no wake at
+     * all would otherwise drop out and inflate them.
+     */
+    long      first_sec = abs_sec[0], last_sec = first_sec;
+
+    for ( size_t i = 0; i < nrecords; i++ )
+    {
+        if ( abs_sec[i] < first_sec )
+            first_sec = abs_sec[i];
+        if ( abs_sec[i] > last_sec )
+            last_sec = abs_sec[i];
+    }
+    last_sec++;                 // through the last wake's second
+
+    struct hour_sum_t sums[HOURS_PER_DAY];
+    struct hour_sum_t total;
+    unsigned long tone_wakeups = 0;
+    double    tone_awake_sec = 0;
+
+    memset( sums, 0, sizeof( sums ) );
+    memset( &total, 0, sizeof( total ) );
+
+    for ( long h = first_sec / 3600; h <= ( last_sec - 1 ) / 3600; h++ )
+    {
+        long      from = h * 3600 > first_sec ? h * 3600 : first_sec;
+        long      to = ( h + 1 ) * 3600 < last_sec ? ( h + 1 ) * 3600 : last_sec;
+
+        sums[h % HOURS_PER_DAY].span_sec += to - from;
+        total.span_sec += to - from;
+    }
+
+    for ( size_t i = 0; i < nrecords; i++ )
+    {
+        long      h = abs_sec[i] / 3600;
+        struct hour_sum_t *s = &sums[h % HOURS_PER_DAY];
+        double    awake_sec = records[i].awake_pit / pit_hz;
+
+        s->wakeups++;
+        s->awake_sec += awake_sec;
+        s->src_tick += ( records[i].source & SRC_TICK ) != 0;
+        s->src_rtc_alarm += ( records[i].source & SRC_RTC_ALARM ) != 0;
+        s->src_key += ( records[i].source & SRC_KEY ) != 0;
+
+        total.wakeups++;
+        total.awake_sec += awake_sec;
+        total.src_tick += ( records[i].source & SRC_TICK ) != 0;
+        total.src_rtc_alarm += ( records[i].source & SRC_RTC_ALARM ) != 0;
+        total.src_key += ( records[i].source & SRC_KEY ) != 0;
+
+        if ( records[i].work & WORK_TONE )
+        {
+            tone_wakeups++;
+            tone_awake_sec += awake_sec;
+        }
+    }
+
+    // Write out the summary
+    printf( "%lu wake records, %lu run(s)\n\n", ( unsigned long ) nrecords,
+            nruns );
+    printf( "hour  hours  wakeups/h  awake s/h   duty %%"
+            "     tick      rtc      key\n" );
+
+    for ( int h = 0; h < HOURS_PER_DAY; h++ )
+    {
+        struct hour_sum_t *s = &sums[h];
+        double    hours = s->span_sec / 3600.0;
+
+        if ( s->span_sec == 0 )
+            continue;
+
+        printf( "  %.2d  %5.1f  %9.1f  %9.2f  %7.3f  %7lu  %7lu  %7lu\n",
+                h, hours,
+                s->wakeups / hours,
+                s->awake_sec / hours,
+                100.0 * s->awake_sec / s->span_sec,
+                s->src_tick, s->src_rtc_alarm, s->src_key );
+    }
+
+    printf( "\n  all  %5.1f  %9.1f  %9.2f  %7.3f  %7lu  %7lu  %7lu\n",
+            total.span_sec / 3600.0,
+            total.wakeups / ( total.span_sec / 3600.0 ),
+            total.awake_sec / ( total.span_sec / 3600.0 ),
+            100.0 * total.awake_sec / total.span_sec,
+            total.src_tick, total.src_rtc_alarm, total.src_key );
+
+    // tone sequencer cost, wakes with notes playing against the rest
+    printf( "\nnotes playing  %7lu wakeups  %9.2f ms/wakeup\n",
+            tone_wakeups,
+            tone_wakeups ? 1000.0 * tone_awake_sec / tone_wakeups : 0.0 );
+    printf( "otherwise      %7lu wakeups  %9.2f ms/wakeup\n",
+            total.wakeups - tone_wakeups,
+            total.wakeups > tone_wakeups ?
+            1000.0 * ( total.awake_sec - tone_awake_sec ) /
+            ( total.wakeups - tone_wakeups ) : 0.0 );
+
+    free( abs_sec );
+    free( records );
+
+    return EXIT_SUCCESS;
+}